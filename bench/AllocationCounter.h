@@ -0,0 +1,31 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @file AllocationCounter.h
+ * @brief Global heap allocation counter for benchmark builds
+ *
+ * AllocationCounter.cpp replaces the global operator new/delete and counts
+ * every allocation made by the process. Only link it into benchmark
+ * executables - never into the library itself.
+ */
+
+namespace AllocationCounter {
+
+struct Snapshot {
+    uint64_t allocations;   // Number of operator new calls
+    uint64_t bytes;         // Total bytes requested
+
+    Snapshot() : allocations(0), bytes(0) {}
+};
+
+/**
+ * @brief Read the current process-wide allocation totals
+ */
+Snapshot snapshot();
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATIONCOUNTER_H
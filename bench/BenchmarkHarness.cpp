@@ -0,0 +1,182 @@
+#include "BenchmarkHarness.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Upper bound on iterations per run so very cheap benchmarks terminate
+const int64_t MAX_ITERATIONS = 1000000000LL;
+
+volatile double g_sink = 0.0;
+
+} // namespace
+
+void benchDoNotOptimize(double value)
+{
+    g_sink = g_sink + value;
+}
+
+BenchState::BenchState(int64_t iterations, int64_t arg)
+    : m_iterations(iterations)
+    , m_arg(arg)
+    , m_done(0)
+    , m_itemsProcessed(0)
+    , m_started(false)
+    , m_running(false)
+    , m_elapsedNs(0.0)
+    , m_allocations(0)
+    , m_allocatedBytes(0)
+{
+}
+
+void BenchState::pauseTiming()
+{
+    if (!m_running) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    AllocationCounter::Snapshot allocs = AllocationCounter::snapshot();
+
+    m_elapsedNs += std::chrono::duration<double, std::nano>(now - m_startTime).count();
+    m_allocations += allocs.allocations - m_startAllocs.allocations;
+    m_allocatedBytes += allocs.bytes - m_startAllocs.bytes;
+    m_running = false;
+}
+
+void BenchState::resumeTiming()
+{
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_startAllocs = AllocationCounter::snapshot();
+    m_startTime = Clock::now();
+}
+
+BenchmarkRunner::BenchmarkRunner()
+    : m_minTimeSeconds(0.5)
+    , m_csv(false)
+{
+}
+
+void BenchmarkRunner::add(const std::string& name, BenchFunction fn)
+{
+    Entry entry;
+    entry.name = name;
+    entry.fn = fn;
+    entry.arg = 0;
+    m_entries.push_back(entry);
+}
+
+void BenchmarkRunner::add(const std::string& name, BenchFunction fn, const std::vector<int64_t>& args)
+{
+    for (size_t i = 0; i < args.size(); ++i) {
+        Entry entry;
+        entry.name = name + "/" + std::to_string(args[i]);
+        entry.fn = fn;
+        entry.arg = args[i];
+        m_entries.push_back(entry);
+    }
+}
+
+bool BenchmarkRunner::parseArguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* opt = argv[i];
+        if (std::strncmp(opt, "--filter=", 9) == 0) {
+            m_filter = opt + 9;
+        }
+        else if (std::strncmp(opt, "--min-time=", 11) == 0) {
+            m_minTimeSeconds = std::atof(opt + 11);
+        }
+        else if (std::strcmp(opt, "--csv") == 0) {
+            m_csv = true;
+        }
+        else {
+            std::fprintf(stderr,
+                "Usage: %s [--filter=<substring>] [--min-time=<seconds>] [--csv]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int BenchmarkRunner::runAll()
+{
+    printHeader();
+
+    int count = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        const Entry& entry = m_entries[i];
+        if (!m_filter.empty() && entry.name.find(m_filter) == std::string::npos) {
+            continue;
+        }
+
+        BenchResult result = runOne(entry);
+        m_results.push_back(result);
+        printResult(result);
+        ++count;
+    }
+    return count;
+}
+
+BenchResult BenchmarkRunner::runOne(const Entry& entry)
+{
+    // Double the iteration count until the measured region is long enough
+    int64_t iterations = 1;
+    for (;;) {
+        BenchState state(iterations, entry.arg);
+        entry.fn(state);
+
+        double elapsed = state.elapsedSeconds();
+        if (elapsed >= m_minTimeSeconds || iterations >= MAX_ITERATIONS) {
+            BenchResult result;
+            result.name = entry.name;
+            result.iterations = iterations;
+            result.nsPerOp = elapsed * 1e9 / iterations;
+            result.allocsPerOp = static_cast<double>(state.allocations()) / iterations;
+            result.bytesPerOp = static_cast<double>(state.allocatedBytes()) / iterations;
+            result.itemsPerSecond = (state.itemsProcessed() > 0 && elapsed > 0.0)
+                ? state.itemsProcessed() / elapsed
+                : 0.0;
+            return result;
+        }
+
+        // Jump close to the target once we have a usable estimate
+        int64_t next = iterations * 2;
+        if (elapsed > 0.01) {
+            next = static_cast<int64_t>(iterations * (m_minTimeSeconds / elapsed) * 1.2) + 1;
+        }
+        iterations = next < MAX_ITERATIONS ? next : MAX_ITERATIONS;
+    }
+}
+
+void BenchmarkRunner::printHeader() const
+{
+    if (m_csv) {
+        std::printf("name,iterations,ns_per_op,allocs_per_op,bytes_per_op,items_per_second\n");
+    }
+    else {
+        std::printf("%-44s %12s %14s %10s %12s %14s\n",
+            "Benchmark", "Iterations", "ns/op", "allocs/op", "bytes/op", "items/s");
+        std::printf("%s\n", std::string(111, '-').c_str());
+    }
+}
+
+void BenchmarkRunner::printResult(const BenchResult& r) const
+{
+    if (m_csv) {
+        std::printf("%s,%lld,%.1f,%.2f,%.1f,%.0f\n",
+            r.name.c_str(), static_cast<long long>(r.iterations),
+            r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.itemsPerSecond);
+    }
+    else {
+        std::printf("%-44s %12lld %14.1f %10.2f %12.1f %14.0f\n",
+            r.name.c_str(), static_cast<long long>(r.iterations),
+            r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.itemsPerSecond);
+    }
+    std::fflush(stdout);
+}
@@ -0,0 +1,154 @@
+#ifndef BENCHMARKHARNESS_H
+#define BENCHMARKHARNESS_H
+
+#include "AllocationCounter.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file BenchmarkHarness.h
+ * @brief Minimal Google-benchmark style harness for headless microbenchmarks
+ *
+ * Each benchmark is a function taking a BenchState. Setup goes before the
+ * measured loop, the measured work goes inside it:
+ *
+ *     void BM_Something(BenchState& state) {
+ *         Fixture f(state.arg());
+ *         while (state.keepRunning()) {
+ *             f.doWork();
+ *         }
+ *         state.setItemsProcessed(state.iterations() * f.count());
+ *     }
+ *
+ * The harness doubles the iteration count until a run takes at least the
+ * configured minimum time, then reports ns/op, heap allocations/op, bytes/op
+ * and item throughput for that run.
+ */
+
+class BenchState
+{
+public:
+    BenchState(int64_t iterations, int64_t arg);
+
+    /**
+     * @brief Loop condition for the measured region
+     * Starts the clock on the first call and stops it after the last iteration.
+     */
+    bool keepRunning()
+    {
+        if (!m_started) {
+            m_started = true;
+            resumeTiming();
+        }
+        if (m_done < m_iterations) {
+            ++m_done;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    /**
+     * @brief Exclude per-iteration setup from the measurement
+     */
+    void pauseTiming();
+    void resumeTiming();
+
+    /**
+     * @brief Benchmark argument (entity count, LOD level, ...)
+     */
+    int64_t arg() const { return m_arg; }
+    int64_t iterations() const { return m_iterations; }
+
+    /**
+     * @brief Report item throughput (e.g. entities updated) for this run
+     */
+    void setItemsProcessed(int64_t items) { m_itemsProcessed = items; }
+
+    int64_t itemsProcessed() const { return m_itemsProcessed; }
+    double elapsedSeconds() const { return m_elapsedNs * 1e-9; }
+    uint64_t allocations() const { return m_allocations; }
+    uint64_t allocatedBytes() const { return m_allocatedBytes; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    int64_t m_iterations;
+    int64_t m_arg;
+    int64_t m_done;
+    int64_t m_itemsProcessed;
+    bool m_started;
+    bool m_running;
+
+    Clock::time_point m_startTime;
+    AllocationCounter::Snapshot m_startAllocs;
+
+    double m_elapsedNs;
+    uint64_t m_allocations;
+    uint64_t m_allocatedBytes;
+};
+
+typedef void (*BenchFunction)(BenchState& state);
+
+struct BenchResult {
+    std::string name;
+    int64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    double itemsPerSecond;  // 0 if the benchmark did not report items
+};
+
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner();
+
+    /**
+     * @brief Register a benchmark, optionally once per argument value
+     * The argument is appended to the reported name ("Name/1000").
+     */
+    void add(const std::string& name, BenchFunction fn);
+    void add(const std::string& name, BenchFunction fn, const std::vector<int64_t>& args);
+
+    /**
+     * @brief Parse --filter=<substring>, --min-time=<seconds>, --csv
+     * @return false if an unknown option was given (usage is printed)
+     */
+    bool parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Run all registered benchmarks matching the filter
+     * @return Number of benchmarks run
+     */
+    int runAll();
+
+    const std::vector<BenchResult>& results() const { return m_results; }
+
+private:
+    struct Entry {
+        std::string name;
+        BenchFunction fn;
+        int64_t arg;
+    };
+
+    BenchResult runOne(const Entry& entry);
+    void printHeader() const;
+    void printResult(const BenchResult& result) const;
+
+    std::vector<Entry> m_entries;
+    std::vector<BenchResult> m_results;
+
+    std::string m_filter;
+    double m_minTimeSeconds;
+    bool m_csv;
+};
+
+/**
+ * @brief Keep the optimizer from discarding a benchmarked result
+ */
+void benchDoNotOptimize(double value);
+
+#endif // BENCHMARKHARNESS_H
@@ -0,0 +1,1528 @@
+/**
+ * @file EntityBenchmark.cpp
+ * @brief Headless microbenchmarks for the entity hot paths (entity_bench)
+ *
+ * Runs without a window or GPU: the scene graph is built but never drawn,
+ * and EntityManager gets a free-standing camera looking at the test area.
+ *
+ * Usage:
+ *   entity_bench [--filter=<substring>] [--min-time=<seconds>] [--csv]
+ *   entity_bench --check-zero-alloc
+ *   entity_bench --check-kernels
+ *   entity_bench --check-queries
+ *   entity_bench --check-coverage
+ *   entity_bench --check-replay
+ *   entity_bench --check-snapshot
+ *   entity_bench --check-generator
+ *
+ * --check-zero-alloc runs ingest + updateAll() in steady state and exits
+ * non-zero if either touches the heap. --check-kernels compares the
+ * closed-form math kernels against the OSG reference computations and
+ * exits non-zero on a mismatch. --check-queries compares the spatial
+ * queries (including polytope and view frustum) and pick() of
+ * EntityManager with brute-force scans over the same entities,
+ * --check-coverage the sensor detections with a per-entity reference that
+ * transforms into the sensor frame with osg::Matrixd and uses atan2/asin.
+ * --check-replay records a state stream, reads it back and compares every
+ * batch with what was recorded, also from a log cut off before close().
+ * --check-snapshot saves entities with sensors, track lines, billboards
+ * and quaternion attitudes, restores them into another manager and
+ * compares both, and checks that a damaged snapshot is refused.
+ * --check-generator runs LoadGenerator with churn and salvos on one and
+ * on several threads, and again after reset(), and exits non-zero unless
+ * all runs emit the same states and the population holds its size
+ * within 1%.
+ *
+ * Columns: ns/op, heap allocations/op, bytes/op and items/s (entities or
+ * states processed per second where applicable).
+ */
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <osg/Camera>
+#include <osg/Group>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "BenchmarkHarness.h"
+#include "AttitudeUtils.h"
+#include "EntityManager.h"
+#include "EntityStateRecorder.h"
+#include "EntityStateReplayer.h"
+#include "Geodesy.h"
+#include "LoadGenerator.h"
+#include "MissileModel.h"
+#include "ShipModel.h"
+#include "sensorvolume.h"
+#include "trackline.h"
+
+namespace {
+
+// Test area: East China Sea, camera 1500km above its centre so entities
+// fall into every LOD band (near, mid, far and hidden)
+const double AREA_CENTER_LON = 125.0;
+const double AREA_CENTER_LAT = 30.0;
+const double AREA_SPAN_DEG   = 50.0;
+const double CAMERA_ALTITUDE = 1500000.0;
+
+osg::Camera* createBenchCamera()
+{
+    osg::EllipsoidModel ellipsoid;
+    osg::Vec3d eye;
+    ellipsoid.convertLatLongHeightToXYZ(
+        osg::DegreesToRadians(AREA_CENTER_LAT),
+        osg::DegreesToRadians(AREA_CENTER_LON),
+        CAMERA_ALTITUDE,
+        eye.x(), eye.y(), eye.z());
+
+    osg::Camera* camera = new osg::Camera();
+    camera->setViewMatrixAsLookAt(eye, osg::Vec3d(0, 0, 0), osg::Vec3d(0, 0, 1));
+    return camera;
+}
+
+/**
+ * @brief Deterministic entity states spread over the test area
+ * @param jitter Offset applied to every position/attitude so two sets differ
+ */
+QVector<EntityState> makeStates(int count, double jitter)
+{
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> unit(-0.5, 0.5);
+
+    QVector<EntityState> states;
+    states.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        EntityState s;
+        s.entityId = i;
+        s.type = (i % 2 == 0) ? EntityState::SHIP : EntityState::MISSILE;
+        s.lon = AREA_CENTER_LON + unit(rng) * AREA_SPAN_DEG + jitter;
+        s.lat = AREA_CENTER_LAT + unit(rng) * AREA_SPAN_DEG * 0.5 + jitter;
+        s.alt = (s.type == EntityState::SHIP) ? 0.0 : 10000.0 + jitter * 1000.0;
+        s.heading = 180.0 + unit(rng) * 360.0 + jitter;
+        s.pitch = unit(rng) * 20.0;
+        s.roll = unit(rng) * 10.0;
+        states.append(s);
+    }
+    return states;
+}
+
+/**
+ * @brief EntityManager populated with N entities (no model files, no window)
+ */
+struct ManagerFixture {
+    osg::ref_ptr<osg::Group> root;
+    osg::ref_ptr<GlobalPulseTimeCallback> pulse;
+    osg::ref_ptr<osg::Camera> camera;
+    std::unique_ptr<EntityManager> manager;
+    QVector<EntityState> statesA;
+    QVector<EntityState> statesB;
+
+    explicit ManagerFixture(int count)
+        : root(new osg::Group())
+        , pulse(new GlobalPulseTimeCallback())
+        , camera(createBenchCamera())
+    {
+        manager.reset(new EntityManager(root.get(), pulse.get(), camera.get()));
+
+        statesA = makeStates(count, 0.0);
+        statesB = makeStates(count, 0.01);
+        for (const EntityState& s : statesA) {
+            manager->createEntity(s.entityId, s.type, QString());
+        }
+        manager->updateEntityStates(statesA);
+        manager->updateAll();
+    }
+};
+
+// Fixtures are expensive at 100k entities; build each size once per process
+ManagerFixture& managerFixture(int count)
+{
+    static std::map<int, std::unique_ptr<ManagerFixture>> fixtures;
+    std::unique_ptr<ManagerFixture>& fixture = fixtures[count];
+    if (!fixture) {
+        fixture.reset(new ManagerFixture(count));
+    }
+    return *fixture;
+}
+
+/**
+ * @brief Separate manager with sensors on every tenth ship and coverage enabled
+ * Kept apart from managerFixture() so the other benchmarks and the
+ * zero-allocation check do not pay for coverage.
+ */
+struct CoverageFixture {
+    ManagerFixture base;
+    QVector<int> shipIds;
+
+    explicit CoverageFixture(int count)
+        : base(count)
+    {
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        for (const EntityState& s : base.statesA) {
+            if (s.type != EntityState::SHIP || s.entityId % 20 != 0) {
+                continue;
+            }
+            ShipModel* ship = dynamic_cast<ShipModel*>(base.manager->getEntityObject(s.entityId));
+            if (!ship) {
+                continue;
+            }
+
+            // Mix of narrow, wide (> 180) and full-circle sectors
+            double azimuthStart = unit(rng) * 360.0 - 180.0;
+            double span = (s.entityId % 60 == 0) ? 360.0 : 30.0 + unit(rng) * 300.0;
+            double elevationStart = unit(rng) * 20.0 - 10.0;
+            ship->addFixedWave(new SensorVolume(200000.0 + unit(rng) * 400000.0,
+                                                osg::Vec4(1.0, 0.0, 0.0, 0.3),
+                                                azimuthStart, azimuthStart + span,
+                                                elevationStart, std::min(90.0, elevationStart + 10.0 + unit(rng) * 80.0)));
+            shipIds.append(s.entityId);
+        }
+
+        base.manager->setSensorCoverageEnabled(true);
+        base.manager->updateAll();
+    }
+};
+
+CoverageFixture& coverageFixture(int count)
+{
+    static std::map<int, std::unique_ptr<CoverageFixture>> fixtures;
+    std::unique_ptr<CoverageFixture>& fixture = fixtures[count];
+    if (!fixture) {
+        fixture.reset(new CoverageFixture(count));
+    }
+    return *fixture;
+}
+
+/**
+ * @brief State log of N entities over a number of ingest rounds
+ * Alternates the two state sets of the manager fixture, so replaying it
+ * into that fixture moves every entity in every batch.
+ */
+QString replayLog(int count)
+{
+    const int rounds = 20;
+    static std::map<int, QString> logs;
+    QString& path = logs[count];
+    if (path.isEmpty()) {
+        ManagerFixture& f = managerFixture(count);
+        path = QDir(QDir::tempPath()).filePath(QString("entity_bench_replay_%1.eslog").arg(count));
+
+        EntityStateRecorder recorder;
+        recorder.open(path);
+        for (int i = 0; i < rounds; ++i) {
+            recorder.record((i & 1) ? f.statesA : f.statesB);
+        }
+        recorder.close();
+    }
+    return path;
+}
+
+/**
+ * @brief Snapshot of the N-entity manager fixture
+ */
+QString snapshotFile(int count)
+{
+    static std::map<int, QString> snapshots;
+    QString& path = snapshots[count];
+    if (path.isEmpty()) {
+        path = QDir(QDir::tempPath()).filePath(QString("entity_bench_%1.esnap").arg(count));
+        managerFixture(count).manager->saveSnapshot(path);
+    }
+    return path;
+}
+
+// Expose the protected rebuild entry points for direct measurement
+class BenchSensorVolume : public SensorVolume
+{
+public:
+    BenchSensorVolume()
+        : SensorVolume(300000.0, osg::Vec4(1.0, 0.0, 0.0, 0.3), 0.0, 120.0, 10.0, 90.0)
+    {}
+    using SensorVolume::rebuildGeometry;
+};
+
+class BenchTrackLine : public TrackLine
+{
+public:
+    BenchTrackLine()
+        : TrackLine(1000000.0, 1000.0, osg::Vec4(1.0, 1.0, 0.0, 0.4))
+    {}
+    using TrackLine::rebuildGeometry;
+};
+
+// ---------------------------------------------------------------------------
+// Benchmarks
+// ---------------------------------------------------------------------------
+
+void BM_Object3D_SetPositionUpdateIfDirty(BenchState& state)
+{
+    osg::ref_ptr<ShipModel> ship = new ShipModel(AREA_CENTER_LON, AREA_CENTER_LAT, 0.0, 1.0, QString());
+    ship->updateIfDirty();
+
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        double offset = (i++ & 1) ? 0.001 : 0.0;
+        ship->setPosition(AREA_CENTER_LON + offset, AREA_CENTER_LAT + offset, offset);
+        ship->setAttitude(90.0 + offset, offset, offset);
+        ship->updateIfDirty();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_EntityManager_UpdateAll(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+
+    while (state.keepRunning()) {
+        f.manager->updateAll();
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+}
+
+void BM_EntityManager_UpdateEntityStates(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        // Alternate between two state sets so every update is a real change
+        f.manager->updateEntityStates((i++ & 1) ? f.statesA : f.statesB);
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+}
+
+void BM_SensorVolume_RebuildGeometry(BenchState& state)
+{
+    osg::ref_ptr<BenchSensorVolume> sensor = new BenchSensorVolume();
+    sensor->setLodLevel(static_cast<int>(state.arg()));
+
+    while (state.keepRunning()) {
+        sensor->rebuildGeometry();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_SensorVolume_SetColor(BenchState& state)
+{
+    osg::ref_ptr<SensorVolume> sensor =
+        new SensorVolume(300000.0, osg::Vec4(1.0, 0.0, 0.0, 0.3), 0.0, 120.0, 10.0, 90.0);
+    const osg::Vec4 threat(1.0, 0.0, 0.0, 0.3);
+    const osg::Vec4 neutral(0.0, 1.0, 0.0, 0.3);
+
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        // Recolor by threat state - must not regenerate vertices
+        sensor->setColor((i++ & 1) ? threat : neutral);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_SensorVolume_SetRadius(BenchState& state)
+{
+    osg::ref_ptr<SensorVolume> sensor =
+        new SensorVolume(300000.0, osg::Vec4(1.0, 0.0, 0.0, 0.3), 0.0, 120.0, 10.0, 90.0);
+
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        // Animated range ring - one matrix write per change
+        sensor->setRadius(300000.0 + static_cast<double>(i++ & 1023) * 100.0);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_TrackLine_RebuildGeometry(BenchState& state)
+{
+    osg::ref_ptr<BenchTrackLine> track = new BenchTrackLine();
+    // Start from a different level so setLodLevel() actually switches layers
+    track->setLodLevel(state.arg() == 0 ? 2 : 0);
+    track->setLodLevel(static_cast<int>(state.arg()));
+
+    while (state.keepRunning()) {
+        track->rebuildGeometry();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_AttitudeUtils_EulerToQuat(BenchState& state)
+{
+    double heading = 0.0;
+    while (state.keepRunning()) {
+        heading += 0.1;
+        osg::Quat q = AttitudeUtils::eulerToQuat(heading, 5.0, -3.0);
+        benchDoNotOptimize(q.w());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_AttitudeUtils_RotationScale(BenchState& state)
+{
+    double heading = 0.0;
+    osg::Matrixd m;
+    while (state.keepRunning()) {
+        heading += 0.1;
+        AttitudeUtils::eulerToRotationScale(heading, 5.0, -3.0, 2.0, m);
+        benchDoNotOptimize(m(0, 0));
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_AttitudeUtils_RotationScaleBatch(BenchState& state)
+{
+    const int count = static_cast<int>(state.arg());
+    std::vector<double> heading(count), pitch(count), roll(count), scale(count, 2.0);
+    std::vector<double> out(9 * static_cast<size_t>(count));
+    AttitudeUtils::RotationScaleColumns columns;
+    for (int k = 0; k < 9; ++k) {
+        columns.m[k] = &out[static_cast<size_t>(k) * count];
+    }
+    for (int i = 0; i < count; ++i) {
+        heading[i] = i * 0.37;
+        pitch[i] = (i % 40) - 20.0;
+        roll[i] = (i % 20) - 10.0;
+    }
+
+    while (state.keepRunning()) {
+        AttitudeUtils::eulerToRotationScaleBatch(heading.data(), pitch.data(), roll.data(),
+                                                 scale.data(), count, columns);
+        benchDoNotOptimize(out[0]);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+void BM_EllipsoidModel_LocalToWorld(BenchState& state)
+{
+    osg::ref_ptr<osg::EllipsoidModel> ellipsoid = new osg::EllipsoidModel();
+    osg::Vec3d ecef;
+    osg::Matrixd localToWorld;
+    double lon = AREA_CENTER_LON;
+    while (state.keepRunning()) {
+        lon += 1e-6;
+        ellipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(AREA_CENTER_LAT), osg::DegreesToRadians(lon),
+                                             100.0, ecef.x(), ecef.y(), ecef.z());
+        ellipsoid->computeLocalToWorldTransformFromXYZ(ecef.x(), ecef.y(), ecef.z(), localToWorld);
+        benchDoNotOptimize(localToWorld(3, 0));
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_Geodesy_GeodeticToEcefEnu(BenchState& state)
+{
+    osg::Vec3d ecef;
+    osg::Matrixd localToWorld;
+    double lon = AREA_CENTER_LON;
+    while (state.keepRunning()) {
+        lon += 1e-6;
+        Geodesy::geodeticToEcefEnu(lon, AREA_CENTER_LAT, 100.0, ecef, localToWorld);
+        benchDoNotOptimize(localToWorld(3, 0));
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_Geodesy_EcefToGeodeticBatch(BenchState& state)
+{
+    const int count = static_cast<int>(state.arg());
+    std::vector<T> x(count), y(count), z(count), lon(count), lat(count), alt(count);
+    for (int i = 0; i < count; ++i) {
+        Geodesy::geodeticToEcef(static_cast<T>(AREA_CENTER_LON + (i % 100) * 0.1),
+                                static_cast<T>(AREA_CENTER_LAT + (i / 100 % 100) * 0.1),
+                                static_cast<T>(i % 10000), x[i], y[i], z[i]);
+    }
+
+    while (state.keepRunning()) {
+        Geodesy::ecefToGeodeticBatch(x.data(), y.data(), z.data(), count, lon.data(), lat.data(), alt.data());
+        benchDoNotOptimize(alt[0]);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+
+void BM_EntityManager_QueryRadius(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    QVector<int> ids;
+    ids.reserve(static_cast<int>(state.arg()));
+
+    // 300km around entities spread over the area - a typical sensor range
+    int i = 0;
+    while (state.keepRunning()) {
+        const EntityState& s = f.statesA[i++ % f.statesA.size()];
+        f.manager->queryRadius(s.lon, s.lat, s.alt, 300000.0, ids);
+        benchDoNotOptimize(ids.size());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_EntityManager_QueryNearest(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    QVector<int> ids;
+    ids.reserve(16);
+
+    int i = 0;
+    while (state.keepRunning()) {
+        const EntityState& s = f.statesA[i++ % f.statesA.size()];
+        osg::Vec3d center;
+        Geodesy::geodeticToEcef(s.lon, s.lat, s.alt, center.x(), center.y(), center.z());
+        f.manager->queryNearest(center, 16, ids);
+        benchDoNotOptimize(ids.size());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_EntityManager_Pick(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    QVector<int> ids;
+    ids.reserve(static_cast<int>(state.arg()));
+    osg::Vec3d eye = f.camera->getInverseViewMatrix().getTrans();
+
+    // Rays from the camera through entities, ~4 pixels of tolerance at 1000px/60 degrees
+    int i = 0;
+    while (state.keepRunning()) {
+        Object3D* target = f.manager->getEntityObject(f.statesA[i++ % f.statesA.size()].entityId);
+        f.manager->pick(eye, target->getWorldPosition() - eye, 0.004, ids);
+        benchDoNotOptimize(ids.size());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_EntityManager_SpawnDespawn(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+
+    // A salvo: 64 missiles launched and removed among N live entities;
+    // objects come back from the pool after the first round
+    const int salvo = 64;
+    const int firstId = static_cast<int>(state.arg()) + 1000000;
+    while (state.keepRunning()) {
+        for (int i = 0; i < salvo; ++i) {
+            EntityState s = f.statesA[i % f.statesA.size()];
+            s.entityId = firstId + i;
+            s.type = EntityState::MISSILE;
+            f.manager->createEntity(s.entityId, s.type, QString());
+            f.manager->updateEntityState(s);
+        }
+        for (int i = 0; i < salvo; ++i) {
+            f.manager->removeEntity(firstId + i);
+        }
+    }
+    state.setItemsProcessed(state.iterations() * salvo);
+}
+
+/**
+ * @brief Scenario load into an empty manager, one createEntity() and
+ * updateEntityState() per entity, then cleared for the next round
+ */
+void BM_EntityManager_CreateEntityLoop(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    ManagerFixture target(0);
+
+    while (state.keepRunning()) {
+        for (const EntityState& s : f.statesA) {
+            target.manager->createEntity(s.entityId, s.type, QString());
+            target.manager->updateEntityState(s);
+        }
+        target.manager->clearAllEntities();
+    }
+    state.setItemsProcessed(state.iterations() * f.statesA.size());
+}
+
+/**
+ * @brief The same load through createEntities()
+ */
+void BM_EntityManager_CreateEntities(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    ManagerFixture target(0);
+
+    QVector<EntitySpec> specs(f.statesA.size());
+    for (int i = 0; i < specs.size(); ++i) {
+        specs[i].state = f.statesA[i];
+    }
+
+    while (state.keepRunning()) {
+        benchDoNotOptimize(target.manager->createEntities(specs));
+        target.manager->clearAllEntities();
+    }
+    state.setItemsProcessed(state.iterations() * specs.size());
+}
+
+void BM_EntityManager_SensorCoverage(BenchState& state)
+{
+    CoverageFixture& f = coverageFixture(static_cast<int>(state.arg()));
+
+    // Alternate state sets so detection sets really change between ticks
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        const QVector<EntityState>& states = (i++ & 1) ? f.base.statesA : f.base.statesB;
+        f.base.manager->updateEntityStates(states.constData(), states.size());
+        f.base.manager->updateAll();
+    }
+    state.setItemsProcessed(state.iterations() * f.shipIds.size());
+}
+
+void BM_EntityStateReplayer_ReplayAll(BenchState& state)
+{
+    ManagerFixture& f = managerFixture(static_cast<int>(state.arg()));
+    EntityStateReplayer replayer(f.manager.get());
+    replayer.open(replayLog(static_cast<int>(state.arg())));
+
+    // Decode from the mapped log plus ingest, as fast as possible
+    while (state.keepRunning()) {
+        replayer.seek(0);
+        benchDoNotOptimize(replayer.replayAll());
+    }
+    state.setItemsProcessed(state.iterations() * replayer.stateCount());
+}
+
+void BM_EntityManager_RestoreSnapshot(BenchState& state)
+{
+    const QString path = snapshotFile(static_cast<int>(state.arg()));
+    ManagerFixture target(0);
+
+    // Warm start: replaces every entity of the target each round
+    while (state.keepRunning()) {
+        benchDoNotOptimize(target.manager->restoreSnapshot(path));
+    }
+    state.setItemsProcessed(state.iterations() * state.arg());
+}
+
+/**
+ * @brief Generator alone, every entity due each step (10 Hz at dt = 0.1 s)
+ */
+void BM_LoadGenerator_Step(BenchState& state)
+{
+    LoadGenerator::Config config;
+    config.entityCount = static_cast<int>(state.arg());
+    config.rateDistribution = LoadGenerator::RATE_FIXED;
+    config.maxUpdateRate = 10.0;
+    config.ballisticWeight = 0.0;
+    LoadGenerator generator(config);
+    generator.step(0.1);
+
+    int64_t states = 0;
+    while (state.keepRunning()) {
+        states += generator.step(0.1);
+    }
+    state.setItemsProcessed(states);
+}
+
+/**
+ * @brief Generated feed with churn and salvos into a manager, as
+ * DdsDataSimulator drives it, plus updateAll() per step
+ */
+void BM_LoadGenerator_Ingest(BenchState& state)
+{
+    ManagerFixture target(0);
+    LoadGenerator::Config config;
+    config.entityCount = static_cast<int>(state.arg());
+    config.churnRate = 0.02;
+    config.salvoRate = 0.2;
+    LoadGenerator generator(config);
+
+    int64_t states = 0;
+    while (state.keepRunning()) {
+        generator.step(0.1);
+        target.manager->createEntities(generator.spawned());
+        target.manager->updateEntityStates(generator.states());
+        for (int entityId : generator.despawned()) {
+            target.manager->removeEntity(entityId);
+        }
+        target.manager->updateAll();
+        states += generator.states().size() + generator.spawned().size();
+    }
+    state.setItemsProcessed(states);
+}
+
+// ---------------------------------------------------------------------------
+// Kernel validation
+// ---------------------------------------------------------------------------
+
+double maxRotationError(const osg::Matrixd& a, const osg::Matrixd& b)
+{
+    double error = 0.0;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            error = std::max(error, std::abs(a(r, c) - b(r, c)));
+        }
+    }
+    return error;
+}
+
+/**
+ * @brief Attitude kernels against scale * createRotationMatrix()
+ */
+bool checkAttitudeKernels(int samples)
+{
+    std::mt19937 rng(4242);
+    std::uniform_real_distribution<double> angle(-180.0, 180.0);
+    std::uniform_real_distribution<double> pitchAngle(-89.0, 89.0);
+    std::uniform_real_distribution<double> scaleFactor(0.1, 10.0);
+
+    double eulerError = 0.0;
+    double quatError = 0.0;
+    double batchError = 0.0;
+
+    std::vector<double> heading(samples), pitch(samples), roll(samples), scale(samples);
+    std::vector<double> out(9 * static_cast<size_t>(samples));
+    AttitudeUtils::RotationScaleColumns columns;
+    for (int k = 0; k < 9; ++k) {
+        columns.m[k] = &out[static_cast<size_t>(k) * samples];
+    }
+
+    for (int i = 0; i < samples; ++i) {
+        heading[i] = angle(rng);
+        pitch[i] = pitchAngle(rng);
+        roll[i] = angle(rng);
+        scale[i] = scaleFactor(rng);
+
+        // Reference: quaternion round trip and two 4x4 multiplies
+        osg::Matrixd reference = osg::Matrixd::scale(scale[i], scale[i], scale[i])
+            * AttitudeUtils::createRotationMatrix(heading[i], pitch[i], roll[i]);
+
+        osg::Matrixd m;
+        AttitudeUtils::eulerToRotationScale(heading[i], pitch[i], roll[i], scale[i], m);
+        eulerError = std::max(eulerError, maxRotationError(m, reference) / scale[i]);
+
+        osg::Quat q = AttitudeUtils::eulerToQuat(heading[i], pitch[i], roll[i]);
+        AttitudeUtils::quatToRotationScale(q, scale[i], m);
+        quatError = std::max(quatError, maxRotationError(m, reference) / scale[i]);
+    }
+
+    AttitudeUtils::eulerToRotationScaleBatch(heading.data(), pitch.data(), roll.data(),
+                                             scale.data(), samples, columns);
+    for (int i = 0; i < samples; ++i) {
+        osg::Matrixd m;
+        AttitudeUtils::eulerToRotationScale(heading[i], pitch[i], roll[i], scale[i], m);
+        for (int k = 0; k < 9; ++k) {
+            batchError = std::max(batchError, std::abs(columns.m[k][i] - m(k / 3, k % 3)) / scale[i]);
+        }
+    }
+
+    const double tolerance = 1e-12;
+    std::printf("eulerToRotationScale          max error %.3g\n", eulerError);
+    std::printf("quatToRotationScale           max error %.3g\n", quatError);
+    std::printf("eulerToRotationScaleBatch     max error %.3g\n", batchError);
+    return eulerError < tolerance && quatError < tolerance && batchError < tolerance;
+}
+
+/**
+ * @brief Geodesy kernels against osg::EllipsoidModel
+ */
+bool checkGeodesyKernels(int samples)
+{
+    std::mt19937 rng(4243);
+    std::uniform_real_distribution<double> lonDist(-180.0, 180.0);
+    std::uniform_real_distribution<double> latDist(-90.0, 90.0);
+    std::uniform_real_distribution<double> altDist(-1000.0, 2000000.0);
+
+    osg::ref_ptr<osg::EllipsoidModel> ellipsoid = new osg::EllipsoidModel();
+
+    double ecefError = 0.0;          // m
+    double frameError = 0.0;         // Matrix elements (unitless rows)
+    double inverseAngleError = 0.0;  // deg
+    double inverseAltError = 0.0;    // m
+    double floatError = 0.0;         // m, float ECEF vs double
+
+    for (int i = 0; i < samples; ++i) {
+        const double lon = lonDist(rng);
+        const double lat = latDist(rng);
+        const double alt = altDist(rng);
+
+        // Reference: forward conversion plus the frame from XYZ (which
+        // converts back internally)
+        osg::Vec3d reference;
+        ellipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians(lat), osg::DegreesToRadians(lon), alt,
+                                             reference.x(), reference.y(), reference.z());
+        osg::Matrixd referenceFrame;
+        ellipsoid->computeLocalToWorldTransformFromXYZ(reference.x(), reference.y(), reference.z(),
+                                                       referenceFrame);
+
+        osg::Vec3d ecef;
+        osg::Matrixd frame;
+        Geodesy::geodeticToEcefEnu(lon, lat, alt, ecef, frame);
+        ecefError = std::max(ecefError, (ecef - reference).length());
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                frameError = std::max(frameError, std::abs(frame(r, c) - referenceFrame(r, c)));
+            }
+        }
+
+        double lonOut, latOut, altOut;
+        Geodesy::ecefToGeodetic(ecef.x(), ecef.y(), ecef.z(), lonOut, latOut, altOut);
+        double lonDelta = std::abs(AttitudeUtils::angleDifference(lonOut, lon));
+        inverseAngleError = std::max(inverseAngleError, std::abs(latOut - lat));
+        if (std::abs(lat) < 89.99) {
+            // Longitude is undefined at the poles
+            inverseAngleError = std::max(inverseAngleError, lonDelta);
+        }
+        inverseAltError = std::max(inverseAltError, std::abs(altOut - alt));
+
+        float fx, fy, fz;
+        Geodesy::geodeticToEcef(static_cast<float>(lon), static_cast<float>(lat), static_cast<float>(alt),
+                                fx, fy, fz);
+        floatError = std::max(floatError, (osg::Vec3d(fx, fy, fz) - ecef).length());
+    }
+
+    std::printf("geodeticToEcefEnu position    max error %.3g m\n", ecefError);
+    std::printf("geodeticToEcefEnu frame       max error %.3g\n", frameError);
+    std::printf("ecefToGeodetic angles         max error %.3g deg\n", inverseAngleError);
+    std::printf("ecefToGeodetic altitude       max error %.3g m\n", inverseAltError);
+    std::printf("geodeticToEcef<float>         max error %.3g m\n", floatError);
+
+    // Float is reported, not enforced - its resolution is ~0.5m by design.
+    // The reference frame comes from OSG's one-step Bowring inverse, which
+    // is itself only accurate to ~1e-8 rad at high altitude.
+    return ecefError < 1e-6 && frameError < 1e-7
+        && inverseAngleError < 1e-9 && inverseAltError < 1e-4;
+}
+
+/**
+ * @brief Compare the closed-form kernels with the OSG reference paths
+ * @return Process exit code (0 = all within tolerance)
+ */
+int checkKernels()
+{
+    const int samples = 10000;
+    bool ok = checkAttitudeKernels(samples);
+    ok = checkGeodesyKernels(samples) && ok;
+    std::printf("Kernels (%d samples each) - %s\n", samples, ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Spatial query validation
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Compare EntityManager's grid queries with brute-force scans
+ * @return Process exit code (0 = identical results)
+ */
+int checkQueries()
+{
+    const int entityCount = 10000;
+    const int probes = 200;
+    ManagerFixture& f = managerFixture(entityCount);
+
+    // Reference positions, computed the same way Object3D does
+    std::vector<osg::Vec3d> ecef(entityCount);
+    for (const EntityState& s : f.statesA) {
+        osg::Vec3d& p = ecef[s.entityId];
+        Geodesy::geodeticToEcef(s.lon, s.lat, s.alt, p.x(), p.y(), p.z());
+    }
+
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<double> unit(-0.5, 0.5);
+    std::uniform_real_distribution<double> range(10000.0, 2000000.0);
+    QVector<int> ids;
+    std::vector<int> expected;
+    std::vector<std::pair<double, int>> byDistance;
+    int failures = 0;
+
+    auto sameSet = [&](QVector<int> actual) {
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+        return actual.size() == static_cast<int>(expected.size())
+            && std::equal(expected.begin(), expected.end(), actual.begin());
+    };
+
+    for (int i = 0; i < probes; ++i) {
+        double lon = AREA_CENTER_LON + unit(rng) * AREA_SPAN_DEG;
+        double lat = AREA_CENTER_LAT + unit(rng) * AREA_SPAN_DEG * 0.5;
+        double radius = range(rng);
+        osg::Vec3d center;
+        Geodesy::geodeticToEcef(lon, lat, 0.0, center.x(), center.y(), center.z());
+
+        // Radius
+        expected.clear();
+        for (int id = 0; id < entityCount; ++id) {
+            if ((ecef[id] - center).length2() <= radius * radius) {
+                expected.push_back(id);
+            }
+        }
+        f.manager->queryRadius(center, radius, ids);
+        failures += sameSet(ids) ? 0 : 1;
+
+        // Box
+        osg::Vec3d extent(radius, radius * 0.5, radius * 0.25);
+        expected.clear();
+        for (int id = 0; id < entityCount; ++id) {
+            osg::Vec3d d = ecef[id] - center;
+            if (std::abs(d.x()) <= extent.x() && std::abs(d.y()) <= extent.y() && std::abs(d.z()) <= extent.z()) {
+                expected.push_back(id);
+            }
+        }
+        f.manager->queryBox(center - extent, center + extent, ids);
+        failures += sameSet(ids) ? 0 : 1;
+
+        // Geodetic box, every other probe with the missiles' altitude
+        double halfSpan = radius / 200000.0;
+        double maxAlt = i % 2 == 0 ? 5000.0 : 20000.0;
+        expected.clear();
+        for (const EntityState& s : f.statesA) {
+            if (std::abs(s.lon - lon) <= halfSpan && std::abs(s.lat - lat) <= halfSpan && s.alt <= maxAlt) {
+                expected.push_back(s.entityId);
+            }
+        }
+        f.manager->queryGeodeticBox(lon - halfSpan, lon + halfSpan, lat - halfSpan, lat + halfSpan,
+                                    -1000.0, maxAlt, ids);
+        failures += sameSet(ids) ? 0 : 1;
+
+        // Nearest - compare distances, ties may order differently
+        const int k = 1 + i % 32;
+        byDistance.clear();
+        for (int id = 0; id < entityCount; ++id) {
+            byDistance.push_back(std::make_pair((ecef[id] - center).length2(), id));
+        }
+        std::partial_sort(byDistance.begin(), byDistance.begin() + k, byDistance.end());
+        f.manager->queryNearest(center, k, ids);
+        bool nearestOk = ids.size() == k;
+        for (int j = 0; nearestOk && j < k; ++j) {
+            nearestOk = (ecef[ids[j]] - center).length2() == byDistance[j].first;
+        }
+        failures += nearestOk ? 0 : 1;
+
+        // Pick ray from above the probe point - no models, so sphere order
+        const double tanTolerance = 0.002 * (i % 4);
+        osg::Vec3d rayOrigin = center * 1.3;
+        osg::Vec3d rayDirection = center - rayOrigin;
+        rayDirection.normalize();
+        byDistance.clear();
+        for (int id = 0; id < entityCount; ++id) {
+            osg::Vec3d d = ecef[id] - rayOrigin;
+            double t = d * rayDirection;
+            double tc = std::max(t, 0.0);
+            double hitRadius = tc * tanTolerance;
+            if (t >= 0.0 && (d - rayDirection * tc).length2() <= hitRadius * hitRadius) {
+                byDistance.push_back(std::make_pair(t, id));
+            }
+        }
+        std::sort(byDistance.begin(), byDistance.end());
+        f.manager->pick(rayOrigin, rayDirection, tanTolerance, ids);
+        bool pickOk = ids.size() == static_cast<int>(byDistance.size());
+        for (int j = 0; pickOk && j < ids.size(); ++j) {
+            pickOk = ids[j] == byDistance[j].second;
+        }
+        failures += pickOk ? 0 : 1;
+
+        // Polytope and view frustum - a camera radius meters above the
+        // probe point looking down, checked in clip space
+        osg::Matrixd view = osg::Matrixd::lookAt(center * (1.0 + radius / center.length()), center,
+                                                 osg::Vec3d(0.0, 0.0, 1.0));
+        osg::Matrixd projection = osg::Matrixd::perspective(10.0 + 5.0 * (i % 8), 1.0 + 0.25 * (i % 3),
+                                                            1000.0, 2.0 * radius);
+        osg::Matrixd viewProjection = view * projection;
+        expected.clear();
+        for (int id = 0; id < entityCount; ++id) {
+            osg::Vec4d clip = osg::Vec4d(ecef[id], 1.0) * viewProjection;
+            if (std::abs(clip.x()) <= clip.w() && std::abs(clip.y()) <= clip.w() && std::abs(clip.z()) <= clip.w()) {
+                expected.push_back(id);
+            }
+        }
+        osg::Polytope frustum;
+        frustum.setToUnitFrustum();
+        frustum.transformProvidingInverse(viewProjection);
+        f.manager->queryPolytope(frustum, ids);
+        failures += sameSet(ids) ? 0 : 1;
+
+        f.camera->setViewMatrix(view);
+        f.camera->setProjectionMatrix(projection);
+        f.manager->queryViewFrustum(ids);
+        failures += sameSet(ids) ? 0 : 1;
+    }
+
+    std::printf("Spatial queries, %d entities, %d probes x 7 query types: %d mismatches - %s\n",
+                entityCount, probes, failures, failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Sensor coverage validation
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Reference sector test: full inverse transform and atan2/asin
+ * Points within 1e-6 of a sector boundary are reported as ambiguous.
+ */
+bool referenceInside(const osg::Matrixd& worldToBody, const SensorVolume& sensor,
+                     const osg::Vec3d& target, bool& ambiguous)
+{
+    const double tolerance = 1e-6;
+    osg::Vec3d body = target * worldToBody;
+    double r = body.length();
+    double azimuth = osg::RadiansToDegrees(std::atan2(body.x(), body.y()));
+    double elevation = r > 0.0 ? osg::RadiansToDegrees(std::asin(body.z() / r)) : 0.0;
+
+    // Azimuth relative to the start, in [0, 360)
+    double relative = std::fmod(azimuth - sensor.getAzimuthStart(), 360.0);
+    if (relative < 0.0) {
+        relative += 360.0;
+    }
+    double span = sensor.getAzimuthEnd() - sensor.getAzimuthStart();
+
+    double rangeMargin = sensor.getRadius() - r;
+    double elevationMargin = std::min(elevation - sensor.getElevationStart(),
+                                      sensor.getElevationEnd() - elevation);
+    double azimuthMargin = span >= 360.0 ? 1.0 : std::min(std::min(relative, 360.0 - relative),
+                                                          std::abs(span - relative));
+    ambiguous = std::abs(rangeMargin) < tolerance * sensor.getRadius()
+             || std::abs(elevationMargin) < tolerance
+             || azimuthMargin < tolerance;
+
+    return rangeMargin >= 0.0 && elevationMargin >= 0.0 && (span >= 360.0 || relative <= span);
+}
+
+/**
+ * @brief Compare EntityManager's sensor detections with referenceInside()
+ * @return Process exit code (0 = identical apart from boundary cases)
+ */
+int checkCoverage()
+{
+    const int entityCount = 10000;
+    CoverageFixture& f = coverageFixture(entityCount);
+    EntityManager& manager = *f.base.manager;
+
+    QVector<int> detected;
+    std::vector<int> expected;
+    int mismatches = 0;
+    int total = 0;
+
+    for (int shipId : f.shipIds) {
+        ShipModel* ship = dynamic_cast<ShipModel*>(manager.getEntityObject(shipId));
+        osg::Matrixd worldToBody = osg::Matrixd::inverse(ship->getLocalMatrix() * ship->getLocalToWorld());
+        const SensorVolume& sensor = *ship->getSensorVolumes()[0];
+
+        expected.clear();
+        std::vector<int> ambiguousIds;
+        for (const EntityState& s : f.base.statesA) {
+            if (s.entityId == shipId) {
+                continue;
+            }
+            bool ambiguous = false;
+            bool inside = referenceInside(worldToBody, sensor,
+                                          manager.getEntityObject(s.entityId)->getWorldPosition(), ambiguous);
+            if (ambiguous) {
+                ambiguousIds.push_back(s.entityId);
+            } else if (inside) {
+                expected.push_back(s.entityId);
+            }
+        }
+
+        manager.getSensorDetections(shipId, 0, detected);
+        std::vector<int> actual;
+        for (int id : detected) {
+            if (std::find(ambiguousIds.begin(), ambiguousIds.end(), id) == ambiguousIds.end()) {
+                actual.push_back(id);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        mismatches += (actual == expected) ? 0 : 1;
+        total += static_cast<int>(expected.size());
+    }
+
+    std::printf("Sensor coverage, %d entities, %d sensors, %d detections: %d mismatching sensors - %s\n",
+                entityCount, f.shipIds.size(), total, mismatches, mismatches == 0 ? "OK" : "FAILED");
+    return mismatches == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Record/replay validation
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Read a log back and compare it with the recorded batches
+ * A batch that was split over two chunks comes back as two parts; each
+ * part must continue the recorded batch where the previous one stopped.
+ * @return Number of mismatching batches (missing or extra ones included)
+ */
+int compareReplay(const QString& path, const std::vector<QVector<EntityState>>& recorded)
+{
+    // Quantization steps of EntityStateLog, with margin for rounding
+    const double angleTolerance = 1e-7;
+    const double altitudeTolerance = 1e-3;
+    const double attitudeTolerance = 1e-4;
+    const double quaternionTolerance = 1e-8;
+
+    EntityStateReplayer replayer(nullptr);
+    if (!replayer.open(path)) {
+        return static_cast<int>(recorded.size());
+    }
+
+    int mismatches = 0;
+    size_t batch = 0;
+    int offset = 0;
+    const EntityState* states;
+    int count;
+    while ((count = replayer.nextBatch(states)) > 0) {
+        if (batch == recorded.size() || offset + count > recorded[batch].size()) {
+            return mismatches + 1;
+        }
+        bool same = true;
+        for (int i = 0; i < count; ++i) {
+            const EntityState& a = recorded[batch][offset + i];
+            const EntityState& b = states[i];
+            same = same && a.entityId == b.entityId && a.type == b.type
+                && a.hasQuaternion == b.hasQuaternion && a.timestamp == b.timestamp
+                && std::fabs(a.lon - b.lon) <= angleTolerance && std::fabs(a.lat - b.lat) <= angleTolerance
+                && std::fabs(a.alt - b.alt) <= altitudeTolerance
+                && std::fabs(a.heading - b.heading) <= attitudeTolerance
+                && std::fabs(a.pitch - b.pitch) <= attitudeTolerance
+                && std::fabs(a.roll - b.roll) <= attitudeTolerance;
+            if (a.hasQuaternion) {
+                same = same && std::fabs(a.qx - b.qx) <= quaternionTolerance
+                    && std::fabs(a.qy - b.qy) <= quaternionTolerance
+                    && std::fabs(a.qz - b.qz) <= quaternionTolerance
+                    && std::fabs(a.qw - b.qw) <= quaternionTolerance;
+            }
+        }
+        mismatches += same ? 0 : 1;
+
+        offset += count;
+        if (offset == recorded[batch].size()) {
+            ++batch;
+            offset = 0;
+        }
+    }
+    return mismatches + static_cast<int>(recorded.size() - batch);
+}
+
+/**
+ * @brief Record batches of varying size and read them back
+ * @return Process exit code (0 = every batch came back)
+ */
+int checkReplay()
+{
+    const int entityCount = 2000;
+    const int rounds = 30;
+    // Small chunks so batches straddle chunk boundaries
+    const int chunkStates = 1500;
+
+    // Batches of a few hundred states, every third entity with a quaternion
+    std::mt19937 rng(4242);
+    std::uniform_int_distribution<int> batchSize(1, 700);
+    std::vector<QVector<EntityState>> recorded;
+    for (int round = 0; round < rounds; ++round) {
+        QVector<EntityState> states = makeStates(entityCount, round * 0.001);
+        for (int i = 0; i < states.size(); ++i) {
+            EntityState& s = states[i];
+            s.timestamp = 1700000000000LL + round * 100 + i;
+            if (i % 3 == 0) {
+                osg::Quat q = AttitudeUtils::eulerToQuat(s.heading, s.pitch, s.roll);
+                s.hasQuaternion = true;
+                s.qx = q.x();
+                s.qy = q.y();
+                s.qz = q.z();
+                s.qw = q.w();
+            }
+        }
+        for (int begin = 0; begin < states.size(); ) {
+            const int count = std::min(batchSize(rng), states.size() - begin);
+            recorded.push_back(states.mid(begin, count));
+            begin += count;
+        }
+    }
+
+    const QString path = QDir(QDir::tempPath()).filePath("entity_bench_check.eslog");
+    EntityStateRecorder recorder(chunkStates);
+    recorder.open(path);
+    for (const QVector<EntityState>& batch : recorded) {
+        recorder.record(batch);
+    }
+    const bool closed = recorder.close();
+    const int mismatches = compareReplay(path, recorded);
+
+    // Cut into the last chunk as a crash would: no index, and the torn
+    // chunk is dropped, so the log ends with the last complete chunk
+    const QString cutPath = QDir(QDir::tempPath()).filePath("entity_bench_check_cut.eslog");
+    QFile::remove(cutPath);
+    QFile::copy(path, cutPath);
+    QFile cut(cutPath);
+    uchar trailer[EntityStateLog::TRAILER_SIZE];
+    if (cut.open(QIODevice::ReadWrite) && cut.seek(cut.size() - EntityStateLog::TRAILER_SIZE)) {
+        cut.read(reinterpret_cast<char*>(trailer), EntityStateLog::TRAILER_SIZE);
+        cut.resize(EntityStateLog::getI64(trailer) - 10);
+    }
+    cut.close();
+
+    // Expected: all complete chunks, ending in part of a batch if one straddles the cut
+    const int totalStates = entityCount * rounds;
+    const int keptStates = ((totalStates - 1) / chunkStates) * chunkStates;
+    std::vector<QVector<EntityState>> kept;
+    for (int states = 0; states < keptStates; states += kept.back().size()) {
+        kept.push_back(recorded[kept.size()].mid(0, keptStates - states));
+    }
+    const int cutMismatches = compareReplay(cutPath, kept);
+
+    QFile::remove(path);
+    QFile::remove(cutPath);
+
+    const bool ok = closed && mismatches == 0 && cutMismatches == 0;
+    std::printf("Record/replay, %d batches, %d states: %d mismatching batches, %d after a cut - %s\n",
+                static_cast<int>(recorded.size()), totalStates, mismatches, cutMismatches,
+                ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Snapshot validation
+// ---------------------------------------------------------------------------
+
+bool sameObject(const Object3D& a, const Object3D& b)
+{
+    const double tolerance = 1e-9;
+    if ((a.getPosition() - b.getPosition()).length() > tolerance
+        || a.isQuaternionAttitude() != b.isQuaternionAttitude()
+        || a.getScale() != b.getScale() || a.isVisible() != b.isVisible()
+        || a.getLODNearDistance() != b.getLODNearDistance()
+        || a.getBillboardImage() != b.getBillboardImage()
+        || a.getBillboardWidth() != b.getBillboardWidth()
+        || a.getBillboardHeight() != b.getBillboardHeight()) {
+        return false;
+    }
+    if (a.isQuaternionAttitude() ? !(a.getAttitudeQuat() == b.getAttitudeQuat())
+                                 : (a.getAttitude() - b.getAttitude()).length() > tolerance) {
+        return false;
+    }
+
+    const ShipModel* shipA = dynamic_cast<const ShipModel*>(&a);
+    const ShipModel* shipB = dynamic_cast<const ShipModel*>(&b);
+    if (shipA && shipB) {
+        if (shipA->getSensorVolumes().size() != shipB->getSensorVolumes().size()) {
+            return false;
+        }
+        for (int i = 0; i < shipA->getSensorVolumes().size(); ++i) {
+            const SensorVolume& x = *shipA->getSensorVolumes()[i];
+            const SensorVolume& y = *shipB->getSensorVolumes()[i];
+            if (x.getRadius() != y.getRadius() || x.getColor() != y.getColor()
+                || x.getAzimuthStart() != y.getAzimuthStart() || x.getAzimuthEnd() != y.getAzimuthEnd()
+                || x.getElevationStart() != y.getElevationStart() || x.getElevationEnd() != y.getElevationEnd()
+                || x.getLodLevel() != y.getLodLevel() || x.isVisible() != y.isVisible()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const MissileModel* missileA = dynamic_cast<const MissileModel*>(&a);
+    const MissileModel* missileB = dynamic_cast<const MissileModel*>(&b);
+    if (missileA && missileB) {
+        if (missileA->getTrackLines().size() != missileB->getTrackLines().size()) {
+            return false;
+        }
+        for (int i = 0; i < missileA->getTrackLines().size(); ++i) {
+            const TrackLine& x = *missileA->getTrackLines()[i];
+            const TrackLine& y = *missileB->getTrackLines()[i];
+            if (x.getLength() != y.getLength() || x.getRadius() != y.getRadius()
+                || x.getColor() != y.getColor() || x.getWidth() != y.getWidth()
+                || x.getSpeed() != y.getSpeed()
+                || x.getLodLevel() != y.getLodLevel() || x.isVisible() != y.isVisible()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Save a decorated manager, restore it elsewhere and compare
+ * @return Process exit code (0 = identical entities, damaged file refused)
+ */
+int checkSnapshot()
+{
+    const int entityCount = 20000;
+    ManagerFixture source(entityCount);
+    EntityManager& manager = *source.manager;
+
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (const EntityState& s : source.statesA) {
+        Object3D* object = manager.getEntityObject(s.entityId);
+        if (s.entityId % 7 == 0) {
+            object->setAttitude(AttitudeUtils::eulerToQuat(s.heading, s.pitch, s.roll));
+        }
+        if (s.entityId % 13 == 0) {
+            object->setScale(0.5 + unit(rng) * 3.0);
+        }
+        if (s.entityId % 17 == 0) {
+            object->setVisible(false);
+        }
+        if (s.entityId % 50 == 0) {
+            object->setLODDistances(100000.0 + unit(rng) * 900000.0, 0.0);
+            object->setBillboardImage(QString("icons/track_%1.png").arg(s.entityId % 3),
+                                      20000.0 + unit(rng) * 80000.0, 20000.0);
+        }
+
+        if (ShipModel* ship = dynamic_cast<ShipModel*>(object)) {
+            for (int i = 0; i < s.entityId % 3; ++i) {
+                const double azimuthStart = unit(rng) * 360.0 - 180.0;
+                SensorVolume* sensor = new SensorVolume(100000.0 + unit(rng) * 500000.0,
+                                                        osg::Vec4(unit(rng), unit(rng), 0.0, 0.3),
+                                                        azimuthStart, azimuthStart + 30.0 + unit(rng) * 300.0,
+                                                        0.0, 10.0 + unit(rng) * 80.0);
+                sensor->setLodLevel(i);
+                sensor->setVisible(i == 0);
+                ship->addFixedWave(sensor);
+            }
+        }
+        else if (MissileModel* missile = dynamic_cast<MissileModel*>(object)) {
+            if (s.entityId % 4 == 1) {
+                TrackLine* trackLine = new TrackLine(200000.0 + unit(rng) * 800000.0, 500.0 + unit(rng) * 1500.0,
+                                                     osg::Vec4(1.0, unit(rng), 0.0, 0.4),
+                                                     2.0 + unit(rng) * 4.0, 0.5 + unit(rng));
+                trackLine->setLodLevel(s.entityId % 3);
+                missile->addRadarTrackLine(trackLine);
+            }
+        }
+    }
+
+    const QString path = QDir(QDir::tempPath()).filePath("entity_bench_check.esnap");
+    const bool saved = manager.saveSnapshot(path);
+
+    ManagerFixture target(0);
+    const auto start = std::chrono::steady_clock::now();
+    const bool restored = target.manager->restoreSnapshot(path);
+    const double restoreMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int mismatches = 0;
+    for (const EntityState& s : source.statesA) {
+        const Object3D* original = manager.getEntityObject(s.entityId);
+        const Object3D* copy = target.manager->getEntityObject(s.entityId);
+        mismatches += (copy && sameObject(*original, *copy)) ? 0 : 1;
+    }
+    mismatches += std::abs(target.manager->getEntityCount() - entityCount);
+
+    // Cut off inside the entity table: refused, and the restored entities stay
+    const QString cutPath = QDir(QDir::tempPath()).filePath("entity_bench_check_cut.esnap");
+    QFile::remove(cutPath);
+    QFile::copy(path, cutPath);
+    QFile cut(cutPath);
+    if (cut.open(QIODevice::ReadWrite)) {
+        cut.resize(cut.size() / 2);
+    }
+    cut.close();
+    const bool refused = !target.manager->restoreSnapshot(cutPath)
+        && target.manager->getEntityCount() == entityCount;
+
+    QFile::remove(path);
+    QFile::remove(cutPath);
+
+    const bool ok = saved && restored && mismatches == 0 && refused;
+    std::printf("Snapshot, %d entities: restored in %.1f ms, %d mismatching, damaged file %s - %s\n",
+                entityCount, restoreMs, mismatches, refused ? "refused" : "accepted",
+                ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Load generator validation
+// ---------------------------------------------------------------------------
+
+bool sameStates(const QVector<EntityState>& a, const QVector<EntityState>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].entityId != b[i].entityId || a[i].type != b[i].type
+            || a[i].lon != b[i].lon || a[i].lat != b[i].lat || a[i].alt != b[i].alt
+            || a[i].heading != b[i].heading || a[i].pitch != b[i].pitch || a[i].roll != b[i].roll
+            || a[i].timestamp != b[i].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameStep(const LoadGenerator& a, const LoadGenerator& b)
+{
+    if (!sameStates(a.states(), b.states()) || a.despawned() != b.despawned()
+        || a.spawned().size() != b.spawned().size()) {
+        return false;
+    }
+    QVector<EntityState> spawnedA;
+    QVector<EntityState> spawnedB;
+    for (int i = 0; i < a.spawned().size(); ++i) {
+        spawnedA.append(a.spawned()[i].state);
+        spawnedB.append(b.spawned()[i].state);
+    }
+    return sameStates(spawnedA, spawnedB);
+}
+
+/**
+ * @brief Same seed on one thread, several threads and after reset()
+ * @return Process exit code (0 = identical runs, population held)
+ */
+int checkGenerator()
+{
+    const int entityCount = 20000;
+    const int steps = 600;
+    const double dt = 0.1;
+
+    LoadGenerator::Config config;
+    config.entityCount = entityCount;
+    config.churnRate = 0.05;
+    config.salvoRate = 0.5;
+    config.timing = LoadGenerator::TIMING_POISSON;
+    config.threadCount = 1;
+    LoadGenerator single(config);
+    config.threadCount = 8;
+    LoadGenerator parallel(config);
+
+    int differingSteps = 0;
+    int invalidStates = 0;
+    int smallestPopulation = entityCount;
+    for (int i = 0; i < steps; ++i) {
+        single.step(dt);
+        parallel.step(dt);
+        differingSteps += sameStep(single, parallel) ? 0 : 1;
+        smallestPopulation = std::min(smallestPopulation, single.liveCount());
+        for (const EntityState& s : single.states()) {
+            if (!std::isfinite(s.lon) || !std::isfinite(s.lat) || !std::isfinite(s.alt)
+                || std::abs(s.lon) > 180.0 || std::abs(s.lat) > 90.0
+                || s.heading < 0.0 || s.heading >= 360.0) {
+                ++invalidStates;
+            }
+        }
+    }
+
+    // Rerun from the start on the parallel generator
+    parallel.reset();
+    LoadGenerator fresh(config);
+    for (int i = 0; i < 100; ++i) {
+        parallel.step(dt);
+        fresh.step(dt);
+        differingSteps += sameStep(fresh, parallel) ? 0 : 1;
+    }
+
+    // Impacted entities are replaced one step later
+    const bool ok = differingSteps == 0 && invalidStates == 0 && smallestPopulation >= entityCount * 99 / 100;
+    std::printf("Load generator, %d entities, %d steps: %d differing steps, %d invalid states, "
+                "population %d..%d - %s\n",
+                entityCount, steps, differingSteps, invalidStates, smallestPopulation, single.liveCount(),
+                ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Steady-state allocation check
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Verify that ingest and updateAll() do not allocate in steady state
+ * @return Process exit code (0 = no allocations)
+ */
+int checkZeroAllocation()
+{
+    const int entityCount = 10000;
+    const int warmupRounds = 10;
+    const int checkedRounds = 60;
+    // Longer than UPDATE_INTERVAL_NEAR / 5 so due-entity updates happen too
+    const std::chrono::milliseconds roundPause(10);
+
+    ManagerFixture& f = managerFixture(entityCount);
+
+    // Let scratch buffers and lazily created state reach their final size
+    for (int i = 0; i < warmupRounds; ++i) {
+        const QVector<EntityState>& states = (i & 1) ? f.statesA : f.statesB;
+        f.manager->updateEntityStates(states.constData(), states.size());
+        f.manager->updateAll();
+        std::this_thread::sleep_for(roundPause);
+    }
+
+    AllocationCounter::Snapshot before = AllocationCounter::snapshot();
+    for (int i = 0; i < checkedRounds; ++i) {
+        const QVector<EntityState>& states = (i & 1) ? f.statesA : f.statesB;
+        f.manager->updateEntityStates(states.constData(), states.size());
+        f.manager->updateAll();
+        std::this_thread::sleep_for(roundPause);
+    }
+    AllocationCounter::Snapshot after = AllocationCounter::snapshot();
+
+    uint64_t allocations = after.allocations - before.allocations;
+    uint64_t bytes = after.bytes - before.bytes;
+    std::printf("Steady state, %d entities, %d ingest+tick rounds: %llu allocations, %llu bytes - %s\n",
+                entityCount, checkedRounds,
+                static_cast<unsigned long long>(allocations),
+                static_cast<unsigned long long>(bytes),
+                allocations == 0 ? "OK" : "FAILED");
+    return allocations == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    if (argc == 2 && std::strcmp(argv[1], "--check-zero-alloc") == 0) {
+        return checkZeroAllocation();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-kernels") == 0) {
+        return checkKernels();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-queries") == 0) {
+        return checkQueries();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-coverage") == 0) {
+        return checkCoverage();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-replay") == 0) {
+        return checkReplay();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-snapshot") == 0) {
+        return checkSnapshot();
+    }
+    if (argc == 2 && std::strcmp(argv[1], "--check-generator") == 0) {
+        return checkGenerator();
+    }
+
+    BenchmarkRunner runner;
+    if (!runner.parseArguments(argc, argv)) {
+        return 1;
+    }
+
+    const std::vector<int64_t> entityCounts = { 1000, 10000, 100000 };
+    const std::vector<int64_t> lodLevels = { 0, 1, 2 };
+
+    runner.add("Object3D_SetPositionUpdateIfDirty", BM_Object3D_SetPositionUpdateIfDirty);
+    runner.add("EntityManager_UpdateAll", BM_EntityManager_UpdateAll, entityCounts);
+    runner.add("EntityManager_UpdateEntityStates", BM_EntityManager_UpdateEntityStates, entityCounts);
+    runner.add("EntityManager_QueryRadius", BM_EntityManager_QueryRadius, entityCounts);
+    runner.add("EntityManager_QueryNearest", BM_EntityManager_QueryNearest, entityCounts);
+    runner.add("EntityManager_Pick", BM_EntityManager_Pick, entityCounts);
+    runner.add("EntityManager_SpawnDespawn", BM_EntityManager_SpawnDespawn, entityCounts);
+    runner.add("EntityManager_CreateEntityLoop", BM_EntityManager_CreateEntityLoop, entityCounts);
+    runner.add("EntityManager_CreateEntities", BM_EntityManager_CreateEntities, entityCounts);
+    runner.add("EntityManager_SensorCoverage", BM_EntityManager_SensorCoverage, entityCounts);
+    runner.add("EntityStateReplayer_ReplayAll", BM_EntityStateReplayer_ReplayAll, entityCounts);
+    runner.add("EntityManager_RestoreSnapshot", BM_EntityManager_RestoreSnapshot, entityCounts);
+    runner.add("LoadGenerator_Step", BM_LoadGenerator_Step, entityCounts);
+    runner.add("LoadGenerator_Ingest", BM_LoadGenerator_Ingest, entityCounts);
+    runner.add("SensorVolume_RebuildGeometry/LOD", BM_SensorVolume_RebuildGeometry, lodLevels);
+    runner.add("SensorVolume_SetColor", BM_SensorVolume_SetColor);
+    runner.add("SensorVolume_SetRadius", BM_SensorVolume_SetRadius);
+    runner.add("TrackLine_RebuildGeometry/LOD", BM_TrackLine_RebuildGeometry, lodLevels);
+    runner.add("AttitudeUtils_EulerToQuat", BM_AttitudeUtils_EulerToQuat);
+    runner.add("AttitudeUtils_RotationScale", BM_AttitudeUtils_RotationScale);
+    runner.add("AttitudeUtils_RotationScaleBatch", BM_AttitudeUtils_RotationScaleBatch, { 1024 });
+    runner.add("EllipsoidModel_LocalToWorld", BM_EllipsoidModel_LocalToWorld);
+    runner.add("Geodesy_GeodeticToEcefEnu", BM_Geodesy_GeodeticToEcefEnu);
+    runner.add("Geodesy_EcefToGeodeticBatch/double", BM_Geodesy_EcefToGeodeticBatch<double>, { 1024 });
+    runner.add("Geodesy_EcefToGeodeticBatch/float", BM_Geodesy_EcefToGeodeticBatch<float>, { 1024 });
+
+    return runner.runAll() > 0 ? 0 : 1;
+}
@@ -0,0 +1,505 @@
+/**
+ * @file SceneBenchmark.cpp
+ * @brief Headless scene-graph scale benchmark (scene_bench)
+ *
+ * Builds N ships (with sensor volumes) and missiles (with track lines),
+ * renders them offscreen into a pbuffer while a scripted camera orbits the
+ * area and zooms through every LOD band, and records per-frame timings from
+ * osgViewer::Stats (update/cull/draw) plus the EntityManager tick.
+ *
+ * No GPU is needed: run against Mesa llvmpipe, e.g.
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./scene_bench --entities=2000 --csv=frames.csv
+ *
+ * Options:
+ *   --entities=<n>    Total entity count, half ships / half missiles (default 1000)
+ *   --frames=<n>      Recorded frames along the camera path (default 600)
+ *   --warmup=<n>      Frames rendered before recording starts (default 30)
+ *   --width=<px> --height=<px>   Offscreen surface size (default 1280x720)
+ *   --csv=<file>      Write per-frame timings as CSV
+ *   --json=<file>     Write configuration, per-frame timings and summary as JSON
+ *   --trace=<file>    Record a Chrome trace of the run (see TraceRecorder.h)
+ *   --flatten         One composed matrix per entity (EntityManager::setFlattenedTransforms)
+ *   --no-sensors --no-tracklines --no-globe   Leave parts of the scene out
+ */
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <osg/Camera>
+#include <osg/Group>
+#include <osg/Geode>
+#include <osg/MatrixTransform>
+#include <osg/ShapeDrawable>
+#include <osg/Stats>
+#include <osg/Timer>
+#include <osgViewer/Viewer>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#include "EntityManager.h"
+#include "TraceCallbacks.h"
+#include "ShipModel.h"
+#include "MissileModel.h"
+#include "sensorvolume.h"
+#include "trackline.h"
+
+namespace {
+
+const double AREA_CENTER_LON = 125.0;
+const double AREA_CENTER_LAT = 30.0;
+
+// Camera path altitude range - spans the NEAR/MID/FAR bands in LodConfig
+const double PATH_MIN_ALTITUDE = 100000.0;    // 100km
+const double PATH_MAX_ALTITUDE = 8000000.0;   // 8000km
+const double PATH_ORBIT_RADIUS_DEG = 3.0;
+
+struct Options {
+    int entities;
+    int frames;
+    int warmup;
+    int width;
+    int height;
+    bool sensors;
+    bool trackLines;
+    bool globe;
+    bool flatten;
+    QString csvPath;
+    QString jsonPath;
+    QString tracePath;
+
+    Options()
+        : entities(1000), frames(600), warmup(30)
+        , width(1280), height(720)
+        , sensors(true), trackLines(true), globe(true), flatten(false)
+    {}
+};
+
+struct FrameSample {
+    int frame;
+    double altitude;       // Camera altitude (m)
+    int visibleEntities;
+    double entityTickMs;   // EntityManager::updateAll()
+    double updateMs;       // osgViewer update traversal
+    double cullMs;         // Camera cull traversal
+    double drawMs;         // Camera draw traversal (CPU side)
+    double frameMs;        // Wall time of the whole frame
+};
+
+bool parseOptions(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--entities=", 11) == 0)       opt.entities = std::atoi(a + 11);
+        else if (std::strncmp(a, "--frames=", 9) == 0)     opt.frames = std::atoi(a + 9);
+        else if (std::strncmp(a, "--warmup=", 9) == 0)     opt.warmup = std::atoi(a + 9);
+        else if (std::strncmp(a, "--width=", 8) == 0)      opt.width = std::atoi(a + 8);
+        else if (std::strncmp(a, "--height=", 9) == 0)     opt.height = std::atoi(a + 9);
+        else if (std::strncmp(a, "--csv=", 6) == 0)        opt.csvPath = QString::fromLocal8Bit(a + 6);
+        else if (std::strncmp(a, "--json=", 7) == 0)       opt.jsonPath = QString::fromLocal8Bit(a + 7);
+        else if (std::strncmp(a, "--trace=", 8) == 0)      opt.tracePath = QString::fromLocal8Bit(a + 8);
+        else if (std::strcmp(a, "--no-sensors") == 0)      opt.sensors = false;
+        else if (std::strcmp(a, "--no-tracklines") == 0)   opt.trackLines = false;
+        else if (std::strcmp(a, "--no-globe") == 0)        opt.globe = false;
+        else if (std::strcmp(a, "--flatten") == 0)         opt.flatten = true;
+        else {
+            std::fprintf(stderr,
+                "Usage: %s [--entities=N] [--frames=N] [--warmup=N] [--width=PX] [--height=PX]\n"
+                "          [--csv=FILE] [--json=FILE] [--trace=FILE]\n"
+                "          [--no-sensors] [--no-tracklines] [--no-globe] [--flatten]\n",
+                argv[0]);
+            return false;
+        }
+    }
+    return opt.entities > 0 && opt.frames > 0 && opt.width > 0 && opt.height > 0;
+}
+
+osg::Vec3d geodeticToEcef(double lon, double lat, double alt)
+{
+    static osg::ref_ptr<osg::EllipsoidModel> ellipsoid = new osg::EllipsoidModel();
+    osg::Vec3d ecef;
+    ellipsoid->convertLatLongHeightToXYZ(
+        osg::DegreesToRadians(lat), osg::DegreesToRadians(lon), alt,
+        ecef.x(), ecef.y(), ecef.z());
+    return ecef;
+}
+
+/**
+ * @brief Scripted camera pose: one orbit around the area while zooming
+ * out from PATH_MIN_ALTITUDE to PATH_MAX_ALTITUDE and back in again
+ * @param t Path parameter in [0, 1]
+ */
+double applyCameraPath(osg::Camera* camera, double t)
+{
+    double theta = 2.0 * osg::PI * t;
+    double zoom = (t < 0.5) ? t * 2.0 : (1.0 - t) * 2.0;
+    double altitude = std::exp(std::log(PATH_MIN_ALTITUDE) +
+        zoom * (std::log(PATH_MAX_ALTITUDE) - std::log(PATH_MIN_ALTITUDE)));
+
+    osg::Vec3d eye = geodeticToEcef(
+        AREA_CENTER_LON + PATH_ORBIT_RADIUS_DEG * std::cos(theta),
+        AREA_CENTER_LAT + PATH_ORBIT_RADIUS_DEG * std::sin(theta),
+        altitude);
+    osg::Vec3d center = geodeticToEcef(AREA_CENTER_LON, AREA_CENTER_LAT, 0.0);
+    osg::Vec3d up = eye;
+    up.normalize();
+
+    camera->setViewMatrixAsLookAt(eye, center, up);
+    return altitude;
+}
+
+osg::Node* createGlobe()
+{
+    osg::ref_ptr<osg::EllipsoidModel> ellipsoid = new osg::EllipsoidModel();
+    osg::ref_ptr<osg::ShapeDrawable> sphere = new osg::ShapeDrawable(
+        new osg::Sphere(osg::Vec3(0, 0, 0), ellipsoid->getRadiusEquator()));
+    sphere->setColor(osg::Vec4(0.1, 0.2, 0.4, 1.0));
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode();
+    geode->addDrawable(sphere.get());
+
+    // Flatten to the WGS84 ellipsoid - a sphere of the equatorial radius
+    // stands up to 21km above sea level at high latitudes and hides ships
+    osg::MatrixTransform* globe = new osg::MatrixTransform(
+        osg::Matrixd::scale(1.0, 1.0, ellipsoid->getRadiusPolar() / ellipsoid->getRadiusEquator()));
+    globe->getOrCreateStateSet()->setMode(GL_NORMALIZE, osg::StateAttribute::ON);
+    globe->addChild(geode.get());
+    return globe;
+}
+
+/**
+ * @brief Create entities in a grid around the area centre
+ * Ships get one sensor volume each, missiles one track line each.
+ */
+void populateScene(EntityManager* manager, GlobalPulseTimeCallback* pulse, const Options& opt)
+{
+    int gridSize = static_cast<int>(std::sqrt(static_cast<double>(opt.entities))) + 1;
+    double spacing = 20.0 / gridSize;  // Spread over 20 x 20 degrees
+
+    QVector<EntityState> states;
+    states.reserve(opt.entities);
+
+    for (int i = 0; i < opt.entities; ++i) {
+        EntityState s;
+        s.entityId = i;
+        s.type = (i % 2 == 0) ? EntityState::SHIP : EntityState::MISSILE;
+        s.lon = AREA_CENTER_LON - 10.0 + (i % gridSize) * spacing;
+        s.lat = AREA_CENTER_LAT - 10.0 + (i / gridSize) * spacing;
+        s.alt = (s.type == EntityState::SHIP) ? 0.0 : 100000.0;
+        s.heading = (i * 37) % 360;
+        s.pitch = (s.type == EntityState::MISSILE) ? 90.0 : 0.0;
+        states.append(s);
+
+        manager->createEntity(i, s.type, QString());
+
+        if (s.type == EntityState::SHIP && opt.sensors) {
+            ShipModel* ship = dynamic_cast<ShipModel*>(manager->getEntityObject(i));
+            if (ship) {
+                ship->addFixedWave(new SensorVolume(
+                    300000.0, osg::Vec4(1.0, 0.0, 0.0, 0.3),
+                    0.0, 120.0, 10.0, 90.0));
+            }
+        }
+        else if (s.type == EntityState::MISSILE && opt.trackLines) {
+            MissileModel* missile = dynamic_cast<MissileModel*>(manager->getEntityObject(i));
+            if (missile) {
+                TrackLine* track = new TrackLine(
+                    1000000.0, 1000.0, osg::Vec4(1.0, 1.0, 0.0, 0.4));
+                pulse->addTrackLine(track);
+                missile->addRadarTrackLine(track);
+            }
+        }
+    }
+
+    manager->updateEntityStates(states);
+}
+
+osg::GraphicsContext* createOffscreenContext(const Options& opt)
+{
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits();
+    traits->readDISPLAY();
+    traits->x = 0;
+    traits->y = 0;
+    traits->width = opt.width;
+    traits->height = opt.height;
+    traits->windowDecoration = false;
+    traits->doubleBuffer = false;
+    traits->pbuffer = true;
+
+    osg::GraphicsContext* gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!gc) {
+        // Some drivers (and Xvfb setups) lack pbuffer support - use an
+        // undecorated window on the virtual display instead
+        qWarning() << "[SceneBenchmark] pbuffer unavailable, falling back to an offscreen window";
+        traits->pbuffer = false;
+        traits->doubleBuffer = true;
+        gc = osg::GraphicsContext::createGraphicsContext(traits.get());
+    }
+    return gc;
+}
+
+double statMs(osg::Stats* stats, unsigned int frame, const char* attribute)
+{
+    double seconds = 0.0;
+    if (stats && stats->getAttribute(frame, attribute, seconds)) {
+        return seconds * 1000.0;
+    }
+    return 0.0;
+}
+
+struct Summary {
+    double mean, p50, p95, p99, max;
+};
+
+Summary summarize(std::vector<double> values)
+{
+    Summary s = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (values.empty()) {
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double v : values) {
+        sum += v;
+    }
+    size_t n = values.size();
+    s.mean = sum / n;
+    s.p50 = values[(n - 1) * 50 / 100];
+    s.p95 = values[(n - 1) * 95 / 100];
+    s.p99 = values[(n - 1) * 99 / 100];
+    s.max = values[n - 1];
+    return s;
+}
+
+typedef double FrameSample::*SampleField;
+
+struct Column {
+    const char* name;
+    SampleField field;
+};
+
+const Column TIMING_COLUMNS[] = {
+    { "entity_tick_ms", &FrameSample::entityTickMs },
+    { "update_ms",      &FrameSample::updateMs },
+    { "cull_ms",        &FrameSample::cullMs },
+    { "draw_ms",        &FrameSample::drawMs },
+    { "frame_ms",       &FrameSample::frameMs },
+};
+const int NUM_TIMING_COLUMNS = sizeof(TIMING_COLUMNS) / sizeof(TIMING_COLUMNS[0]);
+
+Summary summarizeColumn(const std::vector<FrameSample>& samples, SampleField field)
+{
+    std::vector<double> values;
+    values.reserve(samples.size());
+    for (const FrameSample& s : samples) {
+        values.push_back(s.*field);
+    }
+    return summarize(values);
+}
+
+bool writeCsv(const QString& path, const std::vector<FrameSample>& samples)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "[SceneBenchmark] Cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "frame,altitude_m,visible_entities";
+    for (int c = 0; c < NUM_TIMING_COLUMNS; ++c) {
+        out << "," << TIMING_COLUMNS[c].name;
+    }
+    out << "\n";
+
+    for (const FrameSample& s : samples) {
+        out << s.frame << "," << QString::number(s.altitude, 'f', 0) << "," << s.visibleEntities;
+        for (int c = 0; c < NUM_TIMING_COLUMNS; ++c) {
+            out << "," << QString::number(s.*(TIMING_COLUMNS[c].field), 'f', 3);
+        }
+        out << "\n";
+    }
+    return true;
+}
+
+bool writeJson(const QString& path, const Options& opt, const std::vector<FrameSample>& samples)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "[SceneBenchmark] Cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\n  \"config\": {"
+        << "\"entities\": " << opt.entities
+        << ", \"frames\": " << opt.frames
+        << ", \"warmup\": " << opt.warmup
+        << ", \"width\": " << opt.width
+        << ", \"height\": " << opt.height
+        << ", \"sensors\": " << (opt.sensors ? "true" : "false")
+        << ", \"tracklines\": " << (opt.trackLines ? "true" : "false")
+        << ", \"globe\": " << (opt.globe ? "true" : "false")
+        << ", \"flatten\": " << (opt.flatten ? "true" : "false")
+        << "},\n";
+
+    out << "  \"summary\": {";
+    for (int c = 0; c < NUM_TIMING_COLUMNS; ++c) {
+        Summary s = summarizeColumn(samples, TIMING_COLUMNS[c].field);
+        out << (c ? ", " : "") << "\"" << TIMING_COLUMNS[c].name << "\": {"
+            << "\"mean\": " << QString::number(s.mean, 'f', 3)
+            << ", \"p50\": " << QString::number(s.p50, 'f', 3)
+            << ", \"p95\": " << QString::number(s.p95, 'f', 3)
+            << ", \"p99\": " << QString::number(s.p99, 'f', 3)
+            << ", \"max\": " << QString::number(s.max, 'f', 3) << "}";
+    }
+    out << "},\n";
+
+    out << "  \"frames\": [\n";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const FrameSample& s = samples[i];
+        out << "    {\"frame\": " << s.frame
+            << ", \"altitude_m\": " << QString::number(s.altitude, 'f', 0)
+            << ", \"visible_entities\": " << s.visibleEntities;
+        for (int c = 0; c < NUM_TIMING_COLUMNS; ++c) {
+            out << ", \"" << TIMING_COLUMNS[c].name << "\": "
+                << QString::number(s.*(TIMING_COLUMNS[c].field), 'f', 3);
+        }
+        out << "}" << (i + 1 < samples.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+void printSummary(const std::vector<FrameSample>& samples)
+{
+    std::printf("%-16s %10s %10s %10s %10s %10s\n", "Phase (ms)", "mean", "p50", "p95", "p99", "max");
+    for (int c = 0; c < NUM_TIMING_COLUMNS; ++c) {
+        Summary s = summarizeColumn(samples, TIMING_COLUMNS[c].field);
+        std::printf("%-16s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+            TIMING_COLUMNS[c].name, s.mean, s.p50, s.p95, s.p99, s.max);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        return 1;
+    }
+
+    // Scene
+    osg::ref_ptr<osg::Group> root = new osg::Group();
+    if (opt.globe) {
+        root->addChild(createGlobe());
+    }
+
+    osg::ref_ptr<GlobalPulseTimeCallback> pulse = new GlobalPulseTimeCallback();
+    root->addUpdateCallback(pulse.get());
+
+    // Viewer rendering offscreen, single-threaded so stats belong to one frame
+    osgViewer::Viewer viewer;
+    viewer.setThreadingModel(osgViewer::Viewer::SingleThreaded);
+
+    osg::ref_ptr<osg::GraphicsContext> gc = createOffscreenContext(opt);
+    if (!gc.valid()) {
+        qCritical() << "[SceneBenchmark] Failed to create a graphics context (is DISPLAY set?)";
+        return 1;
+    }
+
+    osg::Camera* camera = viewer.getCamera();
+    camera->setGraphicsContext(gc.get());
+    camera->setViewport(new osg::Viewport(0, 0, opt.width, opt.height));
+    camera->setProjectionMatrixAsPerspective(
+        30.0, static_cast<double>(opt.width) / opt.height, 1000.0, 1.0e8);
+    GLenum buffer = gc->getTraits()->doubleBuffer ? GL_BACK : GL_FRONT;
+    camera->setDrawBuffer(buffer);
+    camera->setReadBuffer(buffer);
+
+    EntityManager manager(root.get(), pulse.get(), camera);
+    manager.setFlattenedTransforms(opt.flatten);
+    populateScene(&manager, pulse.get(), opt);
+
+    viewer.setSceneData(root.get());
+    viewer.realize();
+
+    if (!opt.tracePath.isEmpty()) {
+        TraceRecorder::setThreadName("main");
+        TraceCallbacks::attach(root.get(), camera);
+        TraceRecorder::setEnabled(true);
+    }
+
+    osg::Stats* viewerStats = viewer.getViewerStats();
+    viewerStats->collectStats("update", true);
+    viewerStats->collectStats("frame_rate", true);
+    osg::Stats* cameraStats = camera->getStats();
+    if (cameraStats) {
+        cameraStats->collectStats("rendering", true);
+    }
+
+    qDebug() << "[SceneBenchmark]" << opt.entities << "entities,"
+             << opt.frames << "frames at" << opt.width << "x" << opt.height;
+
+    std::vector<FrameSample> samples;
+    samples.reserve(opt.frames);
+
+    osg::Timer* timer = osg::Timer::instance();
+    int totalFrames = opt.warmup + opt.frames;
+
+    for (int i = 0; i < totalFrames && !viewer.done(); ++i) {
+        // Warm-up frames hold the starting pose; recorded frames walk the path
+        int recorded = i - opt.warmup;
+        double t = (recorded <= 0 || opt.frames == 1) ? 0.0
+                 : static_cast<double>(recorded) / (opt.frames - 1);
+
+        osg::Timer_t frameStart = timer->tick();
+        double altitude = applyCameraPath(camera, t);
+
+        osg::Timer_t tickStart = timer->tick();
+        manager.updateAll();
+        double entityTickMs = timer->delta_m(tickStart, timer->tick());
+
+        viewer.frame();
+        double frameMs = timer->delta_m(frameStart, timer->tick());
+
+        if (recorded < 0) {
+            continue;
+        }
+
+        unsigned int frameNumber = viewer.getViewerFrameStamp()->getFrameNumber();
+
+        FrameSample s;
+        s.frame = recorded;
+        s.altitude = altitude;
+        s.visibleEntities = manager.getVisibleEntityCount();
+        s.entityTickMs = entityTickMs;
+        s.updateMs = statMs(viewerStats, frameNumber, "Update traversal time taken");
+        s.cullMs = statMs(cameraStats, frameNumber, "Cull traversal time taken");
+        s.drawMs = statMs(cameraStats, frameNumber, "Draw traversal time taken");
+        s.frameMs = frameMs;
+        samples.push_back(s);
+    }
+
+    printSummary(samples);
+
+    bool ok = true;
+    if (!opt.csvPath.isEmpty()) {
+        ok = writeCsv(opt.csvPath, samples) && ok;
+    }
+    if (!opt.jsonPath.isEmpty()) {
+        ok = writeJson(opt.jsonPath, opt, samples) && ok;
+    }
+    if (!opt.tracePath.isEmpty()) {
+        TraceRecorder::setEnabled(false);
+        ok = TraceRecorder::dumpToFile(opt.tracePath) && ok;
+    }
+    return ok ? 0 : 1;
+}
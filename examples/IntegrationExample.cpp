@@ -82,18 +82,19 @@ void exampleA_UseEntityManager()
     // Enable performance statistics
     entityManager->enablePerformanceStats(true);
     
-    // Create 200 entities (ships and missiles)
-    for (int i = 0; i < 200; ++i) {
-        EntityState::Type type = (i % 2 == 0) 
+    // Create 200 entities (ships and missiles) in one batch
+    QVector<EntitySpec> specs(200);
+    for (int i = 0; i < specs.size(); ++i) {
+        specs[i].state.entityId = i;
+        specs[i].state.type = (i % 2 == 0) 
             ? EntityState::SHIP 
             : EntityState::MISSILE;
             
-        QString modelPath = (type == EntityState::SHIP)
+        specs[i].modelPath = (specs[i].state.type == EntityState::SHIP)
             ? "./models/ship.osgb"
             : "./models/missile.osgb";
-        
-        entityManager->createEntity(i, type, modelPath);
     }
+    entityManager->createEntities(specs);
     
     // Start rendering
     entityManager->startRendering();
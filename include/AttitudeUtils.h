@@ -2,6 +2,7 @@
 #define ATTITUDEUTILS_H
 
 #include <osg/Quat>
+#include <osg/Matrixd>
 #include <osg/Vec3d>
 #include <cmath>
 
@@ -11,6 +12,10 @@
  * 
  * Provides functions for converting between different attitude representations
  * (Euler angles, quaternions) and calculating rotation matrices.
+ *
+ * The *RotationScale kernels build scale * rotation directly in closed form
+ * (one sin/cos per angle, no quaternion round trip, no 4x4 multiplies) and
+ * are what Object3D uses for its local matrix.
  */
 
 namespace AttitudeUtils {
@@ -86,6 +91,111 @@ inline osg::Matrix createRotationMatrix(double heading, double pitch, double rol
     return osg::Matrix::rotate(quat);
 }
 
+/**
+ * @brief Uniform scale followed by heading/pitch/roll rotation, closed form
+ * Same matrix as osg::Matrix::scale(s, s, s) * createRotationMatrix(h, p, r)
+ * (OSG row-vector convention: roll about X first, then pitch about Y, then
+ * heading about Z).
+ * @param heading Heading angle in degrees
+ * @param pitch Pitch angle in degrees
+ * @param roll Roll angle in degrees
+ * @param scale Uniform scale factor
+ * @param out Result, translation is zero
+ */
+inline void eulerToRotationScale(double heading, double pitch, double roll, double scale, osg::Matrixd& out)
+{
+    const double h = osg::DegreesToRadians(heading);
+    const double p = osg::DegreesToRadians(pitch);
+    const double r = osg::DegreesToRadians(roll);
+
+    const double ch = std::cos(h), sh = std::sin(h);
+    const double cp = std::cos(p), sp = std::sin(p);
+    const double cr = std::cos(r), sr = std::sin(r);
+
+    // Scaled rows of Rx(roll) * Ry(pitch) * Rz(heading)
+    const double scp = scale * cp;
+    const double ssp = scale * sp;
+    out.set(scp * ch,                         scp * sh,                         -ssp,     0.0,
+            ssp * sr * ch - scale * cr * sh,  ssp * sr * sh + scale * cr * ch,  scp * sr, 0.0,
+            ssp * cr * ch + scale * sr * sh,  ssp * cr * sh - scale * sr * ch,  scp * cr, 0.0,
+            0.0,                              0.0,                              0.0,      1.0);
+}
+
+/**
+ * @brief Uniform scale followed by a quaternion rotation, closed form
+ * Same matrix as osg::Matrix::scale(s, s, s) * osg::Matrix::rotate(quat);
+ * the quaternion does not need to be normalized.
+ * @param quat Attitude quaternion (as produced by eulerToQuat())
+ * @param scale Uniform scale factor
+ * @param out Result, translation is zero
+ */
+inline void quatToRotationScale(const osg::Quat& quat, double scale, osg::Matrixd& out)
+{
+    const double x = quat.x(), y = quat.y(), z = quat.z(), w = quat.w();
+    const double norm = x * x + y * y + z * z + w * w;
+    const double k = norm > 0.0 ? 2.0 / norm : 0.0;
+
+    const double xx = k * x * x, yy = k * y * y, zz = k * z * z;
+    const double xy = k * x * y, xz = k * x * z, yz = k * y * z;
+    const double wx = k * w * x, wy = k * w * y, wz = k * w * z;
+
+    out.set(scale * (1.0 - yy - zz), scale * (xy + wz),       scale * (xz - wy),       0.0,
+            scale * (xy - wz),       scale * (1.0 - xx - zz), scale * (yz + wx),       0.0,
+            scale * (xz + wy),       scale * (yz - wx),       scale * (1.0 - xx - yy), 0.0,
+            0.0,                     0.0,                     0.0,                     1.0);
+}
+
+/**
+ * @brief Output columns of eulerToRotationScaleBatch()
+ * m[row * 3 + col][i] is element (row, col) of entity i's 3x3 matrix.
+ */
+struct RotationScaleColumns {
+    double* m[9];
+};
+
+/**
+ * @brief eulerToRotationScale() over structure-of-arrays attitude columns
+ * Inputs and outputs are separate contiguous arrays, so the loop has no
+ * gathers or scatters and vectorizes (sin/cos through the vector math
+ * library where the compiler provides one).
+ * @param heading Heading column in degrees
+ * @param pitch Pitch column in degrees
+ * @param roll Roll column in degrees
+ * @param scale Scale column
+ * @param count Number of entities
+ * @param out Nine output columns of count elements each
+ */
+inline void eulerToRotationScaleBatch(const double* heading, const double* pitch, const double* roll,
+                                      const double* scale, int count, const RotationScaleColumns& out)
+{
+    double* m00 = out.m[0]; double* m01 = out.m[1]; double* m02 = out.m[2];
+    double* m10 = out.m[3]; double* m11 = out.m[4]; double* m12 = out.m[5];
+    double* m20 = out.m[6]; double* m21 = out.m[7]; double* m22 = out.m[8];
+
+    for (int i = 0; i < count; ++i) {
+        const double h = osg::DegreesToRadians(heading[i]);
+        const double p = osg::DegreesToRadians(pitch[i]);
+        const double r = osg::DegreesToRadians(roll[i]);
+        const double s = scale[i];
+
+        const double ch = std::cos(h), sh = std::sin(h);
+        const double cp = std::cos(p), sp = std::sin(p);
+        const double cr = std::cos(r), sr = std::sin(r);
+        const double scp = s * cp;
+        const double ssp = s * sp;
+
+        m00[i] = scp * ch;
+        m01[i] = scp * sh;
+        m02[i] = -ssp;
+        m10[i] = ssp * sr * ch - s * cr * sh;
+        m11[i] = ssp * sr * sh + s * cr * ch;
+        m12[i] = scp * sr;
+        m20[i] = ssp * cr * ch + s * sr * sh;
+        m21[i] = ssp * cr * sh - s * sr * ch;
+        m22[i] = scp * cr;
+    }
+}
+
 /**
  * @brief Normalize angle to [-180, 180] range
  * @param angle Angle in degrees
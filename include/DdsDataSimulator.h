@@ -4,14 +4,18 @@
 #include <QObject>
 #include <QTimer>
 #include <QVector>
-#include <cmath>
 #include "EntityManager.h"
+#include "LoadGenerator.h"
 
 /**
  * @file DdsDataSimulator.h
  * @brief DDS data simulator for testing without real DDS
- * 
- * Simulates entity movement and state updates for testing purposes.
+ *
+ * Drives a LoadGenerator from a timer and feeds its output into
+ * EntityManager the way a DDS handler would: new entities are created,
+ * due states are passed to updateEntityStates(), and removed entities are
+ * removed. Each tick advances simulated time by the timer interval rather
+ * than by the wall clock, so a run is reproducible for a given seed.
  * In production, replace this with real DDS message handlers.
  */
 
@@ -28,9 +32,23 @@ public:
     explicit DdsDataSimulator(EntityManager* entityManager, QObject* parent = nullptr);
     virtual ~DdsDataSimulator();
 
+    /**
+     * @brief Replace the generator configuration and start the simulation over
+     * Entities of the previous run stay in the manager.
+     */
+    void setConfig(const LoadGenerator::Config& config);
+
+    const LoadGenerator& generator() const { return m_generator; }
+
+    /**
+     * @brief Create entities the generator spawns (default on)
+     * When off, only entities that already exist in the manager are updated.
+     */
+    void setCreateEntities(bool create) { m_createEntities = create; }
+
     /**
      * @brief Start simulation
-     * @param updateIntervalMs Update interval in milliseconds
+     * @param updateIntervalMs Update interval in milliseconds, also the simulated step
      */
     void start(int updateIntervalMs = 100);
 
@@ -39,12 +57,7 @@ public:
      */
     void stop();
 
-    /**
-     * @brief Set simulation parameters
-     * @param speedFactor Movement speed multiplier (default 1.0)
-     * @param altitudeVariation Altitude variation range (default 50000m)
-     */
-    void setSimulationParams(double speedFactor = 1.0, double altitudeVariation = 50000.0);
+    bool isRunning() const { return m_timer->isActive(); }
 
 public slots:
     /**
@@ -52,23 +65,14 @@ public slots:
      */
     void updateSimulation();
 
-protected:
-    /**
-     * @brief Generate simulated entity state
-     * @param entityId Entity identifier
-     * @param type Entity type
-     * @param time Simulation time
-     * @return Simulated entity state
-     */
-    EntityState generateEntityState(int entityId, EntityState::Type type, double time);
-
 private:
     EntityManager* m_entityManager;
     QTimer* m_timer;
-    
-    double m_simulationTime;
-    double m_speedFactor;
-    double m_altitudeVariation;
+    LoadGenerator m_generator;
+    bool m_createEntities;
+
+    QVector<EntitySpec> m_newEntities;      // Spawned entities not yet in the manager
+    QVector<EntityState> m_existingStates;  // Due states of entities in the manager, without creation
 };
 
 #endif // DDSDATASIMULATOR_H
@@ -0,0 +1,82 @@
+#ifndef ENTITYGROUP_H
+#define ENTITYGROUP_H
+
+#include <QVector>
+#include <osg/Group>
+
+/**
+ * @file EntityGroup.h
+ * @brief Scene graph group with constant-time removal of entity subgraphs
+ *
+ * osg::Group::removeChild(node) searches the child list and erases from
+ * its middle, so removing one of thousands of entities is linear twice.
+ * EntityGroup instead removes by index, moving the last child into the
+ * freed position - the same swap-remove EntityStore uses for its slots.
+ * The owner keeps each entity's index (ManagedEntity::groupIndex) and
+ * patches the one entity whose child moved, using the id returned by
+ * removeEntity().
+ *
+ * Children must only be added and removed through addEntity() and
+ * removeEntity()/clearEntities(), otherwise the ids no longer match the
+ * child list. Child order carries no meaning for an entity group.
+ *
+ * With setFixedBound() the group reports a caller-maintained sphere
+ * instead of merging the bounds of all children, so a child moving every
+ * tick does not make the next cull or intersection pass re-merge its
+ * siblings.
+ */
+
+class EntityGroup : public osg::Group
+{
+public:
+    EntityGroup();
+
+    /**
+     * @brief Append an entity's root node
+     * @param node Entity subgraph
+     * @param entityId Id reported by removeEntity() when this child moves
+     * @return Child index of the node
+     */
+    unsigned int addEntity(osg::Node* node, int entityId);
+
+    /**
+     * @brief Remove a child by moving the last child into its place
+     * @param index Child index returned by addEntity() (or patched since)
+     * @return Entity id now at index, -1 if the last child was removed
+     */
+    int removeEntity(unsigned int index);
+
+    /**
+     * @brief Remove all entity children
+     */
+    void clearEntities();
+
+    int entityId(unsigned int index) const { return m_entityIds[index]; }
+
+    /**
+     * @brief Report this sphere as the bound instead of computing it
+     * The caller must keep it enclosing every child, or children outside
+     * it are culled.
+     * @param bound Sphere in the group's coordinate frame
+     */
+    void setFixedBound(const osg::BoundingSphere& bound);
+
+    /**
+     * @brief Go back to merging the child bounds
+     */
+    void clearFixedBound();
+
+    bool hasFixedBound() const { return m_hasFixedBound; }
+
+    virtual osg::BoundingSphere computeBound() const;
+
+protected:
+    virtual ~EntityGroup();
+
+private:
+    QVector<int> m_entityIds;   // Entity id of each child
+    osg::BoundingSphere m_fixedBound;
+    bool m_hasFixedBound;
+};
+
+#endif // ENTITYGROUP_H
@@ -4,13 +4,23 @@
 #include <QObject>
 #include <QMap>
 #include <QTimer>
+#include <QThreadPool>
 #include <QDateTime>
 #include <osg/Group>
 #include <osg/Camera>
+#include <osg/MatrixTransform>
 #include <osg/UpdateCallback>
 #include "ShipModel.h"
 #include "MissileModel.h"
 #include "LodConfig.h"
+#include "EntityStore.h"
+#include "SensorCoverage.h"
+#include "ModelLoader.h"
+#include "EntityPool.h"
+#include "EntityGroup.h"
+#include "PerfInstrumentation.h"
+
+class EntityStateRecorder;
 
 /**
  * @file EntityManager.h
@@ -19,7 +29,7 @@
  * Core component that manages all 3D entities (ships, missiles) with:
  * - Dynamic LOD based on camera distance
  * - Hierarchical update frequency (near entities update more frequently)
- * - Performance statistics tracking
+ * - Performance statistics tracking (per-phase timing, see PerfInstrumentation.h)
  * - Batch updates for efficiency
  * 
  * Performance optimizations:
@@ -27,6 +37,36 @@
  * 2. Distance-based update frequency (3 levels)
  * 3. Frustum culling (entities outside view not updated)
  * 4. Dirty flag system (only update when data changes)
+ * 5. No heap allocation in ingest and updateAll() once the entity set is
+ *    stable (checked by entity_bench --check-zero-alloc)
+ * 6. Camera distances computed in one batch pass over EntityStore columns
+ *
+ * Spatial queries (queryRadius(), queryNearest(), ...) run against a
+ * uniform ECEF grid kept in step with entity positions (SpatialHash.h).
+ * Radius, nearest, box and geodetic box queries only visit the cells
+ * around the query region, so they cost O(entities nearby) instead of a
+ * scan of all entities. queryPolytope(), queryViewFrustum() and pick()
+ * test each occupied cell once and then only the entities of the cells
+ * they reach.
+ *
+ * With sensor coverage enabled, every tick also works out which entities
+ * are inside each ship's SensorVolumes and signals the changes
+ * (SensorCoverage.h).
+ *
+ * pick() finds entities under the mouse from the bounding spheres in the
+ * store and only intersects triangles of the few nearest candidates;
+ * setHighlighted() marks entities with a shared outline marker.
+ *
+ * Entities are attached below an entity root group (getEntityRoot())
+ * inside the scene root.
+ *
+ * Below the entity root, entities are grouped by longitude/latitude tile
+ * (LodConfig::SCENE_TILE_DEGREES) and move between tile groups as their
+ * position changes. Cull rejects a tile outside the view with one sphere
+ * test instead of visiting each of its entities. Tiles report a fixed
+ * bound around their cell (EntityGroup::setFixedBound()) that only grows
+ * when an entity or its attachments reach outside it, so entities moving
+ * every tick never make OSG re-merge the bounds of their siblings.
  */
 
 // Entity state structure for DDS integration
@@ -48,6 +88,11 @@ struct EntityState {
     double heading;
     double pitch;
     double roll;
+
+    // Optional attitude quaternion (AttitudeUtils::eulerToQuat convention),
+    // used instead of heading/pitch/roll when hasQuaternion is set
+    bool hasQuaternion;
+    double qx, qy, qz, qw;
     
     // Timestamp
     qint64 timestamp;
@@ -57,10 +102,18 @@ struct EntityState {
         , type(SHIP)
         , lon(0), lat(0), alt(0)
         , heading(0), pitch(0), roll(0)
+        , hasQuaternion(false)
+        , qx(0), qy(0), qz(0), qw(1)
         , timestamp(0)
     {}
 };
 
+// Entity description for EntityManager::createEntities()
+struct EntitySpec {
+    EntityState state;      // Id, type and initial position/attitude
+    QString modelPath;      // Empty for none
+};
+
 // Managed entity wrapper
 struct ManagedEntity {
     int entityId;
@@ -74,6 +127,13 @@ struct ManagedEntity {
     // Update management
     qint64 lastUpdateTime;  // Last update timestamp
     bool visible;           // Currently visible
+
+    int storeIndex;         // Slot in EntityManager's EntityStore
+    int tileKey;            // Scene tile group the entity hangs below
+    int groupIndex;         // Child index in that tile's EntityGroup
+    double extent;          // Object3D::getExtentRadius() at the last update
+    QString modelPath;          // As passed to createEntity(), kept for snapshots
+    QString pendingModelPath;   // Model still loading (placeholder shown), empty otherwise
     
     ManagedEntity()
         : entityId(-1)
@@ -82,6 +142,10 @@ struct ManagedEntity {
         , lastDistance(0)
         , lastUpdateTime(0)
         , visible(true)
+        , storeIndex(-1)
+        , tileKey(-1)
+        , groupIndex(-1)
+        , extent(0)
     {}
 };
 
@@ -142,13 +206,53 @@ public:
 
     /**
      * @brief Create a new entity
+     * With asynchronous model loading (the default) the entity shows its
+     * placeholder until the model file has been read, see setAsyncModelLoading().
      * @param entityId Unique entity identifier
      * @param type Entity type (SHIP or MISSILE)
-     * @param modelPath Path to 3D model file
+     * @param modelPath Path to 3D model file, empty for none
      * @return true if successful
      */
     bool createEntity(int entityId, EntityState::Type type, const QString& modelPath);
 
+    /**
+     * @brief Create many entities at once, e.g. when loading a scenario
+     * Equivalent to createEntity() plus updateEntityState() for each spec,
+     * without their per-call overhead: storage is sized once, each distinct
+     * model is requested once and shared, new objects are built and placed
+     * on worker threads, and everything is attached to the scene in one
+     * pass at the end. Ids that exist already or repeat within the batch
+     * are skipped with a warning.
+     * @param specs Entities to create, in any order
+     * @param count Number of specs
+     * @return Number of entities created
+     */
+    int createEntities(const EntitySpec* specs, int count);
+    int createEntities(const QVector<EntitySpec>& specs);
+
+    /**
+     * @brief Write the full entity picture to a snapshot file
+     * Saves ids, types, model paths, positions, attitudes, scales,
+     * visibility, LOD state, billboards, ship sensor volumes and missile
+     * track lines (see EntitySnapshot.h). Highlights and manager settings
+     * are not included.
+     * @param path Snapshot file, replaced once the new one is complete
+     * @return false if the file cannot be written
+     */
+    bool saveSnapshot(const QString& path) const;
+
+    /**
+     * @brief Replace all entities by those of a snapshot
+     * The file is memory-mapped and its records used in place. Storage is
+     * sized for the whole snapshot up front, entities go into the map in
+     * id order without a search, and each distinct model path is decoded
+     * and requested once.
+     * @param path Snapshot file written by saveSnapshot()
+     * @return false if the file is missing or damaged; the current
+     *         entities are kept in that case
+     */
+    bool restoreSnapshot(const QString& path);
+
     /**
      * @brief Update entity state (position, attitude)
      * @param state New entity state
@@ -161,6 +265,15 @@ public:
      */
     void updateEntityStates(const QVector<EntityState>& states);
 
+    /**
+     * @brief Batch update from a caller-owned buffer
+     * Lets feed handlers reuse one preallocated array instead of building a
+     * QVector per message batch; does not allocate for known entities.
+     * @param states Pointer to the first state
+     * @param count Number of states
+     */
+    void updateEntityStates(const EntityState* states, int count);
+
     /**
      * @brief Remove entity
      * @param entityId Entity identifier
@@ -198,6 +311,71 @@ public:
      */
     void setTrackLinesVisible(bool visible);
 
+    /**
+     * @brief Use one composed matrix per entity instead of two transforms
+     * Applies to existing and future entities, see Object3D::setFlattenedTransform()
+     */
+    void setFlattenedTransforms(bool flattened);
+
+    /**
+     * @brief Read model files on a background thread pool (default on)
+     * createEntity() then never blocks on file I/O: the entity shows the
+     * placeholder of its type, and the first updateAll() after the read
+     * finished swaps the model in. Each path is read once and its model is
+     * shared by all entities using it. Off, createEntity() reads the file
+     * itself, once per entity.
+     */
+    void setAsyncModelLoading(bool enabled) { m_asyncModelLoading = enabled; }
+    bool isAsyncModelLoading() const { return m_asyncModelLoading; }
+
+    /**
+     * @brief Compile GL objects of loaded models before swapping them in
+     * @param compileOperation Operation attached to the viewer, see ModelLoader
+     */
+    void setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation* compileOperation)
+    {
+        m_modelLoader.setIncrementalCompileOperation(compileOperation);
+    }
+
+    /**
+     * @brief Number of model files still being read or compiled
+     */
+    int getPendingModelCount() const { return m_modelLoader.pendingCount(); }
+
+    /**
+     * @brief Record every ingested state batch into a log for later replay
+     * updateEntityState() and both updateEntityStates() overloads pass
+     * their states to the recorder before applying them; see
+     * EntityStateRecorder and EntityStateReplayer.
+     * @param recorder Open recorder (not owned), nullptr to stop recording
+     */
+    void setStateRecorder(EntityStateRecorder* recorder) { m_stateRecorder = recorder; }
+    EntityStateRecorder* getStateRecorder() const { return m_stateRecorder; }
+
+    /**
+     * @brief Keep up to capacity removed ships and missiles (each) for reuse
+     * createEntity() takes objects from the pool before building new ones,
+     * see EntityPool. 0 disables recycling.
+     */
+    void setEntityPoolCapacity(int capacity) { m_pool.setCapacity(capacity); }
+
+    /**
+     * @brief Build entity objects ahead of a burst of createEntity() calls
+     * @param ships Free ships to have ready
+     * @param missiles Free missiles to have ready
+     */
+    void prefillEntityPool(int ships, int missiles) { m_pool.prefill(ships, missiles); }
+
+    /**
+     * @brief Number of scene tile groups created so far
+     */
+    int getSceneTileCount() const { return m_usedTileKeys.size(); }
+
+    /**
+     * @brief Group all entities and highlight markers are attached to
+     */
+    osg::Group* getEntityRoot() const { return m_entityRoot.get(); }
+
     /**
      * @brief Get entity count
      */
@@ -208,12 +386,161 @@ public:
      */
     int getVisibleEntityCount() const;
 
+    /**
+     * @brief Get the scene object of an entity (to attach sensors, track lines, ...)
+     * @param entityId Entity identifier
+     * @return ShipModel or MissileModel, nullptr if the entity does not exist
+     */
+    Object3D* getEntityObject(int entityId) const;
+
+    /**
+     * @brief Entities within a distance of a point
+     * @param center ECEF point
+     * @param radius Distance in meters
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found
+     */
+    int queryRadius(const osg::Vec3d& center, double radius, QVector<int>& entityIds) const;
+
+    /**
+     * @brief Entities within a distance of a geodetic point
+     * @param lon Longitude in degrees
+     * @param lat Latitude in degrees
+     * @param alt Altitude in meters
+     * @param radius Straight-line (ECEF) distance in meters
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found
+     */
+    int queryRadius(double lon, double lat, double alt, double radius, QVector<int>& entityIds) const;
+
+    /**
+     * @brief The k entities nearest to a point
+     * @param center ECEF point
+     * @param k Number of entities
+     * @param entityIds Output, cleared first, nearest first
+     * @return Number of entities found (fewer than k if fewer exist)
+     */
+    int queryNearest(const osg::Vec3d& center, int k, QVector<int>& entityIds) const;
+
+    /**
+     * @brief Entities inside an axis-aligned ECEF box
+     * @param minCorner Minimum corner
+     * @param maxCorner Maximum corner
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found
+     */
+    int queryBox(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner, QVector<int>& entityIds) const;
+
+    /**
+     * @brief Entities inside a longitude/latitude/altitude box
+     * minLon > maxLon selects a range across the antimeridian.
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found
+     */
+    int queryGeodeticBox(double minLon, double maxLon, double minLat, double maxLat,
+                         double minAlt, double maxAlt, QVector<int>& entityIds) const;
+
+    /**
+     * @brief Entities inside a convex ECEF volume
+     * @param polytope Planes with inward normals, e.g. a view frustum
+     *        transformed to world space
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found
+     */
+    int queryPolytope(const osg::Polytope& polytope, QVector<int>& entityIds) const;
+
+    /**
+     * @brief Entities inside the current view frustum of the camera
+     * @param entityIds Output, cleared first, unordered
+     * @return Number of entities found, 0 without a camera
+     */
+    int queryViewFrustum(QVector<int>& entityIds) const;
+
+    /**
+     * @brief Evaluate ship sensor volumes against all entities every tick
+     * While enabled, updateAll() emits targetEnteredSensor() and
+     * targetLeftSensor() for every change. Sensors are picked up from
+     * ShipModel::getSensorVolumes() each tick, so they can be added to
+     * ships at any time. Disabling drops all detection state.
+     */
+    void setSensorCoverageEnabled(bool enabled);
+    bool isSensorCoverageEnabled() const { return m_sensorCoverageEnabled; }
+
+    /**
+     * @brief Current detections of one sensor
+     * @param shipId Ship entity id
+     * @param sensorIndex Index in ShipModel::getSensorVolumes()
+     * @param targetIds Output, cleared first, ascending entity ids
+     * @return false if coverage is disabled or the ship/sensor is unknown
+     */
+    bool getSensorDetections(int shipId, int sensorIndex, QVector<int>& targetIds) const;
+
+    /**
+     * @brief Entities under a window position, best match first
+     * Builds the pick ray from the camera's view, projection and viewport,
+     * then works like the ray overload below.
+     * @param windowX, windowY Window coordinates (origin bottom left, as in OSG events)
+     * @param entityIds Output, cleared first
+     * @param pixelTolerance Extra hit radius in pixels, so small or distant
+     *        entities can be clicked without hitting them exactly
+     * @return Number of entities found, 0 without a camera viewport
+     */
+    int pick(double windowX, double windowY, QVector<int>& entityIds, double pixelTolerance = 4.0);
+
+    /**
+     * @brief Entities along a ray, best match first
+     * Bounding spheres of all entities are tested against the ray (grid
+     * accelerated, see EntityStore::queryRay()). Only the
+     * LodConfig::PICK_REFINE_CANDIDATES nearest sphere hits are intersected
+     * with their model triangles; entities whose model the ray really hits
+     * come first, ordered by hit distance, followed by the remaining sphere
+     * hits from near to far.
+     * @param rayOrigin Ray start in ECEF
+     * @param rayDirection Ray direction in ECEF
+     * @param tanTolerance Tangent of the pick cone half-angle, 0 for a plain ray
+     * @param entityIds Output, cleared first
+     * @return Number of entities found
+     */
+    int pick(const osg::Vec3d& rayOrigin, const osg::Vec3d& rayDirection, double tanTolerance,
+             QVector<int>& entityIds);
+
+    /**
+     * @brief Show or hide the highlight marker of an entity (hover, selection)
+     * All markers share one geometry and state set; each only adds a
+     * transform, which follows the entity every tick.
+     */
+    void setHighlighted(int entityId, bool highlighted);
+    bool isHighlighted(int entityId) const { return m_highlights.contains(entityId); }
+
+    /**
+     * @brief Remove all highlight markers
+     */
+    void clearHighlights();
+
+    /**
+     * @brief Per-phase timings and counters of the last completed stats window
+     * Only filled while performance statistics are enabled and the library is
+     * built with ENABLE_PERF_INSTRUMENTATION.
+     */
+    const PerfInstrumentation::WindowReport& getLastPerformanceReport() const { return m_lastReport; }
+
 public slots:
     /**
      * @brief Update all entities (called by timer)
      */
     void updateAll();
 
+signals:
+    /**
+     * @brief An entity moved into a ship's sensor sector (coverage enabled only)
+     */
+    void targetEnteredSensor(int shipId, int sensorIndex, int targetId);
+
+    /**
+     * @brief An entity left a ship's sensor sector, or was removed
+     */
+    void targetLeftSensor(int shipId, int sensorIndex, int targetId);
+
 protected:
     /**
      * @brief Update LOD for an entity based on camera distance
@@ -224,6 +551,7 @@ protected:
 
     /**
      * @brief Calculate distance from camera to entity
+     * Read from the batch distance pass at the start of updateAll()
      * @param entity Entity
      * @return Distance in meters
      */
@@ -238,26 +566,143 @@ protected:
 
     /**
      * @brief Print performance statistics
+     * @param elapsedMs Length of the stats window in milliseconds
      */
-    void printPerformanceStats();
+    void printPerformanceStats(qint64 elapsedMs);
 
 private:
+    /**
+     * @brief Entity group of one longitude/latitude tile and its fixed bound
+     */
+    struct SceneTile {
+        osg::ref_ptr<EntityGroup> group;    // nullptr until an entity enters the tile
+        osg::Vec3d center;                  // Bound centre in ECEF
+        double radius;                      // Bound radius, grown to fit the entities
+        double emptyRadius;                 // Radius around the cell alone
+
+        SceneTile() : center(0.0, 0.0, 0.0), radius(0.0), emptyRadius(0.0) {}
+    };
+
+    /**
+     * @brief Push a tile's bound to its group
+     */
+    void applyTileBound(SceneTile& tile);
+
+    /**
+     * @brief Apply one state without timing (shared by single and batch ingest)
+     */
+    void applyEntityState(const EntityState& state);
+
+    /**
+     * @brief Replace the store slots of a query result by entity ids
+     * @return Number of entries
+     */
+    int slotsToEntityIds(QVector<int>& indices) const;
+
+    /**
+     * @brief Intersect the model triangles of one entity with a ray
+     * @param object Entity object
+     * @param origin Ray start in ECEF
+     * @param direction Normalized ray direction
+     * @param length Ray length to test
+     * @param distance Output, distance from origin to the first hit
+     * @return false if the ray misses or the model is not shown
+     */
+    bool intersectModel(Object3D* object, const osg::Vec3d& origin, const osg::Vec3d& direction,
+                        double length, double& distance) const;
+
+    /**
+     * @brief Place a highlight marker on its entity's current position
+     */
+    void updateHighlightMarker(int entityId, osg::MatrixTransform* marker);
+
+    /**
+     * @brief Attach an entity's transform to a scene tile group, creating the tile
+     */
+    void attachToTile(ManagedEntity& entity, int tileKey);
+
+    /**
+     * @brief Detach an entity's transform from its tile group (swap-remove)
+     */
+    void detachFromTile(ManagedEntity& entity);
+
+    /**
+     * @brief Grow the fixed bound of an entity's tile if the entity reaches outside it
+     */
+    void fitTileBound(const ManagedEntity& entity);
+
+    /**
+     * @brief Object for a new entity, from the pool where possible
+     * Reads the model file here when asynchronous loading is off.
+     */
+    osg::ref_ptr<Object3D> acquireObject(EntityState::Type type, const QString& modelPath);
+
+    /**
+     * @brief Attach a new entity's object to the scene, store and coverage
+     * Position, attitude and attachments should already be set; the
+     * entity is not yet in m_entities.
+     */
+    void initEntity(ManagedEntity& entity, const QString& modelPath);
+
+    /**
+     * @brief Give a new entity its model from the loader, or the placeholder
+     * and a place in the waiting list if the model is not loaded yet
+     */
+    void assignModel(ManagedEntity& entity, const QString& modelPath);
+
+    /**
+     * @brief Swap in the models the loader finished since the last tick
+     */
+    void applyLoadedModels();
+
     osg::ref_ptr<osg::Group> m_sceneRoot;
     osg::ref_ptr<GlobalPulseTimeCallback> m_pulseCallback;
     osg::ref_ptr<osg::Camera> m_camera;
+    osg::Vec3d m_cameraPosition;    // World position of m_camera for the current tick
+    osg::ref_ptr<osg::Group> m_entityRoot;             // Parent of the tile groups and highlight markers
+    osg::ref_ptr<osg::Group> m_tileRoot;               // Parent of the tile groups
+    QVector<SceneTile> m_tiles;     // By tile key (ManagedEntity::tileKey), sized on first use
+    QVector<int> m_usedTileKeys;    // Tiles with a group
     
     QMap<int, ManagedEntity> m_entities;
+    EntityStore m_store;            // Dense per-entity columns, see ManagedEntity::storeIndex
+    EntityPool m_pool;              // Objects of removed entities, reused by createEntity()
+    QThreadPool m_buildPool;        // Workers of createEntities()
     
     QTimer* m_updateTimer;
     bool m_performanceStatsEnabled;
     
     // Performance tracking
     qint64 m_lastStatsTime;
-    int m_frameCount;
+    int m_frameCount;           // updateAll() ticks in the current stats window
+    PerfInstrumentation::WindowReport m_lastReport;
+
+    // Per-tick scratch lists, kept as members so their capacity is reused
+    // (updateAll() allocates nothing once these have grown to the entity count)
+    QVector<ManagedEntity*> m_dueEntities;          // Entities updated this tick
+    QVector<ManagedEntity*> m_visibilityChanges;    // Entities whose visibility flips
     
     // Visibility flags
     bool m_sensorVolumesVisible;
     bool m_trackLinesVisible;
+
+    // Entity transform modes
+    bool m_flattenedTransforms;
+
+    // Sensor coverage, see setSensorCoverageEnabled()
+    bool m_sensorCoverageEnabled;
+    SensorCoverage m_coverage;
+
+    // Picking and highlighting
+    QVector<EntityStore::RayHit> m_pickHits;     // Scratch list of pick()
+    QMap<int, osg::ref_ptr<osg::MatrixTransform>> m_highlights;  // Entity id -> marker below m_entityRoot
+
+    // Background model loading, see setAsyncModelLoading()
+    bool m_asyncModelLoading;
+    EntityStateRecorder* m_stateRecorder;   // Taps ingest, see setStateRecorder()
+    ModelLoader m_modelLoader;
+    QHash<QString, QVector<int>> m_modelWaiters;    // Model path -> entities showing the placeholder
+    QVector<ModelLoader::Result> m_loadedModels;    // Scratch list of applyLoadedModels()
 };
 
 #endif // ENTITYMANAGER_H
@@ -0,0 +1,87 @@
+#ifndef ENTITYPOOL_H
+#define ENTITYPOOL_H
+
+#include <QVector>
+#include "ShipModel.h"
+#include "MissileModel.h"
+#include "LodConfig.h"
+
+/**
+ * @file EntityPool.h
+ * @brief Free lists of ship and missile objects for reuse after removal
+ *
+ * Building an entity allocates its Object3D and the transform / switch /
+ * group hierarchy below it; tearing it down frees all of that again. Salvo
+ * scenarios create and remove hundreds of missiles per second, so
+ * EntityManager hands removed objects to this pool and takes new ones from
+ * it. A recycled object is reset() to its constructed state - no model, no
+ * attachments, no billboard - and keeps its scene graph nodes.
+ *
+ * Each type keeps at most capacity() objects; beyond that released objects
+ * are freed as before. Objects still referenced elsewhere (e.g. by the
+ * application through EntityManager::getEntityObject()) are never recycled.
+ */
+
+class EntityPool
+{
+public:
+    /**
+     * @param capacity Free objects kept per type
+     */
+    explicit EntityPool(int capacity = LodConfig::ENTITY_POOL_CAPACITY);
+
+    /**
+     * @brief A ship at the origin without a model, recycled if one is free
+     */
+    osg::ref_ptr<ShipModel> acquireShip();
+
+    /**
+     * @brief A missile at the origin without a model, recycled if one is free
+     */
+    osg::ref_ptr<MissileModel> acquireMissile();
+
+    /**
+     * @brief Take an object back
+     * The caller's reference is cleared. The object is reset and kept if it
+     * is a ship or missile, nobody else references it and its free list is
+     * not full; otherwise it is freed.
+     * @param object Object detached from the scene graph
+     * @return true if the object was kept for reuse
+     */
+    bool release(osg::ref_ptr<Object3D>& object);
+
+    /**
+     * @brief Build objects ahead of time, e.g. before a salvo
+     * @param ships Free ships wanted (capped at capacity())
+     * @param missiles Free missiles wanted (capped at capacity())
+     */
+    void prefill(int ships, int missiles);
+
+    /**
+     * @brief Change the per-type limit, freeing objects above it
+     */
+    void setCapacity(int capacity);
+    int capacity() const { return m_capacity; }
+
+    int freeShipCount() const { return m_freeShips.size(); }
+    int freeMissileCount() const { return m_freeMissiles.size(); }
+
+    /**
+     * @brief Free all pooled objects
+     */
+    void clear();
+
+    /**
+     * @brief Construct an object as the pool would, bypassing the free lists
+     * Unlike the rest of the pool these may be called from worker threads.
+     */
+    static ShipModel* createShip();
+    static MissileModel* createMissile();
+
+private:
+    int m_capacity;
+    QVector<osg::ref_ptr<ShipModel>> m_freeShips;
+    QVector<osg::ref_ptr<MissileModel>> m_freeMissiles;
+};
+
+#endif // ENTITYPOOL_H
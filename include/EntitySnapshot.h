@@ -0,0 +1,195 @@
+#ifndef ENTITYSNAPSHOT_H
+#define ENTITYSNAPSHOT_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @file EntitySnapshot.h
+ * @brief Flat file format of the full entity picture (EntityManager::saveSnapshot())
+ *
+ * A snapshot is a header followed by tables of fixed-size records:
+ * - entities: id, type, model path, position, attitude, scale, visibility,
+ *   LOD level, LOD distance, billboard and the range of its attachments
+ * - sensor volumes of ships
+ * - track lines of missiles
+ * - strings: UTF-8 model and billboard paths, each distinct path stored
+ *   once
+ *
+ * The tables are 8-byte aligned and read in place from the memory-mapped
+ * file - no parsing, and nothing is copied besides the paths. Records are
+ * stored in the byte order of the writing machine; the header carries a
+ * marker so a file from a machine of the other byte order is rejected
+ * rather than misread. Entities are sorted by id, which lets the restore
+ * append them to EntityManager's map without searching it.
+ *
+ * VERSION is raised whenever a record layout changes; older files are
+ * rejected.
+ */
+
+namespace EntitySnapshot {
+
+const quint32 MAGIC = 0x504E5345;      // "ESNP"
+const quint32 VERSION = 1;
+const quint32 BYTE_ORDER_MARK = 0x01020304;
+
+// EntityRecord::flags
+const quint8 FLAG_VISIBLE = 0x01;
+const quint8 FLAG_QUATERNION = 0x02;   // Attitude in qx..qw, not heading/pitch/roll
+const quint8 FLAG_BILLBOARD = 0x04;
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 byteOrder;          // BYTE_ORDER_MARK as written
+    quint32 entityCount;
+    quint32 sensorCount;
+    quint32 trackLineCount;
+    quint32 stringBytes;
+    quint32 reserved;
+    qint64 entityOffset;        // File offsets of the tables
+    qint64 sensorOffset;
+    qint64 trackLineOffset;
+    qint64 stringOffset;
+};
+
+struct EntityRecord {
+    qint32 entityId;
+    quint8 type;                // EntityState::Type
+    quint8 flags;
+    quint8 lodLevel;            // ManagedEntity::lodLevel
+    quint8 reserved;
+    quint32 modelPathOffset;    // Into the string table
+    quint32 modelPathLength;    // Bytes, 0 without model
+    quint32 billboardOffset;
+    quint32 billboardLength;
+    quint32 firstAttachment;    // Index into the sensor (ship) or track line (missile) table
+    quint32 attachmentCount;
+    double lon, lat, alt;
+    double heading, pitch, roll;
+    double qx, qy, qz, qw;
+    double scale;
+    double nearDistance;        // Object3D::getLODNearDistance()
+    double billboardWidth;
+    double billboardHeight;
+    qint64 lastUpdateTime;
+};
+
+struct SensorRecord {
+    double radius;
+    double azimuthStart, azimuthEnd;
+    double elevationStart, elevationEnd;
+    float color[4];
+    quint8 lodLevel;
+    quint8 visible;
+    quint8 reserved[6];
+};
+
+struct TrackLineRecord {
+    double length;
+    double radius;
+    double width;
+    double speed;
+    float color[4];
+    quint8 lodLevel;
+    quint8 visible;
+    quint8 reserved[6];
+};
+
+static_assert(sizeof(Header) == 64, "snapshot header layout");
+static_assert(sizeof(EntityRecord) == 152, "snapshot entity record layout");
+static_assert(sizeof(SensorRecord) == 64, "snapshot sensor record layout");
+static_assert(sizeof(TrackLineRecord) == 56, "snapshot track line record layout");
+
+/**
+ * @brief Collects records and writes a snapshot file
+ */
+class Writer
+{
+public:
+    /**
+     * @param entities Expected entity count
+     */
+    void reserve(int entities);
+
+    /**
+     * @brief Append an entity record (zeroed); entities must be added by ascending id
+     */
+    EntityRecord& addEntity();
+
+    SensorRecord& addSensor();
+    TrackLineRecord& addTrackLine();
+
+    int sensorCount() const { return m_sensors.size(); }
+    int trackLineCount() const { return m_trackLines.size(); }
+
+    /**
+     * @brief Store a string once
+     * @param offset Output, position in the string table
+     * @param length Output, UTF-8 bytes
+     */
+    void addString(const QString& text, quint32& offset, quint32& length);
+
+    /**
+     * @brief Write the file; an existing snapshot is only replaced once
+     * the new one is complete
+     * @return false if the file cannot be written
+     */
+    bool write(const QString& path) const;
+
+private:
+    QVector<EntityRecord> m_entities;
+    QVector<SensorRecord> m_sensors;
+    QVector<TrackLineRecord> m_trackLines;
+    QByteArray m_strings;
+    QHash<QString, quint32> m_stringOffsets;
+};
+
+/**
+ * @brief Maps a snapshot file and checks it before handing out its tables
+ */
+class Reader
+{
+public:
+    Reader();
+    ~Reader();
+
+    /**
+     * @brief Map and validate a snapshot
+     * Checks the header, the table bounds, the id order and every string
+     * and attachment range, so the tables can be used without further checks.
+     * @return false if the file is missing, damaged or of another version
+     */
+    bool open(const QString& path);
+
+    void close();
+
+    int entityCount() const { return m_header ? static_cast<int>(m_header->entityCount) : 0; }
+    const EntityRecord* entities() const { return m_entities; }
+    const SensorRecord* sensors() const { return m_sensors; }
+    const TrackLineRecord* trackLines() const { return m_trackLines; }
+
+    /**
+     * @brief A string of the string table
+     */
+    QString string(quint32 offset, quint32 length) const;
+
+private:
+    bool validate() const;
+
+    QFile m_file;
+    uchar* m_data;
+    qint64 m_size;
+    const Header* m_header;
+    const EntityRecord* m_entities;
+    const SensorRecord* m_sensors;
+    const TrackLineRecord* m_trackLines;
+    const char* m_strings;
+};
+
+} // namespace EntitySnapshot
+
+#endif // ENTITYSNAPSHOT_H
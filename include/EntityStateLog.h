@@ -0,0 +1,153 @@
+#ifndef ENTITYSTATELOG_H
+#define ENTITYSTATELOG_H
+
+#include <QVector>
+#include "EntityManager.h"
+
+/**
+ * @file EntityStateLog.h
+ * @brief Binary log format of recorded EntityState streams
+ *
+ * Written by EntityStateRecorder, read by EntityStateReplayer. All integers
+ * are little-endian.
+ *
+ * File layout:
+ * - file header (16 bytes): magic "ESLG", format version, chunk capacity,
+ *   reserved
+ * - chunks, appended as they fill: chunk header (32 bytes: magic "ESCK",
+ *   state count, payload bytes, reserved, first and last record time) and
+ *   the payload
+ * - index, written by close(): one 32-byte entry per chunk (offset, first
+ *   and last record time, state count, reserved), then a 16-byte trailer
+ *   (index offset, chunk count, magic "ESIX")
+ *
+ * A recording cut off by a crash has no index; the replayer then finds the
+ * chunks by walking their headers and ignores a torn last chunk.
+ *
+ * A chunk payload stores its states column by column, each value as a
+ * zigzag varint:
+ * - record time: milliseconds since recording started, delta to the
+ *   previous state
+ * - entity id: delta to the previous state
+ * - flags: one raw byte (missile, has quaternion, first state of a batch)
+ * - lon, lat (1e-7 degrees), alt (millimetres), heading, pitch, roll
+ *   (1e-4 degrees), timestamp: quantized, delta to the same entity's
+ *   previous state in the chunk
+ * - qx, qy, qz, qw (1e-9): same, only for states with a quaternion
+ *
+ * A feed updates the same entities over and over, so most deltas are a few
+ * units and take one or two bytes; a state of a steadily moving entity
+ * shrinks from 96 bytes in memory to about 20. Chunks reference nothing
+ * outside themselves and are decoded independently, which lets the
+ * replayer seek by chunk.
+ *
+ * Quantization is lossy: positions come back to about 1 cm, attitudes to
+ * 1e-4 degrees.
+ */
+
+namespace EntityStateLog {
+
+const quint32 FILE_MAGIC = 0x474C5345;     // "ESLG"
+const quint32 CHUNK_MAGIC = 0x4B435345;    // "ESCK"
+const quint32 INDEX_MAGIC = 0x58495345;    // "ESIX"
+const quint32 VERSION = 1;
+
+const int FILE_HEADER_SIZE = 16;
+const int CHUNK_HEADER_SIZE = 32;
+const int INDEX_ENTRY_SIZE = 32;
+const int TRAILER_SIZE = 16;
+
+// Flags column
+const uchar FLAG_MISSILE = 0x01;
+const uchar FLAG_QUATERNION = 0x02;
+const uchar FLAG_BATCH_START = 0x04;   // First state of an updateEntityStates() call
+
+/**
+ * @brief Position and time range of one chunk
+ */
+struct ChunkInfo {
+    qint64 offset;          // Of the chunk header in the file
+    int stateCount;
+    qint64 firstTime;       // Record time of the first state (ms)
+    qint64 lastTime;        // Record time of the last state (ms)
+};
+
+inline void putU32(uchar* out, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uchar>(value >> (8 * i));
+    }
+}
+
+inline void putI64(uchar* out, qint64 value)
+{
+    const quint64 bits = static_cast<quint64>(value);
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uchar>(bits >> (8 * i));
+    }
+}
+
+inline quint32 getU32(const uchar* in)
+{
+    quint32 value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<quint32>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline qint64 getI64(const uchar* in)
+{
+    quint64 bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits |= static_cast<quint64>(in[i]) << (8 * i);
+    }
+    return static_cast<qint64>(bits);
+}
+
+/**
+ * @brief Encodes and decodes chunk payloads
+ * Keeps its scratch columns between calls, so a recorder or replayer
+ * holding one allocates only while chunks grow.
+ */
+class ChunkCodec
+{
+public:
+    /**
+     * @brief Encode states into a payload
+     * @param states States of the chunk
+     * @param times Record time of each state (ms)
+     * @param flags FLAG_BATCH_START per state (other bits are derived from the state)
+     * @param count Number of states
+     * @param payload Output, cleared first
+     */
+    void encode(const EntityState* states, const qint64* times, const uchar* flags, int count,
+                QVector<uchar>& payload);
+
+    /**
+     * @brief Decode a payload written by encode()
+     * @param payload Payload bytes
+     * @param size Payload size
+     * @param count State count from the chunk header
+     * @param states Output, count entries
+     * @param times Output, count entries
+     * @param flags Output, count entries
+     * @return false if the payload is malformed
+     */
+    bool decode(const uchar* payload, int size, int count,
+                EntityState* states, qint64* times, uchar* flags);
+
+private:
+    /**
+     * @brief Fill m_previous: index of the same entity's previous state, -1 for the first
+     */
+    void linkPrevious(const EntityState* states, int count);
+
+    QVector<quint64> m_order;       // Entity id (high bits) and state index, sorted
+    QVector<int> m_previous;
+    QVector<qint64> m_column;       // Quantized values of the column being coded
+};
+
+} // namespace EntityStateLog
+
+#endif // ENTITYSTATELOG_H
@@ -0,0 +1,104 @@
+#ifndef ENTITYSTATERECORDER_H
+#define ENTITYSTATERECORDER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "EntityStateLog.h"
+
+/**
+ * @file EntityStateRecorder.h
+ * @brief Captures the EntityState feed into a binary log (EntityStateLog.h)
+ *
+ * Attach to an EntityManager with EntityManager::setStateRecorder(); every
+ * updateEntityState() and updateEntityStates() call is then recorded as
+ * one batch, stamped with the milliseconds since open(). States are
+ * buffered and written a chunk at a time, so recording costs a copy per
+ * state plus one encode and write per chunk.
+ *
+ * The file is append-only: each full chunk is written and flushed as it
+ * fills, and close() writes the last partial chunk and the chunk index.
+ * Without close() (a crash), everything up to the last written chunk can
+ * still be replayed.
+ */
+
+class EntityStateRecorder
+{
+public:
+    /**
+     * @param chunkStates States per chunk - the unit of seeking on replay
+     */
+    explicit EntityStateRecorder(int chunkStates = 4096);
+
+    /**
+     * @brief Closes the log if still open
+     */
+    ~EntityStateRecorder();
+
+    /**
+     * @brief Start a new log, replacing an existing file
+     * @param path Log file
+     * @return false if the file cannot be written
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief Write the buffered states and the index, then close the file
+     * @return false if a write failed at any point since open()
+     */
+    bool close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    /**
+     * @brief Append one batch, stamped with the current record time
+     * @param states Pointer to the first state
+     * @param count Number of states
+     */
+    void record(const EntityState* states, int count);
+
+    void record(const QVector<EntityState>& states)
+    {
+        record(states.constData(), states.size());
+    }
+
+    /**
+     * @brief States recorded since open()
+     */
+    qint64 recordedStates() const { return m_recordedStates; }
+
+    /**
+     * @brief Bytes written to the file so far (buffered states not included)
+     */
+    qint64 bytesWritten() const { return m_bytesWritten; }
+
+private:
+    /**
+     * @brief Encode and write the buffered states as one chunk
+     */
+    void writeChunk();
+
+    /**
+     * @brief Write raw bytes, remembering a failure
+     */
+    void write(const uchar* data, int size);
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+    int m_chunkStates;
+    bool m_failed;
+    qint64 m_recordedStates;
+    qint64 m_bytesWritten;
+
+    // States of the chunk being filled
+    QVector<EntityState> m_states;
+    QVector<qint64> m_times;
+    QVector<uchar> m_flags;
+
+    EntityStateLog::ChunkCodec m_codec;
+    QVector<uchar> m_payload;
+    QVector<EntityStateLog::ChunkInfo> m_index;
+};
+
+#endif // ENTITYSTATERECORDER_H
@@ -0,0 +1,186 @@
+#ifndef ENTITYSTATEREPLAYER_H
+#define ENTITYSTATEREPLAYER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include "EntityStateLog.h"
+
+class EntityManager;
+
+/**
+ * @file EntityStateReplayer.h
+ * @brief Feeds a recorded EntityState log (EntityStateLog.h) into EntityManager
+ *
+ * The log is memory-mapped, and one chunk at a time is decoded into a
+ * reused buffer. Each recorded batch is passed to
+ * EntityManager::updateEntityStates() as it was recorded, so a replay
+ * produces the same ingest calls as the original feed (a batch the
+ * recorder split over two chunks arrives in two calls).
+ *
+ * Playback speed:
+ * - 1: real time - a batch is fed once as much time has passed since
+ *   start() as had passed at recording
+ * - N: N times faster (or slower for N < 1)
+ * - 0: as fast as possible, one chunk per timer tick so the event loop
+ *   keeps running; replayAll() feeds everything without returning
+ *
+ * Entities seen for the first time are created (without a model) unless
+ * setCreateEntities(false) is called, so a log replays into an empty
+ * manager.
+ */
+
+class EntityStateReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param manager Manager to feed, nullptr to only read batches with nextBatch()
+     * @param parent Qt parent object
+     */
+    explicit EntityStateReplayer(EntityManager* manager, QObject* parent = nullptr);
+
+    virtual ~EntityStateReplayer();
+
+    /**
+     * @brief Map a log and position at its start
+     * @param path Log file written by EntityStateRecorder
+     * @return false if the file cannot be mapped or is not a log
+     */
+    bool open(const QString& path);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    /**
+     * @brief Playback speed: 1 = real time, N = N times faster, 0 = as fast as possible
+     */
+    void setSpeed(double speed);
+    double speed() const { return m_speed; }
+
+    /**
+     * @brief Create entities that are not in the manager on first sight (default on)
+     */
+    void setCreateEntities(bool create) { m_createEntities = create; }
+
+    /**
+     * @brief Start timed playback from the current position
+     */
+    void start();
+
+    /**
+     * @brief Pause timed playback; start() resumes
+     */
+    void stop();
+
+    bool isRunning() const { return m_timer->isActive(); }
+
+    /**
+     * @brief Move to the first batch recorded at or after a time
+     * Decodes only the chunk containing it, found through the chunk index.
+     * @param recordTime Milliseconds since recording started
+     * @return false if no log is open
+     */
+    bool seek(qint64 recordTime);
+
+    /**
+     * @brief Feed all remaining batches without waiting
+     * @return Number of states fed
+     */
+    qint64 replayAll();
+
+    /**
+     * @brief Read the next batch without feeding it
+     * A batch split over two chunks is returned in two parts.
+     * @param states Output, valid until the next call, seek() or close()
+     * @return Number of states, 0 at the end of the log
+     */
+    int nextBatch(const EntityState*& states);
+
+    bool atEnd() const;
+
+    /**
+     * @brief Record time of the next batch (ms), duration at the end
+     */
+    qint64 position() const;
+
+    /**
+     * @brief Record time of the last state (ms)
+     */
+    qint64 durationMs() const;
+
+    int chunkCount() const { return m_chunks.size(); }
+    qint64 stateCount() const { return m_stateCount; }
+
+signals:
+    /**
+     * @brief Timed playback reached the end of the log
+     */
+    void finished();
+
+private slots:
+    void onTick();
+
+private:
+    /**
+     * @brief Read the chunk list from the index at the end of the file
+     * @return false if there is no valid index
+     */
+    bool readIndex();
+
+    /**
+     * @brief Build the chunk list by walking the chunk headers
+     * Used for logs without an index; stops at the first torn chunk.
+     */
+    void scanChunks();
+
+    /**
+     * @brief Decode a chunk into the batch buffers
+     * @return false if the chunk is malformed
+     */
+    bool loadChunk(int chunk);
+
+    /**
+     * @brief Decode the next non-empty chunk if the current one is used up
+     * @return false at the end of the log
+     */
+    bool ensureBatch();
+
+    /**
+     * @brief Feed the next batch to the manager
+     * @return Number of states fed
+     */
+    int feedBatch();
+
+    EntityManager* m_manager;
+    QTimer* m_timer;
+    double m_speed;
+    bool m_createEntities;
+
+    QFile m_file;
+    uchar* m_data;                  // Mapped file, nullptr when closed
+    qint64 m_size;
+    QVector<EntityStateLog::ChunkInfo> m_chunks;
+    qint64 m_stateCount;
+
+    // Decoded chunk
+    EntityStateLog::ChunkCodec m_codec;
+    int m_nextChunk;                // Next chunk to decode
+    QVector<EntityState> m_states;
+    QVector<qint64> m_times;
+    QVector<uchar> m_flags;
+    int m_cursor;                   // First state of the next batch
+
+    // Timed playback
+    QElapsedTimer m_clock;
+    qint64 m_playStart;             // Record time at m_clock start
+
+    QSet<int> m_knownIds;           // Entities already checked for existence
+};
+
+#endif // ENTITYSTATEREPLAYER_H
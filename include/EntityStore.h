@@ -0,0 +1,229 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <QVector>
+#include <osg/Polytope>
+#include <osg/Vec3d>
+#include "SpatialHash.h"
+
+class Object3D;
+
+/**
+ * @file EntityStore.h
+ * @brief Structure-of-arrays storage for per-entity data used by batch passes
+ *
+ * EntityManager keeps one dense slot per entity here, next to the
+ * ManagedEntity map. Per-tick passes (camera distance) walk
+ * these contiguous columns instead of chasing Object3D pointers through the
+ * map, so the loops are branch-free and auto-vectorize.
+ *
+ * Columns:
+ * - world position (ECEF, double) - authoritative, written on every update
+ * - geodetic position (lon/lat/alt, double) - written together with it
+ * - bounding radius (float) - for picking
+ * - camera distance (float) - recomputed per tick by
+ *   computeCameraDistances()
+ *
+ * A SpatialHash over the world positions is maintained incrementally by
+ * setPosition() and backs the query*() functions. Queries return slot
+ * indices; EntityManager maps them to entity ids.
+ *
+ * Slots are removed by swapping the last slot in, so indices are only
+ * stable until the next remove(); EntityManager stores each entity's slot
+ * in ManagedEntity::storeIndex and patches the moved one.
+ */
+
+class EntityStore
+{
+public:
+    /**
+     * @brief Entity passed by a ray, see queryRay()
+     */
+    struct RayHit {
+        int index;          // Slot
+        double distance;    // Along the ray to the point closest to the entity centre
+    };
+
+    EntityStore();
+
+    /**
+     * @brief Pre-size all columns
+     * @param capacity Expected entity count
+     */
+    void reserve(int capacity);
+
+    /**
+     * @brief Append a slot
+     * @param entityId Entity identifier
+     * @param object Scene object of the entity (not owned)
+     * @return Slot index
+     */
+    int add(int entityId, Object3D* object);
+
+    /**
+     * @brief Remove a slot by moving the last slot into it
+     * @param index Slot to remove
+     * @return Entity id now stored at index, -1 if the last slot was removed
+     */
+    int remove(int index);
+
+    void clear();
+
+    int size() const { return m_ids.size(); }
+
+    /**
+     * @brief Store an entity's position and re-bucket it in the spatial hash
+     * @param index Slot
+     * @param geodetic Longitude, latitude (degrees) and altitude (meters)
+     * @param world Same position in ECEF
+     */
+    void setPosition(int index, const osg::Vec3d& geodetic, const osg::Vec3d& world)
+    {
+        m_lon[index] = geodetic.x();
+        m_lat[index] = geodetic.y();
+        m_alt[index] = geodetic.z();
+        m_worldX[index] = world.x();
+        m_worldY[index] = world.y();
+        m_worldZ[index] = world.z();
+        m_grid.update(index, world);
+    }
+
+    osg::Vec3d worldPosition(int index) const
+    {
+        return osg::Vec3d(m_worldX[index], m_worldY[index], m_worldZ[index]);
+    }
+
+    /**
+     * @brief Set the radius an entity is hit within by queryRay()
+     * @param index Slot
+     * @param radius World radius in meters
+     */
+    void setBoundingRadius(int index, double radius)
+    {
+        m_radius[index] = static_cast<float>(radius);
+        if (radius > m_maxRadius) {
+            m_maxRadius = radius;
+        }
+    }
+
+    float boundingRadius(int index) const { return m_radius[index]; }
+
+    /**
+     * @brief Batch pass: distances of all entities to the eye
+     * Subtracts in double, computes the (small) result in float.
+     * @param eye Camera position in ECEF
+     */
+    void computeCameraDistances(const osg::Vec3d& eye);
+
+    /**
+     * @brief Camera distance from the last computeCameraDistances()
+     */
+    float distance(int index) const { return m_distance[index]; }
+
+    int entityId(int index) const { return m_ids[index]; }
+    Object3D* object(int index) const { return m_objects[index]; }
+
+    /**
+     * @brief Slots within radius of a point
+     * @param center ECEF point
+     * @param radius Meters
+     * @param indices Output, cleared first, unordered
+     * @return Number of slots found
+     */
+    int queryRadius(const osg::Vec3d& center, double radius, QVector<int>& indices) const;
+
+    /**
+     * @brief The k slots nearest to a point
+     * Searches rings of cells outwards and stops once no unsearched cell
+     * can hold anything closer than the current k-th result.
+     * @param center ECEF point
+     * @param k Number of neighbours
+     * @param indices Output, cleared first, nearest first
+     * @return Number of slots found (less than k if the store is smaller)
+     */
+    int queryNearest(const osg::Vec3d& center, int k, QVector<int>& indices) const;
+
+    /**
+     * @brief Slots inside an axis-aligned ECEF box
+     * @param minCorner Minimum corner
+     * @param maxCorner Maximum corner
+     * @param indices Output, cleared first, unordered
+     * @return Number of slots found
+     */
+    int queryBox(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner, QVector<int>& indices) const;
+
+    /**
+     * @brief Slots inside a longitude/latitude/altitude box
+     * Only the grid cells overlapping the ECEF bounding box of the region
+     * are visited; their entities are tested against the geodetic columns.
+     * minLon > maxLon wraps across the antimeridian (entity longitudes are
+     * expected in [-180, 180]). Altitude ranges reaching half an earth
+     * radius below the ellipsoid or beyond 100,000 km fall back to a scan
+     * of all entities.
+     * @param minLon, maxLon Longitude range in degrees
+     * @param minLat, maxLat Latitude range in degrees
+     * @param minAlt, maxAlt Altitude range in meters
+     * @param indices Output, cleared first, unordered
+     * @return Number of slots found
+     */
+    int queryGeodeticBox(double minLon, double maxLon, double minLat, double maxLat,
+                         double minAlt, double maxAlt, QVector<int>& indices) const;
+
+    /**
+     * @brief Slots inside a convex volume (e.g. a camera frustum in ECEF)
+     * Every occupied cell is tested against the planes, so only entities in
+     * cells crossing or inside the volume are tested; the cost grows with
+     * the number of occupied cells plus the entities found.
+     * @param polytope Planes in ECEF, normals pointing inwards
+     * @param indices Output, cleared first, unordered
+     * @return Number of slots found
+     */
+    int queryPolytope(const osg::Polytope& polytope, QVector<int>& indices) const;
+
+    /**
+     * @brief Entities whose bounding sphere a ray (widened to a cone) passes
+     * An entity is hit when its centre is within boundingRadius() plus
+     * distance * tanTolerance of the ray, so a pixel tolerance stays the
+     * same on screen at any distance. Every occupied grid cell is rejected
+     * by its bounding sphere before any of its entities is tested.
+     * @param origin Ray start in ECEF
+     * @param direction Ray direction (need not be normalized)
+     * @param tanTolerance Tangent of the cone half-angle, 0 for a plain ray
+     * @param hits Output, cleared first, nearest first
+     * @return Number of hits
+     */
+    int queryRay(const osg::Vec3d& origin, const osg::Vec3d& direction, double tanTolerance,
+                 QVector<RayHit>& hits) const;
+
+private:
+    /**
+     * @brief Append the slots in the grid cells covering a box that pass test
+     */
+    template <typename Test>
+    void collectInRange(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner,
+                        Test test, QVector<int>& indices) const;
+
+    QVector<int> m_ids;
+    QVector<Object3D*> m_objects;
+
+    // ECEF world position
+    QVector<double> m_worldX;
+    QVector<double> m_worldY;
+    QVector<double> m_worldZ;
+
+    // Geodetic position
+    QVector<double> m_lon;
+    QVector<double> m_lat;
+    QVector<double> m_alt;
+
+    // Picking
+    QVector<float> m_radius;
+    double m_maxRadius;             // Largest radius ever set since clear()
+
+    // Distance to the eye of the current tick
+    QVector<float> m_distance;
+
+    SpatialHash m_grid;
+};
+
+#endif // ENTITYSTORE_H
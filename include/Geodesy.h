@@ -0,0 +1,167 @@
+#ifndef GEODESY_H
+#define GEODESY_H
+
+#include <osg/Math>
+#include <osg/Matrixd>
+#include <osg/Vec3d>
+#include <cmath>
+
+/**
+ * @file Geodesy.h
+ * @brief WGS84 geodetic <-> ECEF conversions without osg::EllipsoidModel round trips
+ *
+ * osg::EllipsoidModel::computeLocalToWorldTransformFromXYZ() converts the
+ * ECEF position back to latitude/longitude before it can build the ENU
+ * frame, so placing an entity costs a forward and an inverse conversion.
+ * geodeticToEcefEnu() computes the ECEF position and the ENU frame in one
+ * pass from the same sin/cos values.
+ *
+ * ecefToGeodetic() is Vermeille's closed-form inverse (no iteration); it
+ * is exact to well below a millimetre for points further than ~50 km from
+ * the centre of the earth.
+ *
+ * All functions are templates on the scalar type: double for placement,
+ * float where the batch variants feed coarse queries and half the memory
+ * bandwidth matters more than sub-metre precision (float ECEF resolves to
+ * about 0.5 m at the earth's surface).
+ *
+ * Angles are in degrees, like everywhere else in this library.
+ */
+
+namespace Geodesy {
+
+// WGS84 ellipsoid (same as osg::EllipsoidModel defaults)
+static constexpr double WGS84_A = 6378137.0;                    // Semi-major axis (m)
+static constexpr double WGS84_B = 6356752.3142;                 // Semi-minor axis (m)
+static constexpr double WGS84_E2 = 1.0 - (WGS84_B * WGS84_B) / (WGS84_A * WGS84_A);  // First eccentricity squared
+
+/**
+ * @brief Geodetic to ECEF
+ * @param lon Longitude in degrees
+ * @param lat Latitude in degrees
+ * @param alt Height above the ellipsoid in meters
+ * @param x, y, z Output ECEF coordinates in meters
+ */
+template <typename T>
+inline void geodeticToEcef(T lon, T lat, T alt, T& x, T& y, T& z)
+{
+    const T degToRad = static_cast<T>(osg::PI / 180.0);
+    const T lambda = lon * degToRad;
+    const T phi = lat * degToRad;
+
+    const T sinPhi = std::sin(phi), cosPhi = std::cos(phi);
+    const T sinLambda = std::sin(lambda), cosLambda = std::cos(lambda);
+
+    const T a = static_cast<T>(WGS84_A);
+    const T e2 = static_cast<T>(WGS84_E2);
+    const T n = a / std::sqrt(T(1) - e2 * sinPhi * sinPhi);    // Prime vertical radius
+
+    x = (n + alt) * cosPhi * cosLambda;
+    y = (n + alt) * cosPhi * sinLambda;
+    z = (n * (T(1) - e2) + alt) * sinPhi;
+}
+
+/**
+ * @brief Geodetic to ECEF plus the local ENU frame at that point
+ * Same result as EllipsoidModel::convertLatLongHeightToXYZ() followed by
+ * computeLocalToWorldTransformFromXYZ(), without the inverse conversion.
+ * @param lon Longitude in degrees
+ * @param lat Latitude in degrees
+ * @param alt Height above the ellipsoid in meters
+ * @param ecef Output ECEF position
+ * @param localToWorld Output matrix, rows east / north / up / position
+ */
+template <typename T>
+inline void geodeticToEcefEnu(T lon, T lat, T alt, osg::Vec3d& ecef, osg::Matrixd& localToWorld)
+{
+    const T degToRad = static_cast<T>(osg::PI / 180.0);
+    const T lambda = lon * degToRad;
+    const T phi = lat * degToRad;
+
+    const T sinPhi = std::sin(phi), cosPhi = std::cos(phi);
+    const T sinLambda = std::sin(lambda), cosLambda = std::cos(lambda);
+
+    const T a = static_cast<T>(WGS84_A);
+    const T e2 = static_cast<T>(WGS84_E2);
+    const T n = a / std::sqrt(T(1) - e2 * sinPhi * sinPhi);
+
+    const T x = (n + alt) * cosPhi * cosLambda;
+    const T y = (n + alt) * cosPhi * sinLambda;
+    const T z = (n * (T(1) - e2) + alt) * sinPhi;
+    ecef.set(x, y, z);
+
+    // up = ellipsoid normal, east = d/dlon, north = up x east
+    localToWorld.set(-sinLambda,          cosLambda,          T(0),   T(0),
+                     -sinPhi * cosLambda, -sinPhi * sinLambda, cosPhi, T(0),
+                     cosPhi * cosLambda,  cosPhi * sinLambda,  sinPhi, T(0),
+                     x,                   y,                   z,      T(1));
+}
+
+/**
+ * @brief ECEF to geodetic, Vermeille's closed-form solution
+ * @param x, y, z ECEF coordinates in meters
+ * @param lon Output longitude in degrees
+ * @param lat Output latitude in degrees
+ * @param alt Output height above the ellipsoid in meters
+ */
+template <typename T>
+inline void ecefToGeodetic(T x, T y, T z, T& lon, T& lat, T& alt)
+{
+    const T radToDeg = static_cast<T>(180.0 / osg::PI);
+    const T a = static_cast<T>(WGS84_A);
+    const T e2 = static_cast<T>(WGS84_E2);
+    const T e4 = e2 * e2;
+
+    const T xy2 = x * x + y * y;
+    const T xy = std::sqrt(xy2);
+
+    const T p = xy2 / (a * a);
+    const T q = (T(1) - e2) * z * z / (a * a);
+    const T r = (p + q - e4) / T(6);
+    const T s = e4 * p * q / (T(4) * r * r * r);
+    const T t = std::cbrt(T(1) + s + std::sqrt(s * (T(2) + s)));
+    const T u = r * (T(1) + t + T(1) / t);
+    const T v = std::sqrt(u * u + e4 * q);
+    const T w = e2 * (u + v - q) / (T(2) * v);
+    const T k = std::sqrt(u + v + w * w) - w;
+    const T d = k * xy / (k + e2);
+    const T dz = std::sqrt(d * d + z * z);
+
+    lon = std::atan2(y, x) * radToDeg;
+    lat = T(2) * std::atan2(z, d + dz) * radToDeg;
+    alt = (k + e2 - T(1)) / k * dz;
+}
+
+/**
+ * @brief geodeticToEcef() over structure-of-arrays columns
+ * @param lon, lat, alt Input columns (degrees, degrees, meters)
+ * @param count Number of points
+ * @param x, y, z Output columns
+ */
+template <typename T>
+inline void geodeticToEcefBatch(const T* lon, const T* lat, const T* alt, int count, T* x, T* y, T* z)
+{
+    // Plain loop over separate arrays - vectorizes with the compiler's
+    // vector math library
+    for (int i = 0; i < count; ++i) {
+        geodeticToEcef(lon[i], lat[i], alt[i], x[i], y[i], z[i]);
+    }
+}
+
+/**
+ * @brief ecefToGeodetic() over structure-of-arrays columns
+ * @param x, y, z Input columns
+ * @param count Number of points
+ * @param lon, lat, alt Output columns (degrees, degrees, meters)
+ */
+template <typename T>
+inline void ecefToGeodeticBatch(const T* x, const T* y, const T* z, int count, T* lon, T* lat, T* alt)
+{
+    for (int i = 0; i < count; ++i) {
+        ecefToGeodetic(x[i], y[i], z[i], lon[i], lat[i], alt[i]);
+    }
+}
+
+} // namespace Geodesy
+
+#endif // GEODESY_H
@@ -0,0 +1,220 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include "EntityManager.h"
+
+/**
+ * @file LoadGenerator.h
+ * @brief Seeded, deterministic synthetic entity feed for load tests
+ *
+ * Simulates a population of entities, each following one motion model:
+ * - GREAT_CIRCLE: constant speed along a great circle (ships at sea level,
+ *   aircraft-like missiles at cruise altitude)
+ * - ORBIT: circling a fixed centre, banked for the turn
+ * - BALLISTIC: launch to impact over a great-circle ground track, removed
+ *   on impact
+ *
+ * Every entity has its own update rate, drawn at spawn from the configured
+ * distribution, and reports periodically (with a random phase) or with
+ * exponentially distributed gaps. step() advances simulated time and
+ * returns the states that fell due, at most one per entity. Entities come
+ * and go through churn (random removal with replacement, so the population
+ * stays at Config::entityCount) and salvos (bursts of ballistic missiles
+ * from one launch point, not replaced when they impact).
+ *
+ * The output depends only on the configuration (seed included) and the
+ * sequence of step() intervals, not on the thread count or timing:
+ * per-entity randomness is derived from (seed, entity id, draw), and
+ * population decisions are made on the calling thread. States are
+ * evaluated in closed form from the time since spawn, in blocks of
+ * BLOCK_SIZE entities spread over a thread pool, into buffers sized for
+ * Config::capacity entities; nothing is allocated per step while the
+ * population stays below that.
+ *
+ * Motion uses a spherical Earth - good enough for load, not for accuracy.
+ */
+
+class LoadGenerator
+{
+public:
+    enum MotionModel {
+        GREAT_CIRCLE,
+        ORBIT,
+        BALLISTIC
+    };
+
+    enum RateDistribution {
+        RATE_FIXED,         // Every entity at maxUpdateRate
+        RATE_UNIFORM,       // Uniform between minUpdateRate and maxUpdateRate
+        RATE_LOG_UNIFORM    // Log-uniform: as many slow as fast entities per decade
+    };
+
+    enum UpdateTiming {
+        TIMING_PERIODIC,    // Every 1/rate seconds, random phase per entity
+        TIMING_POISSON      // Exponential gaps with mean 1/rate
+    };
+
+    // Entities per unit of parallel work
+    static const int BLOCK_SIZE = 4096;
+
+    struct Config {
+        quint64 seed = 1;
+        int entityCount = 200;              // Population, kept through churn
+        int capacity = 0;                   // Entities the buffers are sized for, 0 = entityCount plus room for salvos
+        int firstId = 0;                    // Ids are handed out upwards from here and never reused
+        int threadCount = 0;                // 0 = one per core
+
+        // Area the entities start in (degrees)
+        double centerLon = 125.0;
+        double centerLat = 30.0;
+        double spanDeg = 20.0;
+
+        // Motion model mix (relative weights) and entity types
+        double greatCircleWeight = 0.6;
+        double orbitWeight = 0.3;
+        double ballisticWeight = 0.1;       // Always missiles
+        double missileFraction = 0.5;       // Of the great-circle and orbit entities
+
+        // Update rates (Hz)
+        RateDistribution rateDistribution = RATE_UNIFORM;
+        UpdateTiming timing = TIMING_PERIODIC;
+        double minUpdateRate = 1.0;
+        double maxUpdateRate = 10.0;
+
+        // Churn: fraction of the population replaced per second
+        double churnRate = 0.0;
+
+        // Salvos: mean launches per second, missiles per launch
+        double salvoRate = 0.0;
+        int salvoSize = 32;
+
+        // EntityState::timestamp (ms) at simulated time 0
+        qint64 startTimestamp = 0;
+
+        // Model paths of spawned entities
+        QString shipModelPath;
+        QString missileModelPath;
+    };
+
+    LoadGenerator();
+    explicit LoadGenerator(const Config& config);
+    ~LoadGenerator();
+
+    /**
+     * @brief Replace the configuration and start over
+     */
+    void setConfig(const Config& config);
+    const Config& config() const { return m_config; }
+
+    /**
+     * @brief Back to time 0 with no entities; the next step() spawns the population
+     */
+    void reset();
+
+    /**
+     * @brief Advance simulated time
+     * The first step after reset() spawns the population at time 0 and
+     * does not advance.
+     * @param dt Seconds
+     * @return Number of states in states()
+     */
+    int step(double dt);
+
+    /**
+     * @brief States of existing entities that fell due in the last step()
+     * Valid until the next step(); in a stable (but unspecified) entity order.
+     */
+    const QVector<EntityState>& states() const { return m_states; }
+
+    /**
+     * @brief Entities that appeared in the last step(), with their first state
+     * Ready for EntityManager::createEntities().
+     */
+    const QVector<EntitySpec>& spawned() const { return m_spawned; }
+
+    /**
+     * @brief Entities removed in the last step() (churn and impacts)
+     */
+    const QVector<int>& despawned() const { return m_despawned; }
+
+    double time() const { return m_time; }
+    int liveCount() const { return m_entities.size(); }
+
+private:
+    class BlockTask;
+
+    struct Entity {
+        int id;
+        EntityState::Type type;
+        MotionModel model;
+        bool salvo;             // Not replaced on impact
+        double spawnTime;       // s
+        double lon0, lat0;      // Start (or orbit centre), radians
+        double bearing;         // Initial bearing (or orbit start angle), radians
+        double speed;           // m/s (orbit: rad/s, signed)
+        double distance;        // Orbit radius or ballistic range (m)
+        double duration;        // Ballistic flight time (s)
+        double altitude;        // Cruise altitude or ballistic apogee (m)
+        double period;          // 1 / update rate (s)
+        double phase;           // Periodic timing: offset of the first update after spawn, [0, 1)
+        double nextDue;         // Time of the next state (s)
+        quint32 updates;        // States emitted, draw counter of Poisson timing
+        bool expired;           // Impacted, removed after the pass
+    };
+
+    /**
+     * @brief Add an entity with a new id; its first state is due immediately
+     * @param model Motion model
+     * @param salvo Part of a salvo (launch point and bearing given)
+     */
+    void spawn(MotionModel model, bool salvo, double lon0 = 0.0, double lat0 = 0.0, double bearing = 0.0);
+
+    /**
+     * @brief Motion model by the configured weights
+     */
+    MotionModel drawModel();
+
+    /**
+     * @brief Remove an entity by moving the last one into its index
+     */
+    void removeAt(int index);
+
+    /**
+     * @brief Evaluate the due entities of one block into their range of m_states (worker threads)
+     */
+    void generateBlock(int block);
+
+    /**
+     * @brief Next uniform value in [0, 1) of the calling thread's population stream
+     */
+    double nextUniform();
+
+    Config m_config;
+    double m_time;
+    bool m_started;
+    int m_nextId;
+    int m_pendingReplacements;  // Impacted population entities to replace in the next step
+    int m_spawnCount;           // Entities spawned in the current step, at the end of m_entities
+    quint64 m_random;           // Population stream state
+
+    QVector<Entity> m_entities;
+    QVector<EntityState> m_states;
+    QVector<EntitySpec> m_spawned;
+    QVector<int> m_despawned;
+    QVector<int> m_blockStates;     // States written per block
+    QVector<int> m_blockExpired;    // Entities that impacted per block
+
+    // Raw views for the workers, set before each pass
+    Entity* m_entityData;
+    EntityState* m_stateData;
+    int m_entityCount;
+    int m_blockCount;
+
+    QThreadPool m_pool;
+    QVector<BlockTask*> m_tasks;    // One per thread, reused every step
+};
+
+#endif // LOADGENERATOR_H
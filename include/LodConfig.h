@@ -9,6 +9,8 @@
  * Adjust these values based on your scene scale and performance requirements.
  */
 
+#include <QtGlobal>
+
 namespace LodConfig {
 
 // Distance thresholds (in meters)
@@ -43,6 +45,24 @@ static constexpr double POSITION_EPSILON = 1e-9;     // Minimum position change
 static constexpr double ATTITUDE_EPSILON = 1e-6;     // Minimum attitude change threshold
 static constexpr int TRACKLINE_UPDATE_SKIP = 3;      // Update track line every N position updates
 
+// Spatial queries
+static constexpr double SPATIAL_CELL_SIZE = 100000.0;       // 100km grid cells for EntityManager::query*()
+
+// Picking
+static constexpr int PICK_REFINE_CANDIDATES = 8;            // Nearest bounding-sphere hits tested against triangles
+
+// Scene partitioning
+static constexpr double SCENE_TILE_DEGREES = 5.0;           // Longitude/latitude tile size of the entity groups
+static constexpr double SCENE_TILE_MIN_ALTITUDE = -1000.0;  // Altitude band the initial tile bound covers
+static constexpr double SCENE_TILE_MAX_ALTITUDE = 30000.0;
+static constexpr double SCENE_TILE_BOUND_SLACK = 1.1;       // Factor on the radius when a tile bound has to grow
+
+// Entity recycling
+static constexpr int ENTITY_POOL_CAPACITY = 256;            // Removed ships / missiles kept for reuse, per type
+
+// Bulk creation
+static constexpr int BULK_CREATE_TASK_SIZE = 1024;          // Entities per worker task of EntityManager::createEntities()
+
 } // namespace LodConfig
 
 #endif // LODCONFIG_H
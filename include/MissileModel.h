@@ -43,12 +43,26 @@ public:
     virtual ~MissileModel();
 
     /**
-     * @brief Load 3D model from file
+     * @brief Load 3D model from file on the calling thread
+     * Shows the placeholder if the file cannot be read.
      * @param modelPath Path to model file
-     * @return true if successful
+     * @return true if the file was loaded
      */
     bool loadModel(const QString& modelPath);
 
+    virtual osg::Node* getModelNode() const { return m_modelNode.get(); }
+
+    /**
+     * @brief Replace only the model child, track lines stay attached
+     * @param model New model, nullptr for the shared placeholder
+     */
+    virtual void setModelNode(osg::Node* model);
+
+    /**
+     * @brief Drop the model and all track lines as well, see Object3D::reset()
+     */
+    virtual void reset();
+
     /**
      * @brief Add a radar track line pointing to a target
      * @param trackLine Track line to add
@@ -0,0 +1,125 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <osg/Node>
+#include <osgUtil/IncrementalCompileOperation>
+#include <atomic>
+
+/**
+ * @file ModelLoader.h
+ * @brief Background model file loading for entity creation
+ *
+ * osgDB::readNodeFile() of a detailed model takes tens to hundreds of
+ * milliseconds. Done on the GUI thread inside createEntity(), every new
+ * model type appearing mid-mission stalls the display. ModelLoader reads
+ * files on its own thread pool instead; EntityManager shows the procedural
+ * placeholder meanwhile and swaps the model in once it is delivered.
+ *
+ * Each path is read once. The result (or the failure, as a null node) is
+ * cached and shared by every entity using the path; a failed path is not
+ * retried.
+ *
+ * With an IncrementalCompileOperation set, a loaded model is handed to it
+ * first and only delivered after its display lists, textures and buffer
+ * objects have been compiled, so the first frame drawing it does not upload
+ * everything at once. The operation must be attached to the viewer
+ * (osgViewer::ViewerBase::setIncrementalCompileOperation()), otherwise the
+ * compile never runs and such models are never delivered.
+ *
+ * All public functions are for the GUI thread; only the workers' hand-over
+ * queue is shared, behind a mutex. takeFinished() checks an atomic counter
+ * first, so polling every tick with nothing finished does not lock or
+ * allocate.
+ */
+
+class ModelLoader
+{
+public:
+    struct Result {
+        QString path;
+        osg::ref_ptr<osg::Node> model;  // nullptr if the file could not be read
+    };
+
+    /**
+     * @param threadCount Concurrent file reads
+     */
+    explicit ModelLoader(int threadCount = 2);
+
+    /**
+     * @brief Waits for reads still running; their results are dropped
+     */
+    ~ModelLoader();
+
+    /**
+     * @brief Pre-compile GL objects before delivering models
+     * @param compileOperation Operation attached to the viewer, nullptr to deliver right after reading
+     */
+    void setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation* compileOperation);
+
+    /**
+     * @brief Look up a model, starting a background read on first use
+     * @param path Model file
+     * @param model Output: the cached model; nullptr while loading or if the read failed
+     * @return true if the path has finished loading (successfully or not),
+     *         false if it is (now) being loaded - wait for takeFinished()
+     */
+    bool request(const QString& path, osg::ref_ptr<osg::Node>& model);
+
+    /**
+     * @brief Collect models that finished since the last call
+     * @param results Output, cleared first
+     * @return Number of results
+     */
+    int takeFinished(QVector<Result>& results);
+
+    /**
+     * @brief Number of paths being read or compiled
+     */
+    int pendingCount() const { return m_pending.size(); }
+
+    /**
+     * @brief Forget all cached models (pending reads still complete)
+     */
+    void clearCache();
+
+private:
+    class ReadTask;
+    class CompileDone;
+
+    /**
+     * @brief Hand a read result to the GUI thread (worker threads)
+     */
+    void postResult(const QString& path, osg::Node* model);
+
+    /**
+     * @brief Store a model in the cache and add it to the output
+     */
+    void deliver(const Result& result, QVector<Result>& results);
+
+    struct Compiling {
+        Result result;
+        osg::ref_ptr<CompileDone> done;
+    };
+
+    QThreadPool m_pool;
+    osg::ref_ptr<osgUtil::IncrementalCompileOperation> m_compileOperation;
+
+    // GUI thread only
+    QHash<QString, osg::ref_ptr<osg::Node>> m_cache;    // Finished paths, null = failed
+    QSet<QString> m_pending;                            // Reading or compiling
+    QVector<Compiling> m_compiling;                     // Read, waiting for the GL compile
+    QVector<Result> m_arrived;                          // Scratch of takeFinished()
+
+    // Shared with the workers
+    QMutex m_resultMutex;
+    QVector<Result> m_results;
+    std::atomic<int> m_resultCount;
+};
+
+#endif // MODELLOADER_H
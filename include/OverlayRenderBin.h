@@ -0,0 +1,87 @@
+#ifndef OVERLAYRENDERBIN_H
+#define OVERLAYRENDERBIN_H
+
+#include <osgUtil/RenderBin>
+#include <osg/BlendFunc>
+#include <osg/Depth>
+#include <osg/StateSet>
+
+/**
+ * @file OverlayRenderBin.h
+ * @brief Dedicated render bin for translucent overlays (sensor volumes, track lines)
+ *
+ * The default TRANSPARENT_BIN sorts every drawable back to front
+ * (O(n log n) per frame) and, with one BlendFunc/Depth object per geode,
+ * changes state for each of them. Overlays instead share one Depth
+ * attribute and go into this bin, which sets the BlendFunc once for all of
+ * them and sorts coarsely:
+ *
+ * - Depth-sorted mode (default): leaves are distributed into NUM_BUCKETS
+ *   depth slices between the nearest and farthest overlay and drawn back
+ *   to front slice by slice. Inside a slice leaves keep their state-graph
+ *   grouping, so the sort is a linear counting sort and state changes only
+ *   happen at slice boundaries.
+ * - Order-independent mode: overlays blend additively (commutative), so no
+ *   depth sort is needed at all and leaves are drawn grouped by state.
+ *   This trades exact "over" compositing for zero sorting cost.
+ *
+ * The bin picks the state set holding the BlendFunc of the current mode
+ * while it is culled. Each mode has its own BlendFunc that is never
+ * changed, so switching modes does not touch state a draw thread may be
+ * applying.
+ *
+ * Overlay state sets are created through sensorStateSet() /
+ * applyOverlayState(); the bin registers itself on first use.
+ */
+
+class OverlayRenderBin : public osgUtil::RenderBin
+{
+public:
+    static const int BIN_NUMBER = 11;           // After TRANSPARENT_BIN (10)
+    static const char* const BIN_NAME;
+    static const int NUM_BUCKETS = 32;          // Depth slices in sorted mode
+
+    OverlayRenderBin();
+    OverlayRenderBin(const OverlayRenderBin& rhs, const osg::CopyOp& copyop = osg::CopyOp::SHALLOW_COPY);
+
+    virtual osg::Object* cloneType() const { return new OverlayRenderBin(); }
+    virtual osg::Object* clone(const osg::CopyOp& copyop) const { return new OverlayRenderBin(*this, copyop); }
+    virtual bool isSameKindAs(const osg::Object* obj) const { return dynamic_cast<const OverlayRenderBin*>(obj) != nullptr; }
+    virtual const char* libraryName() const { return "3d-entity-manager"; }
+    virtual const char* className() const { return "OverlayRenderBin"; }
+
+    virtual void sortImplementation();
+
+    /**
+     * @brief Switch all overlays between depth-sorted and order-independent blending
+     * Takes effect for every overlay at once from the next cull traversal
+     */
+    static void setOrderIndependent(bool enabled);
+    static bool isOrderIndependent();
+
+    /**
+     * @brief State set shared by all sensor volumes (no per-instance state)
+     */
+    static osg::StateSet* sensorStateSet();
+
+    /**
+     * @brief Put a per-instance state set into the overlay bin with the shared attributes
+     */
+    static void applyOverlayState(osg::StateSet* stateSet);
+
+protected:
+    virtual ~OverlayRenderBin() {}
+
+    /**
+     * @brief Register the bin prototype (idempotent)
+     */
+    static void ensureRegistered();
+
+    /**
+     * @brief Bin state set with the BlendFunc of one blending mode
+     */
+    static osg::StateSet* blendStateSet(bool orderIndependent);
+    static osg::Depth* sharedDepth();
+};
+
+#endif // OVERLAYRENDERBIN_H
@@ -0,0 +1,188 @@
+#ifndef PERFINSTRUMENTATION_H
+#define PERFINSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include "TraceRecorder.h"
+
+/**
+ * @file PerfInstrumentation.h
+ * @brief Low-overhead per-phase timers and counters for the entity hot paths
+ *
+ * EntityManager and the geometry classes record how long each phase of the
+ * update takes and how much work it did. Samples go into fixed-size
+ * log-linear histograms (no allocation), which EntityManager rolls over once
+ * per second to report p50/p95/p99 per phase.
+ *
+ * Phases:
+ * - Ingest:        updateEntityState(s) - applying feed data
+ * - LodClassify:   camera distance, LOD level and cull decision per entity
+ * - MatrixRebuild: Object3D::updateIfDirty() for entities due this tick
+ * - ChildLod:      sensor volume / track line LOD updates (geometry rebuilds)
+ * - SceneCommit:   node mask changes pushed into the scene graph
+ * - SensorCoverage: sensor sector tests and detection events (if enabled)
+ *
+ * Compiled in when ENTITY_PERF_INSTRUMENTATION is defined (CMake option
+ * ENABLE_PERF_INSTRUMENTATION); the PERF_* macros expand to nothing
+ * otherwise. At runtime recording only happens while enabled, which
+ * EntityManager::enablePerformanceStats() controls.
+ *
+ * While TraceRecorder is enabled every PERF_SCOPE is also recorded as a trace
+ * event named after its phase.
+ *
+ * Timers must run on the thread that owns the EntityManager; counters may
+ * be bumped from any thread.
+ */
+
+namespace PerfInstrumentation {
+
+enum Phase {
+    PHASE_INGEST = 0,
+    PHASE_LOD_CLASSIFY,
+    PHASE_MATRIX_REBUILD,
+    PHASE_CHILD_LOD,
+    PHASE_SCENE_COMMIT,
+    PHASE_SENSOR_COVERAGE,
+    PHASE_COUNT
+};
+
+enum Counter {
+    COUNTER_MATRICES_REBUILT = 0,   // MatrixTransform::setMatrix calls by Object3D
+    COUNTER_GEOMETRIES_REBUILT,     // SensorVolume / TrackLine rebuildGeometry calls
+    COUNTER_ENTITIES_CULLED,        // Entities beyond DISTANCE_FAR, summed over ticks
+    COUNTER_COUNT
+};
+
+const char* phaseName(Phase phase);
+const char* counterName(Counter counter);
+
+/**
+ * @brief Log-linear latency histogram (8 sub-buckets per power of two)
+ * Relative bucket error is below 12.5%; values are in nanoseconds.
+ */
+class Histogram
+{
+public:
+    static const int SUB_BUCKETS = 8;
+    static const int MAX_OCTAVE = 40;   // ~18 minutes, larger values are clamped
+    static const int NUM_BUCKETS = SUB_BUCKETS + (MAX_OCTAVE - 2) * SUB_BUCKETS;
+
+    Histogram() { reset(); }
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const { return m_count; }
+    uint64_t total() const { return m_total; }
+    uint64_t max() const { return m_max; }
+
+    /**
+     * @brief Value at the given percentile (0-100), upper bound of its bucket
+     */
+    uint64_t percentile(double p) const;
+
+private:
+    static int bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(int index);
+
+    uint32_t m_buckets[NUM_BUCKETS];
+    uint64_t m_count;
+    uint64_t m_total;
+    uint64_t m_max;
+};
+
+struct PhaseSummary {
+    uint64_t samples;
+    double totalMs;
+    double p50Ms;
+    double p95Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+/**
+ * @brief Aggregated statistics of one reporting window
+ */
+struct WindowReport {
+    double seconds;                          // Window length
+    PhaseSummary phases[PHASE_COUNT];
+    uint64_t counters[COUNTER_COUNT];
+};
+
+/**
+ * @brief Runtime switch - timers and counters are no-ops while disabled
+ */
+void setEnabled(bool enabled);
+
+inline std::atomic<bool>& enabledFlag()
+{
+    static std::atomic<bool> s_enabled(false);
+    return s_enabled;
+}
+
+inline bool isEnabled()
+{
+    return enabledFlag().load(std::memory_order_relaxed);
+}
+
+void recordPhase(Phase phase, uint64_t ns);
+void addCount(Counter counter, uint64_t n = 1);
+
+/**
+ * @brief Summarize the current window and start a new one
+ * @param seconds Length of the window being closed
+ */
+WindowReport takeWindow(double seconds);
+
+/**
+ * @brief Times the enclosing scope into one phase histogram (and the trace)
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Phase phase)
+        : m_phase(phase)
+        , m_timing(isEnabled())
+        , m_tracing(TraceRecorder::isEnabled())
+        , m_start((m_timing || m_tracing) ? TraceRecorder::nowNs() : 0)
+    {}
+
+    ~ScopedTimer()
+    {
+        if (m_timing || m_tracing) {
+            uint64_t end = TraceRecorder::nowNs();
+            if (m_timing) {
+                recordPhase(m_phase, end - m_start);
+            }
+            if (m_tracing) {
+                TraceRecorder::record(phaseName(m_phase), "entity", m_start, end);
+            }
+        }
+    }
+
+private:
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+
+    Phase m_phase;
+    bool m_timing;
+    bool m_tracing;
+    uint64_t m_start;
+};
+
+} // namespace PerfInstrumentation
+
+#define PERF_CONCAT_IMPL(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_IMPL(a, b)
+
+#ifdef ENTITY_PERF_INSTRUMENTATION
+#define PERF_SCOPE(phase) \
+    PerfInstrumentation::ScopedTimer PERF_CONCAT(perfScope_, __LINE__)(PerfInstrumentation::phase)
+#define PERF_COUNT(counter, n) \
+    do { if (PerfInstrumentation::isEnabled()) PerfInstrumentation::addCount(PerfInstrumentation::counter, (n)); } while (0)
+#else
+#define PERF_SCOPE(phase) do {} while (0)
+#define PERF_COUNT(counter, n) do {} while (0)
+#endif
+
+#endif // PERFINSTRUMENTATION_H
@@ -0,0 +1,133 @@
+#ifndef SENSORCOVERAGE_H
+#define SENSORCOVERAGE_H
+
+#include <QHash>
+#include <QVector>
+#include <osg/Vec3d>
+#include "EntityStore.h"
+
+class ShipModel;
+class SensorVolume;
+
+/**
+ * @file SensorCoverage.h
+ * @brief Which entities are inside which ship's sensor volumes
+ *
+ * For every registered ship and every SensorVolume attached to it, update()
+ * asks the EntityStore grid for the entities within sensor range and tests
+ * them against the sector in the ship's body frame - the same frame the
+ * volume is drawn in (ENU at the ship, rotated by its attitude, scaled by
+ * its model scale). The sector test works on gathered coordinate columns
+ * with no trigonometry and no branches, so the compiler vectorizes it:
+ * - range:     |d|^2 <= radius^2
+ * - elevation: |d| sin(eleStart) <= up <= |d| sin(eleEnd)
+ * - azimuth:   2D cross products against the start and end bearings
+ *
+ * Each sensor keeps its sorted detection set from the previous tick; the
+ * difference to the new set becomes enter/exit events. Once the scratch
+ * columns have grown to the largest candidate count, update() allocates
+ * nothing.
+ *
+ * EntityManager owns one instance, registers its ships and forwards the
+ * events as signals, see EntityManager::setSensorCoverageEnabled().
+ */
+
+class SensorCoverage
+{
+public:
+    struct Event {
+        int shipId;         // Entity owning the sensor
+        int sensorIndex;    // Index in ShipModel::getSensorVolumes()
+        int targetId;       // Detected entity
+        bool entered;       // true = entered the sector, false = left it
+    };
+
+    SensorCoverage();
+
+    /**
+     * @brief Start evaluating a ship's sensors
+     * @param entityId Entity id of the ship
+     * @param ship Ship model (not owned, must outlive the registration)
+     */
+    void addShip(int entityId, ShipModel* ship);
+
+    /**
+     * @brief Stop evaluating a ship's sensors
+     * Queues exit events for everything its sensors detected.
+     */
+    void removeShip(int entityId);
+
+    /**
+     * @brief Forget all ships and detections without events
+     */
+    void clear();
+
+    /**
+     * @brief Recompute all detection sets and append the changes to events()
+     * @param store Entity positions and spatial index
+     */
+    void update(const EntityStore& store);
+
+    /**
+     * @brief Changes since the last clearEvents()
+     */
+    const QVector<Event>& events() const { return m_events; }
+    void clearEvents() { m_events.resize(0); }
+
+    /**
+     * @brief Current detections of one sensor
+     * @param shipId Entity id of the ship
+     * @param sensorIndex Index in ShipModel::getSensorVolumes()
+     * @param targetIds Output, cleared first, ascending entity ids
+     * @return false if the ship or sensor is unknown
+     */
+    bool getDetections(int shipId, int sensorIndex, QVector<int>& targetIds) const;
+
+    /**
+     * @brief Number of (sensor, target) pairs detected in the last update()
+     */
+    int detectionCount() const { return m_detectionCount; }
+
+private:
+    struct SensorState {
+        const SensorVolume* volume;
+        QVector<int> detected;          // Ascending entity ids
+    };
+
+    struct Site {
+        int entityId;
+        ShipModel* ship;
+        QVector<SensorState> sensors;
+    };
+
+    /**
+     * @brief Match the sensor states to the ship's current sensor list
+     * Sensors that were removed or replaced report exits for their detections.
+     */
+    void syncSensors(Site& site);
+
+    /**
+     * @brief Evaluate one sensor and record the differences to its last set
+     */
+    void updateSensor(const EntityStore& store, const Site& site, int sensorIndex,
+                      SensorState& state, const osg::Vec3d& origin, const double axes[3][3],
+                      double scale);
+
+    void appendExits(int shipId, int sensorIndex, const QVector<int>& targetIds);
+
+    QVector<Site> m_sites;
+    QHash<int, int> m_siteIndex;        // Ship entity id -> index in m_sites
+
+    QVector<Event> m_events;
+    int m_detectionCount;
+
+    // Scratch columns, reused every sensor and tick
+    QVector<int> m_candidates;
+    QVector<double> m_dx;
+    QVector<double> m_dy;
+    QVector<double> m_dz;
+    QVector<unsigned char> m_inside;
+    QVector<int> m_current;
+};
+
+#endif // SENSORCOVERAGE_H
@@ -37,12 +37,26 @@ public:
     virtual ~ShipModel();
 
     /**
-     * @brief Load 3D model from file
+     * @brief Load 3D model from file on the calling thread
+     * Shows the placeholder if the file cannot be read.
      * @param modelPath Path to model file
-     * @return true if successful
+     * @return true if the file was loaded
      */
     bool loadModel(const QString& modelPath);
 
+    virtual osg::Node* getModelNode() const { return m_modelNode.get(); }
+
+    /**
+     * @brief Replace only the model child, sensor volumes stay attached
+     * @param model New model, nullptr for the shared placeholder
+     */
+    virtual void setModelNode(osg::Node* model);
+
+    /**
+     * @brief Drop the model and all sensor volumes as well, see Object3D::reset()
+     */
+    virtual void reset();
+
     /**
      * @brief Add a fixed sensor volume (e.g., radar coverage)
      * The sensor volume will be attached to the ship and move with it
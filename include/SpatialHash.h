@@ -0,0 +1,93 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <QHash>
+#include <QVector>
+#include <osg/Vec3d>
+
+/**
+ * @file SpatialHash.h
+ * @brief Uniform ECEF grid over EntityStore slots for neighbour and range queries
+ *
+ * Every slot lives in exactly one cube-shaped cell. Cells are keyed by their
+ * packed integer coordinates in a QHash, and each slot remembers its cell
+ * and its position inside the cell's list, so insert, move between cells and
+ * removal are O(1) (swap-remove inside the cell).
+ *
+ * update() only touches the hash when a slot actually crosses a cell
+ * boundary; moving inside a cell is two compares. Empty cells are kept so
+ * entities oscillating across a boundary do not allocate.
+ *
+ * The grid only knows slot indices; EntityStore owns the positions and runs
+ * the exact per-entity tests on the candidates.
+ */
+
+class SpatialHash
+{
+public:
+    typedef QVector<int> Cell;
+
+    /**
+     * @param cellSize Edge length of a cell in meters
+     */
+    explicit SpatialHash(double cellSize);
+
+    double cellSize() const { return m_cellSize; }
+
+    /**
+     * @brief Integer cell coordinate of a position along one axis
+     */
+    int cellCoord(double v) const;
+
+    static quint64 packKey(int ix, int iy, int iz);
+    static void unpackKey(quint64 key, int& ix, int& iy, int& iz);
+
+    /**
+     * @brief Add a new slot (must equal the current slot count)
+     */
+    void insert(int slot, const osg::Vec3d& position);
+
+    /**
+     * @brief Re-bucket a slot after its position changed
+     */
+    void update(int slot, const osg::Vec3d& position);
+
+    /**
+     * @brief Remove a slot, mirroring EntityStore::remove()
+     * Takes slot out of its cell and relabels the last slot to slot, the
+     * same swap EntityStore applies to its columns.
+     */
+    void remove(int slot);
+
+    void clear();
+
+    /**
+     * @brief Slots in a cell, nullptr if the cell was never used
+     */
+    const Cell* cell(int ix, int iy, int iz) const;
+
+    /**
+     * @brief All cells ever used (possibly empty), for full scans
+     */
+    const QHash<quint64, Cell>& cells() const { return m_cells; }
+
+    /**
+     * @brief Number of cells that currently hold at least one slot
+     */
+    int occupiedCellCount() const { return m_occupiedCells; }
+
+private:
+    quint64 keyOf(const osg::Vec3d& position) const;
+    void addToCell(int slot, quint64 key);
+    void removeFromCell(int slot);
+
+    double m_cellSize;
+    double m_inverseCellSize;
+
+    QHash<quint64, Cell> m_cells;
+    QVector<quint64> m_slotKey;     // Cell of each slot
+    QVector<int> m_slotOffset;      // Index of the slot inside its cell
+    int m_occupiedCells;
+};
+
+#endif // SPATIALHASH_H
@@ -0,0 +1,94 @@
+#ifndef TRACECALLBACKS_H
+#define TRACECALLBACKS_H
+
+#include <osg/Camera>
+#include <osg/Node>
+#include <osg/NodeCallback>
+#include <atomic>
+#include "TraceRecorder.h"
+
+/**
+ * @file TraceCallbacks.h
+ * @brief OSG update/cull/draw hooks for TraceRecorder
+ *
+ * TraceTraversalCallback wraps the traversal of a node (as outermost update
+ * or cull callback) so the whole subgraph traversal shows up as one event;
+ * the update one also reports frame starts for hitch detection.
+ * TraceDrawCallback uses the camera's initial/final draw callbacks to time
+ * the draw of that camera and reports frame ends.
+ *
+ * @code
+ * TraceCallbacks::attach(viewer->getSceneData(), viewer->getCamera());
+ * @endcode
+ */
+
+/**
+ * @brief Times the traversal below a node (update or cull)
+ */
+class TraceTraversalCallback : public osg::NodeCallback
+{
+public:
+    /**
+     * @param name Event name, must outlive the callback (string literal)
+     * @param frameStart Report the traversal start as frame start (update)
+     */
+    explicit TraceTraversalCallback(const char* name, bool frameStart = false)
+        : m_name(name)
+        , m_frameStart(frameStart)
+    {}
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        if (m_frameStart && nv->getFrameStamp()) {
+            TraceRecorder::frameStarted(nv->getFrameStamp()->getFrameNumber(), TraceRecorder::nowNs());
+        }
+        TraceScope scope(m_name, "osg");
+        traverse(node, nv);
+    }
+
+private:
+    const char* m_name;
+    bool m_frameStart;
+};
+
+/**
+ * @brief Times a camera's draw and marks the end of each frame
+ * Installed in pairs: a DRAW_BEGIN callback as the camera's initial draw
+ * callback and a DRAW_END partner referencing it as the final one.
+ */
+class TraceDrawCallback : public osg::Camera::DrawCallback
+{
+public:
+    enum Mode {
+        DRAW_BEGIN,
+        DRAW_END
+    };
+
+    /**
+     * @param mode Which end of the draw this callback marks
+     * @param begin DRAW_BEGIN partner (required for DRAW_END)
+     */
+    explicit TraceDrawCallback(Mode mode, TraceDrawCallback* begin = nullptr);
+
+    virtual void operator()(osg::RenderInfo& renderInfo) const;
+
+private:
+    Mode m_mode;
+    osg::ref_ptr<TraceDrawCallback> m_begin;
+    mutable std::atomic<uint64_t> m_beginNs;
+};
+
+namespace TraceCallbacks {
+
+/**
+ * @brief Install update/cull traversal timers and camera draw timers
+ * Existing update/cull callbacks of the node are kept (nested inside the
+ * trace callback); the camera's initial/final draw callbacks are replaced.
+ * @param sceneData Node whose update and cull traversals are traced
+ * @param camera Camera whose draw is traced, may be nullptr
+ */
+void attach(osg::Node* sceneData, osg::Camera* camera);
+
+} // namespace TraceCallbacks
+
+#endif // TRACECALLBACKS_H
@@ -0,0 +1,156 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file TraceRecorder.h
+ * @brief Opt-in timeline tracing with Chrome Trace Event JSON export
+ *
+ * Records complete events (name, begin, duration) into a fixed ring buffer
+ * per thread. Writers never lock or allocate after the first event of a
+ * thread; the ring keeps the most recent TraceRecorder::BUFFER_CAPACITY
+ * events per thread, so a dump always shows the seconds leading up to it.
+ * The buffer of a finished thread stays in dumps until a new thread
+ * takes it over, so recycled pool threads do not add memory.
+ *
+ * Dumps open directly in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Sources:
+ * - EntityManager ticks and their phases (PERF_SCOPE also emits a trace event)
+ * - SensorVolume / TrackLine geometry rebuilds
+ * - ShipModel / MissileModel model loads, ModelLoader background reads
+ * - OSG update / cull / draw (see TraceCallbacks.h)
+ *
+ * Usage:
+ * @code
+ * TraceRecorder::setEnabled(true);
+ * TraceRecorder::setHitchThreshold(50.0, "./traces");  // Dump frames > 50ms
+ * ...
+ * TraceRecorder::dumpToFile("trace.json");              // Or on demand
+ * @endcode
+ *
+ * Compiled in together with ENTITY_PERF_INSTRUMENTATION.
+ */
+
+class TraceRecorder
+{
+public:
+    static const int BUFFER_CAPACITY = 1 << 16;    // Events per thread
+
+    /**
+     * @brief Start/stop recording (off by default)
+     */
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Monotonic clock used for all events
+     * @return Nanoseconds since an arbitrary fixed point
+     */
+    static uint64_t nowNs();
+
+    /**
+     * @brief Record a complete event on the calling thread
+     * @param name Event name, must outlive the recorder (string literal)
+     * @param category Event category, must outlive the recorder
+     * @param beginNs Start time from nowNs()
+     * @param endNs End time from nowNs()
+     */
+    static void record(const char* name, const char* category, uint64_t beginNs, uint64_t endNs);
+
+    /**
+     * @brief Name the calling thread in the trace (e.g. "main", "draw")
+     * @param name Thread name, must outlive the recorder
+     */
+    static void setThreadName(const char* name);
+
+    /**
+     * @brief Write all buffered events as Chrome Trace Event JSON
+     * Safe to call while other threads keep recording; events overwritten
+     * during the dump are left out.
+     * @param path Output file
+     * @return true if the file was written
+     */
+    static bool dumpToFile(const QString& path);
+
+    /**
+     * @brief Dump automatically when a frame takes longer than the threshold
+     * @param frameMs Frame time threshold in milliseconds, <= 0 disables
+     * @param outputDir Directory for trace-<timestamp>.json files
+     */
+    static void setHitchThreshold(double frameMs, const QString& outputDir);
+
+    /**
+     * @brief Report the start of a frame (from the traced update traversal)
+     * @param frameNumber osg::FrameStamp frame number
+     * @param frameStartNs Time from nowNs()
+     */
+    static void frameStarted(unsigned int frameNumber, uint64_t frameStartNs);
+
+    /**
+     * @brief Report the end of a rendered frame (from TraceDrawCallback)
+     * The frame time runs from frameStarted() of the same frame number, so
+     * a draw overlapping the next frame's update is still measured right.
+     * Only flags a pending dump; the file is written by pollAutoDump().
+     * @param frameNumber osg::FrameStamp frame number
+     * @param frameEndNs Time from nowNs()
+     */
+    static void frameFinished(unsigned int frameNumber, uint64_t frameEndNs);
+
+    /**
+     * @brief Write a pending hitch dump, called from EntityManager::updateAll()
+     */
+    static void pollAutoDump();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief Records the enclosing scope as one trace event
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char* name, const char* category)
+        : m_name(name)
+        , m_category(category)
+        , m_active(TraceRecorder::isEnabled())
+        , m_begin(m_active ? TraceRecorder::nowNs() : 0)
+    {}
+
+    ~TraceScope()
+    {
+        if (m_active) {
+            TraceRecorder::record(m_name, m_category, m_begin, TraceRecorder::nowNs());
+        }
+    }
+
+private:
+    TraceScope(const TraceScope&);
+    TraceScope& operator=(const TraceScope&);
+
+    const char* m_name;
+    const char* m_category;
+    bool m_active;
+    uint64_t m_begin;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef ENTITY_PERF_INSTRUMENTATION
+#define ENTITY_TRACE_SCOPE(category, name) \
+    TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#else
+#define ENTITY_TRACE_SCOPE(category, name) do {} while (0)
+#endif
+
+#endif // TRACERECORDER_H
@@ -3,6 +3,7 @@
 
 #include <osg/MatrixTransform>
 #include <osg/Geode>
+#include <osg/Quat>
 #include <osg/Vec3d>
 #include <osg/Vec4>
 #include <osg/Switch>
@@ -25,6 +26,13 @@
  * Scene graph hierarchy with LOD:
  * earth -> lodSwitch -> [0] once -> modelGroup (3D model)
  *                    -> [1] billboardNode (2D image)
+ *
+ * Flattened hierarchy (setFlattenedTransform(true)):
+ * earth(scale * rotation * localToWorld) -> lodSwitch -> [0] modelGroup
+ *                                                     -> [1] billboardScale -> billboardNode
+ * One matrix per entity instead of two, so cull pushes one model-view
+ * matrix per entity. billboardScale undoes the model scale for the image
+ * and only sits on the far LOD branch.
  * 
  * LOD behavior (two-level strategy):
  * - < 500km: Show full 3D model
@@ -52,12 +60,21 @@ public:
      * Uses epsilon comparison to skip insignificant changes
      */
     void setAttitude(double heading, double pitch, double roll);
+
+    /**
+     * @brief Set attitude as a quaternion (ENU frame, same convention as
+     * AttitudeUtils::eulerToQuat)
+     * Used as is for the local matrix - no Euler round trip
+     */
+    void setAttitude(const osg::Quat& attitude);
     
     /**
      * @brief Set scale factor for the model
      */
     void setScale(double scale);
     
+    double getScale() const { return m_scale; }
+    
     /**
      * @brief Set visibility of the object
      */
@@ -70,16 +87,99 @@ public:
     osg::Vec3d getPosition() const { return osg::Vec3d(m_longitude, m_latitude, m_altitude); }
     
     /**
-     * @brief Get current attitude
+     * @brief Get current attitude (heading, pitch, roll in degrees)
+     * Converted from the quaternion if the attitude was set as one
+     */
+    osg::Vec3d getAttitude() const;
+
+    /**
+     * @brief Get current attitude as a quaternion
+     */
+    osg::Quat getAttitudeQuat() const;
+
+    /**
+     * @brief true if the attitude was last set as a quaternion
+     */
+    bool isQuaternionAttitude() const { return m_quatAttitude; }
+
+    /**
+     * @brief Get position in world (ECEF) coordinates
+     * Cached by updateIfDirty(), so it reflects the last applied position
+     */
+    const osg::Vec3d& getWorldPosition() const { return m_worldPosition; }
+
+    /**
+     * @brief ENU frame at the current position (rows east / north / up / position)
+     * Cached by updateIfDirty() like getWorldPosition()
+     */
+    const osg::Matrixd& getLocalToWorld() const { return m_localToWorld; }
+
+    /**
+     * @brief Scale * rotation applied to the model below the ENU frame
+     * Cached by updateIfDirty()
+     */
+    const osg::Matrixd& getLocalMatrix() const { return m_localMatrix; }
+
+    /**
+     * @brief The loaded 3D model without attachments (sensors, track lines)
+     * @return nullptr in the base class
+     */
+    virtual osg::Node* getModelNode() const { return nullptr; }
+
+    /**
+     * @brief Replace the model, keeping attachments next to it
+     * Used to swap in models loaded in the background.
+     * @param model New model (may be shared between entities), nullptr for
+     *        the type's placeholder; ignored in the base class
+     */
+    virtual void setModelNode(osg::Node* /*model*/) {}
+
+    /**
+     * @brief Radius around the world position enclosing what is drawn
+     * The larger of the scaled model bound and the billboard, in meters.
+     * Attachments such as sensor volumes are not included.
      */
-    osg::Vec3d getAttitude() const { return osg::Vec3d(m_heading, m_pitch, m_roll); }
+    double getBoundingRadius() const;
+
+    /**
+     * @brief Radius around the world position enclosing the whole entity subgraph
+     * Unlike getBoundingRadius() this includes attachments (sensor
+     * volumes, track lines) and both LOD branches, whichever is shown. Uses
+     * the scene graph's cached bounds, so it is cheap unless the
+     * attachments changed.
+     */
+    double getExtentRadius() const;
+
+    /**
+     * @brief true while the LOD switch shows the 3D model, false for the billboard
+     */
+    bool isModelShown() const { return !m_lodSwitch.valid() || m_lodSwitch->getValue(0); }
     
+    /**
+     * @brief Return to the state of a freshly constructed object
+     * Position, attitude, scale, visibility, LOD distances and the billboard
+     * go back to their defaults, so the object and its scene graph can be
+     * handed out again instead of being rebuilt (see EntityPool). The
+     * transform mode and render origin are left to the next owner.
+     * Subclasses also drop their model and attachments.
+     */
+    virtual void reset();
+
     /**
      * @brief Update transforms if dirty flags are set
      * Call this before rendering to apply pending changes
      */
     void updateIfDirty();
     
+    /**
+     * @brief Compose position, attitude and scale into the root transform
+     * Removes the once transform from the traversed graph; the result is
+     * recomputed by updateIfDirty() only when one of the inputs changed.
+     * @param flattened true for the single-matrix hierarchy
+     */
+    void setFlattenedTransform(bool flattened);
+    bool isFlattenedTransform() const { return m_flattened; }
+
     /**
      * @brief Get the root transform node for the scene graph
      */
@@ -87,8 +187,9 @@ public:
     
     /**
      * @brief Get the model node (for track line attachment, etc.)
+     * In flattened mode this is the model group below the root transform
      */
-    osg::Node* modelObject() { return m_onceTransform.get(); }
+    osg::Node* modelObject() { return m_flattened ? static_cast<osg::Node*>(m_modelGroup.get()) : m_onceTransform.get(); }
     
     /**
      * @brief Set Billboard image (PNG format, transparent background)
@@ -97,6 +198,27 @@ public:
      * @param height Height of the billboard in meters (default: 50000.0)
      */
     void setBillboardImage(const QString& imagePath, double width = 50000.0, double height = 50000.0);
+
+    /**
+     * @brief Set the billboard from a texture already loaded from imagePath
+     * Lets many entities share one texture (see loadBillboardTexture())
+     * instead of each reading the image file.
+     * @param texture Shared texture, nullptr if the image could not be loaded
+     */
+    void setBillboardImage(const QString& imagePath, osg::Texture2D* texture, double width, double height);
+
+    /**
+     * @brief Read a billboard image into a texture usable by setBillboardImage()
+     * @return nullptr if the image cannot be read
+     */
+    static osg::ref_ptr<osg::Texture2D> loadBillboardTexture(const QString& imagePath);
+
+    /**
+     * @brief Billboard image and size last set, empty path without billboard
+     */
+    const QString& getBillboardImage() const { return m_billboardImage; }
+    double getBillboardWidth() const { return m_billboardWidth; }
+    double getBillboardHeight() const { return m_billboardHeight; }
     
     /**
      * @brief Set LOD distance thresholds
@@ -109,6 +231,7 @@ public:
      * - Never auto-hides; hiding only via setVisible(false)
      */
     void setLODDistances(double nearDist, double farDist);
+    double getLODNearDistance() const { return m_nearDistance; }
     
     /**
      * @brief Update LOD based on camera position (call per frame or periodically)
@@ -128,14 +251,24 @@ protected:
      * Only called when attitude or scale changes
      */
     void updateOnceTransform();
+
+    /**
+     * @brief Write the composed matrix into the root transform (flattened mode)
+     */
+    void updateFlattenedTransform();
+
+    /**
+     * @brief Put the model and billboard branches under the LOD switch for the current mode
+     */
+    void attachLodChildren();
     
     /**
-     * @brief Create billboard from image file
-     * @param imagePath Path to the image file
+     * @brief Create billboard from a loaded image texture
+     * @param texture Image texture, nothing is created for nullptr
      * @param width Width of the billboard in meters
      * @param height Height of the billboard in meters
      */
-    void createBillboard(const QString& imagePath, double width, double height);
+    void createBillboard(osg::Texture2D* texture, double width, double height);
 
     // Cached EllipsoidModel to avoid creating it every time
     static osg::ref_ptr<osg::EllipsoidModel> s_ellipsoid;
@@ -145,17 +278,25 @@ protected:
     double m_longitude;
     double m_latitude;
     double m_altitude;
+    osg::Vec3d m_worldPosition;     // ECEF of the above, updated with the earth transform
+    osg::Matrixd m_localToWorld;    // ENU frame at m_worldPosition
+    osg::Matrixd m_localMatrix;     // Scale * rotation
     
-    // Attitude (degrees)
+    // Attitude (degrees), or a quaternion when m_quatAttitude is set
     double m_heading;
     double m_pitch;
     double m_roll;
+    osg::Quat m_attitudeQuat;
+    bool m_quatAttitude;
     
     // Scale
     double m_scale;
     
     // Visibility
     bool m_visible;
+
+    // Single-matrix hierarchy, see setFlattenedTransform()
+    bool m_flattened;
     
     // Dirty flags - track what needs updating
     bool m_positionDirty;
@@ -170,8 +311,13 @@ protected:
     // LOD support with Billboard
     osg::ref_ptr<osg::Billboard>       m_billboardNode;   // Billboard image node
     osg::ref_ptr<osg::Switch>          m_lodSwitch;       // LOD switch control
+    osg::ref_ptr<osg::MatrixTransform> m_billboardScale;  // Inverse model scale (flattened mode only)
     
     double m_nearDistance = 500000.0;   // 500km - show 3D model
+    double m_billboardRadius = 0.0;     // Half diagonal of the billboard quad, 0 without billboard
+    QString m_billboardImage;           // Path given to setBillboardImage()
+    double m_billboardWidth = 0.0;
+    double m_billboardHeight = 0.0;
     double m_farDistance  = 2000000.0;  // Deprecated - no longer used in two-level LOD
 };
 
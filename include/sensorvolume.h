@@ -3,10 +3,9 @@
 
 #include <osg/Geometry>
 #include <osg/Geode>
+#include <osg/MatrixTransform>
 #include <osg/Vec3>
 #include <osg/Vec4>
-#include <osg/BlendFunc>
-#include <osg/Depth>
 #include "LodConfig.h"
 
 /**
@@ -22,6 +21,14 @@
  * - Level 2 (Low):  40° steps - ~24 vertices
  * 
  * Performance: LOD can reduce GPU load by 15x at distance.
+ * The mesh is a closed sector: outer spherical surface plus the walls
+ * fanned to the apex. Unit-radius vertex arrays are shared by all volumes
+ * with the same angles and LOD, 16-bit index buffers by all volumes with
+ * the same grid size, so a LOD switch only swaps shared buffers.
+ * setColor() only touches the volume's own single-element color array.
+ *
+ * The mesh is built with unit radius under a scale transform, so setRadius()
+ * is a single matrix write: scaleTransform -> geode (unit sector).
  */
 
 class SensorVolume : public osg::Referenced
@@ -52,7 +59,12 @@ public:
     virtual ~SensorVolume();
 
     /**
-     * @brief Get the geode containing the sensor volume geometry
+     * @brief Get the node to attach to the scene graph (radius scale transform)
+     */
+    osg::Node* getNode() { return m_scaleTransform.get(); }
+
+    /**
+     * @brief Get the geode containing the unit-radius sensor volume geometry
      */
     osg::Geode* getGeode() { return m_geode.get(); }
 
@@ -71,12 +83,23 @@ public:
 
     /**
      * @brief Update sensor parameters
+     * setColor() and setRadius() do not rebuild the geometry
      */
     void setRadius(double radius);
     void setColor(const osg::Vec4& color);
     void setAngles(double azimuthStart, double azimuthEnd, 
                    double elevationStart, double elevationEnd);
 
+    /**
+     * @brief Sensor parameters (radius in meters, angles in degrees)
+     */
+    double getRadius() const { return m_radius; }
+    const osg::Vec4& getColor() const { return m_color; }
+    double getAzimuthStart() const { return m_azimuthStart; }
+    double getAzimuthEnd() const { return m_azimuthEnd; }
+    double getElevationStart() const { return m_elevationStart; }
+    double getElevationEnd() const { return m_elevationEnd; }
+
 protected:
     /**
      * @brief Rebuild geometry with current LOD level
@@ -84,7 +107,8 @@ protected:
     void rebuildGeometry();
 
     /**
-     * @brief Create vertices for the sensor volume
+     * @brief Create unit-radius vertices for the sensor volume
+     * Grid of azimuth x elevation samples followed by the apex (origin)
      */
     void createVertices(osg::Vec3Array* vertices, 
                        int azimuthStep, 
@@ -102,9 +126,11 @@ protected:
     int m_currentLodLevel;
     bool m_visible;
 
-    // Geometry
+    // Geometry - vertex and index buffers are shared, see rebuildGeometry()
+    osg::ref_ptr<osg::MatrixTransform> m_scaleTransform;   // Scales the unit mesh to m_radius
     osg::ref_ptr<osg::Geode> m_geode;
     osg::ref_ptr<osg::Geometry> m_geometry;
+    osg::ref_ptr<osg::Vec4Array> m_colors;          // Single BIND_OVERALL color
 };
 
 #endif // SENSORVOLUME_H
@@ -23,6 +23,14 @@
  * - Level 2 (Low):  40 layers  - Low smooth
  * 
  * Performance: Update frequency reduced (every 3rd position update)
+ * The cylinder is an indexed triangle list connecting consecutive rings.
+ * Its vertex array and 16-bit index buffer are shared by every track line
+ * with the same layer count, so a LOD switch only swaps shared buffers;
+ * setColor() only touches the track line's own single-element color array.
+ *
+ * The cylinder is built with unit radius and length; the vertex shader
+ * scales it by the trackScale uniform (radius, radius, length), so
+ * setLength() / setRadius() are a single uniform write.
  */
 
 class TrackLine : public osg::Referenced
@@ -67,12 +75,23 @@ public:
 
     /**
      * @brief Update track line parameters
+     * setColor(), setLength() and setRadius() do not rebuild the geometry
      */
     void setLength(double length);
     void setRadius(double radius);
     void setColor(const osg::Vec4& color);
     void setLayers(int layers);
 
+    double getLength() const { return m_length; }
+    double getRadius() const { return m_radius; }
+    const osg::Vec4& getColor() const { return m_color; }
+
+    /**
+     * @brief Width and speed passed to the constructor
+     */
+    double getWidth() const { return m_width; }
+    double getSpeed() const { return m_speed; }
+
     /**
      * @brief Update pulse animation time (called by GlobalPulseTimeCallback)
      */
@@ -100,6 +119,17 @@ protected:
      */
     void setupShader();
 
+    /**
+     * @brief Pulse shader program shared by all track lines
+     */
+    static osg::Program* sharedProgram();
+    static osg::Program* createProgram();
+
+    /**
+     * @brief Push radius/length into the trackScale uniform and the bound
+     */
+    void updateScale();
+
     // Track line parameters
     double m_length;
     double m_radius;
@@ -112,15 +142,16 @@ protected:
     int m_currentLodLevel;
     bool m_visible;
 
-    // Geometry
+    // Geometry - vertex and index buffers are shared, see rebuildGeometry()
     osg::ref_ptr<osg::Geode> m_geode;
     osg::ref_ptr<osg::Geometry> m_geometry;
+    osg::ref_ptr<osg::Vec4Array> m_colors;          // Single BIND_OVERALL color
 
     // Shader uniforms
     osg::ref_ptr<osg::Uniform> m_pulseTimeUniform;
     osg::ref_ptr<osg::Uniform> m_widthUniform;
     osg::ref_ptr<osg::Uniform> m_speedUniform;
-    osg::ref_ptr<osg::Program> m_program;
+    osg::ref_ptr<osg::Uniform> m_scaleUniform;      // vec3(radius, radius, length)
 };
 
 #endif // TRACKLINE_H
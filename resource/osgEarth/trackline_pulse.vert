@@ -2,15 +2,19 @@
 
 // Vertex shader for animated track line pulse effect
 uniform float pulseTime;
+uniform vec3 trackScale;    // (radius, radius, length) applied to the unit cylinder
 varying float vHeight;
 
 void main()
 {
+    // Scale the unit mesh to the track line size
+    vec4 vertex = vec4(gl_Vertex.xyz * trackScale, 1.0);
+
     // Pass vertex height to fragment shader
-    vHeight = gl_Vertex.z;
+    vHeight = vertex.z;
     
     // Transform vertex to clip space
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
     
     // Pass through color
     gl_FrontColor = gl_Color;
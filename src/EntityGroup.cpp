@@ -0,0 +1,67 @@
+#include "EntityGroup.h"
+
+EntityGroup::EntityGroup()
+    : m_hasFixedBound(false)
+{
+}
+
+EntityGroup::~EntityGroup()
+{
+}
+
+unsigned int EntityGroup::addEntity(osg::Node* node, int entityId)
+{
+    unsigned int index = getNumChildren();
+    addChild(node);
+    m_entityIds.append(entityId);
+    return index;
+}
+
+int EntityGroup::removeEntity(unsigned int index)
+{
+    if (index >= getNumChildren()) {
+        return -1;
+    }
+
+    unsigned int last = getNumChildren() - 1;
+
+    if (index == last) {
+        removeChildren(last, 1);
+        m_entityIds.resize(last);
+        return -1;
+    }
+
+    // setChild() drops the removed node's parent link and keeps the update
+    // traversal counts right; the last node is briefly listed twice, and
+    // removing the tail entry then takes its duplicate parent link away
+    setChild(index, getChild(last));
+    removeChildren(last, 1);
+
+    m_entityIds[index] = m_entityIds[last];
+    m_entityIds.resize(last);
+    return m_entityIds[index];
+}
+
+void EntityGroup::clearEntities()
+{
+    removeChildren(0, getNumChildren());
+    m_entityIds.resize(0);
+}
+
+void EntityGroup::setFixedBound(const osg::BoundingSphere& bound)
+{
+    m_fixedBound = bound;
+    m_hasFixedBound = true;
+    dirtyBound();
+}
+
+void EntityGroup::clearFixedBound()
+{
+    m_hasFixedBound = false;
+    dirtyBound();
+}
+
+osg::BoundingSphere EntityGroup::computeBound() const
+{
+    return m_hasFixedBound ? m_fixedBound : osg::Group::computeBound();
+}
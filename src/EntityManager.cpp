@@ -1,7 +1,168 @@
 #include "EntityManager.h"
+#include "EntitySnapshot.h"
+#include "EntityStateRecorder.h"
+#include "Geodesy.h"
+#include "OverlayRenderBin.h"
 #include <QDebug>
+#include <QRunnable>
+#include <osg/LineWidth>
+#include <osgDB/ReadFile>
+#include <osgUtil/IntersectionVisitor>
+#include <osgUtil/LineSegmentIntersector>
+#include <algorithm>
 #include <cmath>
 
+namespace {
+
+// Marker radius relative to the entity's bounding radius
+const double HIGHLIGHT_MARKER_SCALE = 1.2;
+
+// Scene tiles along each axis, see sceneTileKey()
+const int SCENE_TILE_COLUMNS = static_cast<int>(std::ceil(360.0 / LodConfig::SCENE_TILE_DEGREES));
+const int SCENE_TILE_ROWS = static_cast<int>(std::ceil(180.0 / LodConfig::SCENE_TILE_DEGREES));
+
+/**
+ * @brief Index of the longitude/latitude tile containing a position
+ */
+int sceneTileKey(double lon, double lat)
+{
+    int column = static_cast<int>(std::floor((lon + 180.0) / LodConfig::SCENE_TILE_DEGREES));
+    int row = static_cast<int>(std::floor((lat + 90.0) / LodConfig::SCENE_TILE_DEGREES));
+    column = std::max(0, std::min(SCENE_TILE_COLUMNS - 1, column));
+    row = std::max(0, std::min(SCENE_TILE_ROWS - 1, row));
+    return row * SCENE_TILE_COLUMNS + column;
+}
+
+/**
+ * @brief Sphere around a tile's cell between the configured altitudes
+ * Centred on the cell middle; the radius covers a 5x5 grid of cell points
+ * at both altitudes, plus slack for the curvature between them.
+ */
+void sceneTileBound(int tileKey, osg::Vec3d& center, double& radius)
+{
+    const double deg = LodConfig::SCENE_TILE_DEGREES;
+    const double minAlt = LodConfig::SCENE_TILE_MIN_ALTITUDE;
+    const double maxAlt = LodConfig::SCENE_TILE_MAX_ALTITUDE;
+    double lon0 = (tileKey % SCENE_TILE_COLUMNS) * deg - 180.0;
+    double lat0 = (tileKey / SCENE_TILE_COLUMNS) * deg - 90.0;
+    double lon1 = std::min(lon0 + deg, 180.0);
+    double lat1 = std::min(lat0 + deg, 90.0);
+
+    Geodesy::geodeticToEcef(0.5 * (lon0 + lon1), 0.5 * (lat0 + lat1), 0.5 * (minAlt + maxAlt),
+                            center.x(), center.y(), center.z());
+
+    const int samples = 5;
+    double radius2 = 0.0;
+    for (int i = 0; i < samples; ++i) {
+        for (int j = 0; j < samples; ++j) {
+            double lon = lon0 + (lon1 - lon0) * i / (samples - 1);
+            double lat = lat0 + (lat1 - lat0) * j / (samples - 1);
+            for (double alt : { minAlt, maxAlt }) {
+                osg::Vec3d p;
+                Geodesy::geodeticToEcef(lon, lat, alt, p.x(), p.y(), p.z());
+                radius2 = std::max(radius2, (p - center).length2());
+            }
+        }
+    }
+    radius = std::sqrt(radius2) * 1.01;
+}
+
+/**
+ * @brief Shared highlight marker: three unit great circles in the overlay bin
+ */
+osg::Geode* highlightMarker()
+{
+    static osg::ref_ptr<osg::Geode> marker = [] {
+        const int segments = 64;
+        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(3 * segments);
+        for (int i = 0; i < segments; ++i) {
+            double angle = 2.0 * osg::PI * i / segments;
+            float c = static_cast<float>(std::cos(angle));
+            float s = static_cast<float>(std::sin(angle));
+            (*vertices)[i].set(c, s, 0.0f);
+            (*vertices)[segments + i].set(c, 0.0f, s);
+            (*vertices)[2 * segments + i].set(0.0f, c, s);
+        }
+
+        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array(1);
+        (*colors)[0].set(1.0f, 0.9f, 0.1f, 0.9f);
+
+        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry();
+        geometry->setVertexArray(vertices.get());
+        geometry->setColorArray(colors.get(), osg::Array::BIND_OVERALL);
+        for (int circle = 0; circle < 3; ++circle) {
+            geometry->addPrimitiveSet(new osg::DrawArrays(GL_LINE_LOOP, circle * segments, segments));
+        }
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode();
+        geode->addDrawable(geometry.get());
+        osg::StateSet* ss = geode->getOrCreateStateSet();
+        OverlayRenderBin::applyOverlayState(ss);
+        ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        ss->setAttributeAndModes(new osg::LineWidth(2.0f));
+        return geode;
+    }();
+    return marker.get();
+}
+
+/**
+ * @brief One entity of a createEntities() batch
+ */
+struct BuildJob {
+    const EntitySpec* spec;
+    osg::ref_ptr<Object3D> object;  // Pooled object, or nullptr until a worker builds one
+};
+
+/**
+ * @brief Build missing objects and apply the initial transforms
+ * Touches nothing but the jobs' own objects, which are not in the scene
+ * graph yet, so ranges can run on separate threads.
+ */
+void buildObjects(BuildJob* jobs, int count, bool flattened)
+{
+    for (int i = 0; i < count; ++i) {
+        BuildJob& job = jobs[i];
+        const EntityState& state = job.spec->state;
+        if (!job.object.valid()) {
+            if (state.type == EntityState::SHIP) {
+                job.object = EntityPool::createShip();
+            } else {
+                job.object = EntityPool::createMissile();
+            }
+        }
+
+        Object3D* object = job.object.get();
+        object->setFlattenedTransform(flattened);
+        object->setPosition(state.lon, state.lat, state.alt);
+        if (state.hasQuaternion) {
+            object->setAttitude(osg::Quat(state.qx, state.qy, state.qz, state.qw));
+        } else {
+            object->setAttitude(state.heading, state.pitch, state.roll);
+        }
+        object->updateIfDirty();
+    }
+}
+
+class BuildTask : public QRunnable
+{
+public:
+    BuildTask(BuildJob* jobs, int count, bool flattened)
+        : m_jobs(jobs), m_count(count), m_flattened(flattened)
+    {}
+
+    virtual void run()
+    {
+        buildObjects(m_jobs, m_count, m_flattened);
+    }
+
+private:
+    BuildJob* m_jobs;
+    int m_count;
+    bool m_flattened;
+};
+
+} // namespace
+
 EntityManager::EntityManager(
     osg::Group* sceneRoot,
     GlobalPulseTimeCallback* pulseCallback,
@@ -11,12 +172,25 @@ EntityManager::EntityManager(
     , m_sceneRoot(sceneRoot)
     , m_pulseCallback(pulseCallback)
     , m_camera(camera)
+    , m_cameraPosition(0.0, 0.0, 0.0)
     , m_performanceStatsEnabled(false)
     , m_lastStatsTime(0)
     , m_frameCount(0)
+    , m_lastReport()
     , m_sensorVolumesVisible(true)
     , m_trackLinesVisible(true)
+    , m_flattenedTransforms(false)
+    , m_sensorCoverageEnabled(false)
+    , m_asyncModelLoading(true)
+    , m_stateRecorder(nullptr)
 {
+    m_entityRoot = new osg::Group();
+    m_tileRoot = new osg::Group();
+    m_entityRoot->addChild(m_tileRoot.get());
+    if (m_sceneRoot.valid()) {
+        m_sceneRoot->addChild(m_entityRoot.get());
+    }
+
     m_updateTimer = new QTimer(this);
     connect(m_updateTimer, &QTimer::timeout, this, &EntityManager::updateAll);
 }
@@ -24,6 +198,9 @@ EntityManager::EntityManager(
 EntityManager::~EntityManager()
 {
     clearAllEntities();
+    if (m_sceneRoot.valid()) {
+        m_sceneRoot->removeChild(m_entityRoot.get());
+    }
 }
 
 bool EntityManager::createEntity(int entityId, EntityState::Type type, const QString& modelPath)
@@ -41,80 +218,497 @@ bool EntityManager::createEntity(int entityId, EntityState::Type type, const QSt
     managed.lastDistance = 0;
     managed.lastUpdateTime = QDateTime::currentMSecsSinceEpoch();
     managed.visible = true;
+    managed.object = acquireObject(type, modelPath);
+    initEntity(managed, modelPath);
+
+    m_entities.insert(entityId, managed);
+    return true;
+}
+
+int EntityManager::createEntities(const QVector<EntitySpec>& specs)
+{
+    return createEntities(specs.constData(), specs.size());
+}
+
+int EntityManager::createEntities(const EntitySpec* specs, int count)
+{
+    // In id order: duplicates end up next to each other, and ids above
+    // every existing one are appended to the map without a search
+    QVector<BuildJob> jobs;
+    jobs.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        BuildJob job;
+        job.spec = &specs[i];
+        jobs.append(job);
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [](const BuildJob& a, const BuildJob& b) {
+        return a.spec->state.entityId < b.spec->state.entityId;
+    });
+
+    int kept = 0;
+    for (int i = 0; i < jobs.size(); ++i) {
+        const EntityState& state = jobs[i].spec->state;
+        if (m_entities.contains(state.entityId)
+            || (kept > 0 && jobs[kept - 1].spec->state.entityId == state.entityId)) {
+            qWarning() << "Entity" << state.entityId << "already exists";
+            continue;
+        }
+        if (state.type != EntityState::SHIP && state.type != EntityState::MISSILE) {
+            qWarning() << "Entity" << state.entityId << "has an unknown type";
+            continue;
+        }
+        jobs[kept++] = jobs[i];
+    }
+    jobs.resize(kept);
+    if (jobs.isEmpty()) {
+        return 0;
+    }
 
-    // Create appropriate entity type
+    m_store.reserve(m_store.size() + kept);
+    m_dueEntities.reserve(m_entities.size() + kept);
+    m_visibilityChanges.reserve(m_entities.size() + kept);
+
+    // The pool is not thread-safe: hand out recycled objects here, the
+    // workers construct the rest
+    int freeShips = m_pool.freeShipCount();
+    int freeMissiles = m_pool.freeMissileCount();
+    for (BuildJob& job : jobs) {
+        if (job.spec->state.type == EntityState::SHIP && freeShips > 0) {
+            job.object = m_pool.acquireShip().get();
+            --freeShips;
+        }
+        else if (job.spec->state.type == EntityState::MISSILE && freeMissiles > 0) {
+            job.object = m_pool.acquireMissile().get();
+            --freeMissiles;
+        }
+    }
+
+    // Build and place in parallel; this thread takes the last range
+    const int taskSize = LodConfig::BULK_CREATE_TASK_SIZE;
+    int begin = 0;
+    for (; begin + taskSize < kept; begin += taskSize) {
+        m_buildPool.start(new BuildTask(jobs.data() + begin, taskSize, m_flattenedTransforms));
+    }
+    buildObjects(jobs.data() + begin, kept - begin, m_flattenedTransforms);
+    m_buildPool.waitForDone();
+
+    // Commit: models, store, tiles and the map in one pass. Models are
+    // shared nodes (every attach adds a parent to them), so this stays on
+    // the calling thread.
+    QHash<QString, osg::ref_ptr<osg::Node>> models;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const bool append = m_entities.isEmpty() || jobs.first().spec->state.entityId > m_entities.lastKey();
+    for (BuildJob& job : jobs) {
+        const EntitySpec& spec = *job.spec;
+
+        ManagedEntity managed;
+        managed.entityId = spec.state.entityId;
+        managed.type = spec.state.type;
+        managed.lodLevel = 1; // Start with medium LOD
+        managed.lastDistance = 0;
+        managed.lastUpdateTime = now;
+        managed.visible = true;
+        managed.object = job.object;
+
+        // Read once per path instead of once per entity
+        if (!m_asyncModelLoading && !spec.modelPath.isEmpty()) {
+            auto model = models.constFind(spec.modelPath);
+            if (model == models.constEnd()) {
+                model = models.insert(spec.modelPath, osgDB::readNodeFile(spec.modelPath.toStdString()));
+            }
+            managed.object->setModelNode(model.value().get());
+        }
+        initEntity(managed, spec.modelPath);
+
+        if (append) {
+            m_entities.insert(m_entities.constEnd(), managed.entityId, managed);
+        } else {
+            m_entities.insert(managed.entityId, managed);
+        }
+    }
+
+    if (m_stateRecorder) {
+        QVector<EntityState> states;
+        states.reserve(kept);
+        for (const BuildJob& job : jobs) {
+            states.append(job.spec->state);
+        }
+        m_stateRecorder->record(states);
+    }
+
+    return kept;
+}
+
+osg::ref_ptr<Object3D> EntityManager::acquireObject(EntityState::Type type, const QString& modelPath)
+{
+    // Recycled from removed entities where possible; asynchronously loaded
+    // models are assigned by initEntity(), the synchronous read happens here
+    const bool loadNow = !m_asyncModelLoading && !modelPath.isEmpty();
     if (type == EntityState::SHIP) {
-        ShipModel* ship = new ShipModel(0, 0, 0, 1.0, modelPath);
-        managed.object = ship;
-        
-        // Add to scene
-        if (m_sceneRoot.valid()) {
-            m_sceneRoot->addChild(ship->getModelTransform());
+        osg::ref_ptr<ShipModel> ship = m_pool.acquireShip();
+        if (loadNow) {
+            ship->loadModel(modelPath);
         }
+        return ship.get();
     }
-    else if (type == EntityState::MISSILE) {
-        MissileModel* missile = new MissileModel(0, 0, 0, 0, 0, 0, 1.0, modelPath);
-        managed.object = missile;
-        
-        // Add to scene
-        if (m_sceneRoot.valid()) {
-            m_sceneRoot->addChild(missile->getModelTransform());
+    if (type == EntityState::MISSILE) {
+        osg::ref_ptr<MissileModel> missile = m_pool.acquireMissile();
+        if (loadNow) {
+            missile->loadModel(modelPath);
         }
+        return missile.get();
+    }
+    return nullptr;
+}
+
+void EntityManager::initEntity(ManagedEntity& managed, const QString& modelPath)
+{
+    managed.modelPath = modelPath;
+    if (!managed.object.valid()) {
+        return;
+    }
+
+    if (m_asyncModelLoading && !modelPath.isEmpty()) {
+        assignModel(managed, modelPath);
+    }
+
+    // Apply the initial transforms so the cached world position is valid
+    managed.object->setFlattenedTransform(m_flattenedTransforms);
+    managed.object->updateIfDirty();
+
+    // Add to scene
+    managed.extent = managed.object->getExtentRadius();
+    attachToTile(managed, sceneTileKey(managed.object->getPosition().x(), managed.object->getPosition().y()));
+
+    managed.storeIndex = m_store.add(managed.entityId, managed.object.get());
+    m_store.setPosition(managed.storeIndex, managed.object->getPosition(), managed.object->getWorldPosition());
+    m_store.setBoundingRadius(managed.storeIndex, managed.object->getBoundingRadius());
+
+    if (m_sensorCoverageEnabled && managed.type == EntityState::SHIP) {
+        m_coverage.addShip(managed.entityId, dynamic_cast<ShipModel*>(managed.object.get()));
+    }
+}
+
+bool EntityManager::saveSnapshot(const QString& path) const
+{
+    EntitySnapshot::Writer snapshot;
+    snapshot.reserve(m_entities.size());
+
+    // QMap iterates by ascending id, the order restoreSnapshot() relies on
+    for (auto it = m_entities.constBegin(); it != m_entities.constEnd(); ++it) {
+        const ManagedEntity& entity = it.value();
+        if (!entity.object.valid()) {
+            continue;
+        }
+        const Object3D& object = *entity.object;
+
+        EntitySnapshot::EntityRecord& record = snapshot.addEntity();
+        record.entityId = entity.entityId;
+        record.type = static_cast<quint8>(entity.type);
+        record.lodLevel = static_cast<quint8>(entity.lodLevel);
+        record.lastUpdateTime = entity.lastUpdateTime;
+        snapshot.addString(entity.modelPath, record.modelPathOffset, record.modelPathLength);
+
+        const osg::Vec3d position = object.getPosition();
+        record.lon = position.x();
+        record.lat = position.y();
+        record.alt = position.z();
+        if (object.isQuaternionAttitude()) {
+            const osg::Quat q = object.getAttitudeQuat();
+            record.qx = q.x();
+            record.qy = q.y();
+            record.qz = q.z();
+            record.qw = q.w();
+            record.flags |= EntitySnapshot::FLAG_QUATERNION;
+        } else {
+            const osg::Vec3d attitude = object.getAttitude();
+            record.heading = attitude.x();
+            record.pitch = attitude.y();
+            record.roll = attitude.z();
+        }
+        record.scale = object.getScale();
+        record.nearDistance = object.getLODNearDistance();
+        if (object.isVisible()) {
+            record.flags |= EntitySnapshot::FLAG_VISIBLE;
+        }
+        if (!object.getBillboardImage().isEmpty()) {
+            record.flags |= EntitySnapshot::FLAG_BILLBOARD;
+            snapshot.addString(object.getBillboardImage(), record.billboardOffset, record.billboardLength);
+            record.billboardWidth = object.getBillboardWidth();
+            record.billboardHeight = object.getBillboardHeight();
+        }
+
+        if (const ShipModel* ship = dynamic_cast<const ShipModel*>(&object)) {
+            record.firstAttachment = static_cast<quint32>(snapshot.sensorCount());
+            for (const osg::ref_ptr<SensorVolume>& volume : ship->getSensorVolumes()) {
+                EntitySnapshot::SensorRecord& sensor = snapshot.addSensor();
+                sensor.radius = volume->getRadius();
+                sensor.azimuthStart = volume->getAzimuthStart();
+                sensor.azimuthEnd = volume->getAzimuthEnd();
+                sensor.elevationStart = volume->getElevationStart();
+                sensor.elevationEnd = volume->getElevationEnd();
+                for (int c = 0; c < 4; ++c) {
+                    sensor.color[c] = volume->getColor()[c];
+                }
+                sensor.lodLevel = static_cast<quint8>(volume->getLodLevel());
+                sensor.visible = volume->isVisible() ? 1 : 0;
+            }
+            record.attachmentCount = static_cast<quint32>(snapshot.sensorCount()) - record.firstAttachment;
+        }
+        else if (const MissileModel* missile = dynamic_cast<const MissileModel*>(&object)) {
+            record.firstAttachment = static_cast<quint32>(snapshot.trackLineCount());
+            for (const osg::ref_ptr<TrackLine>& line : missile->getTrackLines()) {
+                EntitySnapshot::TrackLineRecord& trackLine = snapshot.addTrackLine();
+                trackLine.length = line->getLength();
+                trackLine.radius = line->getRadius();
+                trackLine.width = line->getWidth();
+                trackLine.speed = line->getSpeed();
+                for (int c = 0; c < 4; ++c) {
+                    trackLine.color[c] = line->getColor()[c];
+                }
+                trackLine.lodLevel = static_cast<quint8>(line->getLodLevel());
+                trackLine.visible = line->isVisible() ? 1 : 0;
+            }
+            record.attachmentCount = static_cast<quint32>(snapshot.trackLineCount()) - record.firstAttachment;
+        }
+    }
+
+    return snapshot.write(path);
+}
+
+bool EntityManager::restoreSnapshot(const QString& path)
+{
+    EntitySnapshot::Reader snapshot;
+    if (!snapshot.open(path)) {
+        return false;
+    }
+
+    clearAllEntities();
+
+    // Entities of one model share its path string; decode each once
+    QHash<quint32, QString> paths;
+    auto pathAt = [&](quint32 offset, quint32 length) -> QString {
+        if (length == 0) {
+            return QString();
+        }
+        auto it = paths.constFind(offset);
+        if (it == paths.constEnd()) {
+            it = paths.insert(offset, snapshot.string(offset, length));
+        }
+        return it.value();
+    };
+
+    const int count = snapshot.entityCount();
+    const EntitySnapshot::EntityRecord* records = snapshot.entities();
+    QVector<EntitySpec> specs(count);
+    for (int i = 0; i < count; ++i) {
+        const EntitySnapshot::EntityRecord& record = records[i];
+        EntityState& state = specs[i].state;
+        state.entityId = record.entityId;
+        state.type = static_cast<EntityState::Type>(record.type);
+        state.lon = record.lon;
+        state.lat = record.lat;
+        state.alt = record.alt;
+        if (record.flags & EntitySnapshot::FLAG_QUATERNION) {
+            state.hasQuaternion = true;
+            state.qx = record.qx;
+            state.qy = record.qy;
+            state.qz = record.qz;
+            state.qw = record.qw;
+        } else {
+            state.heading = record.heading;
+            state.pitch = record.pitch;
+            state.roll = record.roll;
+        }
+        specs[i].modelPath = pathAt(record.modelPathOffset, record.modelPathLength);
+    }
+    createEntities(specs);
+
+    // The map now holds exactly the snapshot's entities, in the same order
+    QHash<QString, osg::ref_ptr<osg::Texture2D>> billboardTextures;
+    int i = 0;
+    for (auto it = m_entities.begin(); it != m_entities.end(); ++it, ++i) {
+        const EntitySnapshot::EntityRecord& record = records[i];
+        ManagedEntity& managed = it.value();
+        Object3D* object = managed.object.get();
+
+        managed.lodLevel = record.lodLevel;
+        managed.lastUpdateTime = record.lastUpdateTime;
+        managed.visible = (record.flags & EntitySnapshot::FLAG_VISIBLE) != 0;
+        object->setVisible(managed.visible);
+        object->setScale(record.scale);
+        object->setLODDistances(record.nearDistance, 0.0);
+        if (record.flags & EntitySnapshot::FLAG_BILLBOARD) {
+            // Read each distinct image once and share its texture
+            const QString image = pathAt(record.billboardOffset, record.billboardLength);
+            auto texture = billboardTextures.constFind(image);
+            if (texture == billboardTextures.constEnd()) {
+                texture = billboardTextures.insert(image, Object3D::loadBillboardTexture(image));
+            }
+            object->setBillboardImage(image, texture.value().get(), record.billboardWidth, record.billboardHeight);
+        }
+
+        if (ShipModel* ship = dynamic_cast<ShipModel*>(object)) {
+            for (quint32 s = 0; s < record.attachmentCount; ++s) {
+                const EntitySnapshot::SensorRecord& r = snapshot.sensors()[record.firstAttachment + s];
+                SensorVolume* sensor = new SensorVolume(r.radius,
+                                                        osg::Vec4(r.color[0], r.color[1], r.color[2], r.color[3]),
+                                                        r.azimuthStart, r.azimuthEnd,
+                                                        r.elevationStart, r.elevationEnd);
+                sensor->setLodLevel(r.lodLevel);
+                sensor->setVisible(r.visible != 0);
+                ship->addFixedWave(sensor);
+            }
+        }
+        else if (MissileModel* missile = dynamic_cast<MissileModel*>(object)) {
+            for (quint32 t = 0; t < record.attachmentCount; ++t) {
+                const EntitySnapshot::TrackLineRecord& r = snapshot.trackLines()[record.firstAttachment + t];
+                TrackLine* trackLine = new TrackLine(r.length, r.radius,
+                                                     osg::Vec4(r.color[0], r.color[1], r.color[2], r.color[3]),
+                                                     r.width, r.speed);
+                trackLine->setLodLevel(r.lodLevel);
+                trackLine->setVisible(r.visible != 0);
+                missile->addRadarTrackLine(trackLine);
+                if (m_pulseCallback.valid()) {
+                    m_pulseCallback->addTrackLine(trackLine);
+                }
+            }
+        }
+
+        // Scale, billboard and attachments change the bounds
+        object->updateIfDirty();
+        m_store.setBoundingRadius(managed.storeIndex, object->getBoundingRadius());
+        managed.extent = object->getExtentRadius();
+        fitTileBound(managed);
     }
 
-    m_entities.insert(entityId, managed);
     return true;
 }
 
 void EntityManager::updateEntityState(const EntityState& state)
 {
-    if (!m_entities.contains(state.entityId)) {
+    PERF_SCOPE(PHASE_INGEST);
+    if (m_stateRecorder) {
+        m_stateRecorder->record(&state, 1);
+    }
+    applyEntityState(state);
+}
+
+void EntityManager::applyEntityState(const EntityState& state)
+{
+    // Single lookup - this runs for every state of every batch
+    auto it = m_entities.find(state.entityId);
+    if (it == m_entities.end()) {
         qWarning() << "Entity" << state.entityId << "not found";
         return;
     }
 
-    ManagedEntity& entity = m_entities[state.entityId];
+    ManagedEntity& entity = it.value();
     
     // Update position and attitude
     if (entity.object.valid()) {
         entity.object->setPosition(state.lon, state.lat, state.alt);
-        entity.object->setAttitude(state.heading, state.pitch, state.roll);
+        if (state.hasQuaternion) {
+            entity.object->setAttitude(osg::Quat(state.qx, state.qy, state.qz, state.qw));
+        } else {
+            entity.object->setAttitude(state.heading, state.pitch, state.roll);
+        }
         entity.object->updateIfDirty();
+        m_store.setPosition(entity.storeIndex, entity.object->getPosition(), entity.object->getWorldPosition());
+
+        // Follow the entity into the tile group it moved to, or keep it
+        // inside the bound of its tile
+        int tileKey = sceneTileKey(state.lon, state.lat);
+        if (tileKey != entity.tileKey) {
+            detachFromTile(entity);
+            attachToTile(entity, tileKey);
+        } else {
+            fitTileBound(entity);
+        }
     }
     
     entity.lastUpdateTime = QDateTime::currentMSecsSinceEpoch();
 }
 
 void EntityManager::updateEntityStates(const QVector<EntityState>& states)
+{
+    updateEntityStates(states.constData(), states.size());
+}
+
+void EntityManager::updateEntityStates(const EntityState* states, int count)
 {
     // Batch update - more efficient than individual updates
-    for (const EntityState& state : states) {
-        updateEntityState(state);
+    PERF_SCOPE(PHASE_INGEST);
+    if (m_stateRecorder) {
+        m_stateRecorder->record(states, count);
+    }
+    for (int i = 0; i < count; ++i) {
+        applyEntityState(states[i]);
     }
 }
 
 void EntityManager::removeEntity(int entityId)
 {
-    if (!m_entities.contains(entityId)) {
+    auto it = m_entities.find(entityId);
+    if (it == m_entities.end()) {
         return;
     }
 
-    ManagedEntity& entity = m_entities[entityId];
+    ManagedEntity& entity = it.value();
+
+    auto highlight = m_highlights.find(entityId);
+    if (highlight != m_highlights.end()) {
+        m_entityRoot->removeChild(highlight.value().get());
+        m_highlights.erase(highlight);
+    }
+
+    if (!entity.pendingModelPath.isEmpty()) {
+        auto waiters = m_modelWaiters.find(entity.pendingModelPath);
+        if (waiters != m_modelWaiters.end()) {
+            waiters.value().removeOne(entityId);
+            if (waiters.value().isEmpty()) {
+                m_modelWaiters.erase(waiters);
+            }
+        }
+    }
+
+    // Exits for its detections go out with the next tick's events
+    if (m_sensorCoverageEnabled && entity.type == EntityState::SHIP) {
+        m_coverage.removeShip(entityId);
+    }
     
     // Remove from scene
-    if (entity.object.valid() && m_sceneRoot.valid()) {
-        m_sceneRoot->removeChild(entity.object->getModelTransform());
+    detachFromTile(entity);
+
+    // The last slot moves into the freed one - point its entity there
+    if (entity.storeIndex >= 0) {
+        int storeIndex = entity.storeIndex;
+        int movedId = m_store.remove(storeIndex);
+        if (movedId >= 0) {
+            auto moved = m_entities.find(movedId);
+            if (moved != m_entities.end()) {
+                moved.value().storeIndex = storeIndex;
+            }
+        }
     }
-    
-    m_entities.remove(entityId);
+
+    m_pool.release(entity.object);
+    m_entities.erase(it);
 }
 
 void EntityManager::clearAllEntities()
 {
-    QList<int> entityIds = m_entities.keys();
-    for (int id : entityIds) {
-        removeEntity(id);
+    clearHighlights();
+    m_tileRoot->removeChildren(0, m_tileRoot->getNumChildren());
+    m_tiles.clear();
+    m_usedTileKeys.clear();
+    for (auto it = m_entities.begin(); it != m_entities.end(); ++it) {
+        m_pool.release(it.value().object);
     }
+    m_entities.clear();
+    m_store.clear();
+    m_coverage.clear();
+    m_modelWaiters.clear();
 }
 
 void EntityManager::startRendering()
@@ -133,9 +727,12 @@ void EntityManager::stopRendering()
 void EntityManager::enablePerformanceStats(bool enable)
 {
     m_performanceStatsEnabled = enable;
+    PerfInstrumentation::setEnabled(enable);
     if (enable) {
         m_lastStatsTime = QDateTime::currentMSecsSinceEpoch();
         m_frameCount = 0;
+        // Drop anything recorded before the first window
+        PerfInstrumentation::takeWindow(0.0);
     }
 }
 
@@ -169,6 +766,19 @@ void EntityManager::setTrackLinesVisible(bool visible)
     }
 }
 
+void EntityManager::setFlattenedTransforms(bool flattened)
+{
+    m_flattenedTransforms = flattened;
+
+    for (auto it = m_entities.begin(); it != m_entities.end(); ++it) {
+        ManagedEntity& entity = it.value();
+        if (entity.object.valid()) {
+            entity.object->setFlattenedTransform(flattened);
+            entity.object->updateIfDirty();
+        }
+    }
+}
+
 int EntityManager::getVisibleEntityCount() const
 {
     int count = 0;
@@ -180,70 +790,494 @@ int EntityManager::getVisibleEntityCount() const
     return count;
 }
 
-void EntityManager::updateAll()
+Object3D* EntityManager::getEntityObject(int entityId) const
+{
+    auto it = m_entities.constFind(entityId);
+    if (it == m_entities.constEnd()) {
+        return nullptr;
+    }
+    return it.value().object.get();
+}
+
+int EntityManager::queryRadius(const osg::Vec3d& center, double radius, QVector<int>& entityIds) const
+{
+    m_store.queryRadius(center, radius, entityIds);
+    return slotsToEntityIds(entityIds);
+}
+
+int EntityManager::queryRadius(double lon, double lat, double alt, double radius, QVector<int>& entityIds) const
+{
+    osg::Vec3d center;
+    Geodesy::geodeticToEcef(lon, lat, alt, center.x(), center.y(), center.z());
+    return queryRadius(center, radius, entityIds);
+}
+
+int EntityManager::queryNearest(const osg::Vec3d& center, int k, QVector<int>& entityIds) const
+{
+    m_store.queryNearest(center, k, entityIds);
+    return slotsToEntityIds(entityIds);
+}
+
+int EntityManager::queryBox(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner, QVector<int>& entityIds) const
+{
+    m_store.queryBox(minCorner, maxCorner, entityIds);
+    return slotsToEntityIds(entityIds);
+}
+
+int EntityManager::queryGeodeticBox(double minLon, double maxLon, double minLat, double maxLat,
+                                    double minAlt, double maxAlt, QVector<int>& entityIds) const
+{
+    m_store.queryGeodeticBox(minLon, maxLon, minLat, maxLat, minAlt, maxAlt, entityIds);
+    return slotsToEntityIds(entityIds);
+}
+
+int EntityManager::queryPolytope(const osg::Polytope& polytope, QVector<int>& entityIds) const
+{
+    m_store.queryPolytope(polytope, entityIds);
+    return slotsToEntityIds(entityIds);
+}
+
+int EntityManager::queryViewFrustum(QVector<int>& entityIds) const
 {
     if (!m_camera.valid()) {
+        entityIds.resize(0);
+        return 0;
+    }
+
+    // Clip-space unit cube back to world space
+    osg::Polytope frustum;
+    frustum.setToUnitFrustum();
+    frustum.transformProvidingInverse(m_camera->getViewMatrix() * m_camera->getProjectionMatrix());
+    return queryPolytope(frustum, entityIds);
+}
+
+void EntityManager::setSensorCoverageEnabled(bool enabled)
+{
+    if (enabled == m_sensorCoverageEnabled) {
         return;
     }
+    m_sensorCoverageEnabled = enabled;
+    m_coverage.clear();
 
-    int updatedCount = 0;
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (enabled) {
+        for (auto it = m_entities.begin(); it != m_entities.end(); ++it) {
+            ManagedEntity& entity = it.value();
+            if (entity.type == EntityState::SHIP && entity.object.valid()) {
+                m_coverage.addShip(entity.entityId, dynamic_cast<ShipModel*>(entity.object.get()));
+            }
+        }
+    }
+}
 
-    // Update all entities
-    for (auto it = m_entities.begin(); it != m_entities.end(); ++it) {
-        ManagedEntity& entity = it.value();
-        
-        if (!entity.object.valid()) {
+bool EntityManager::getSensorDetections(int shipId, int sensorIndex, QVector<int>& targetIds) const
+{
+    if (!m_sensorCoverageEnabled) {
+        targetIds.resize(0);
+        return false;
+    }
+    return m_coverage.getDetections(shipId, sensorIndex, targetIds);
+}
+
+int EntityManager::pick(double windowX, double windowY, QVector<int>& entityIds, double pixelTolerance)
+{
+    if (!m_camera.valid() || !m_camera->getViewport()) {
+        entityIds.resize(0);
+        return 0;
+    }
+
+    // Window -> world: invert view * projection * window
+    osg::Matrixd windowToWorld = osg::Matrixd::inverse(
+        m_camera->getViewMatrix() * m_camera->getProjectionMatrix() *
+        m_camera->getViewport()->computeWindowMatrix());
+
+    osg::Vec3d nearPoint = osg::Vec3d(windowX, windowY, 0.0) * windowToWorld;
+    osg::Vec3d farPoint = osg::Vec3d(windowX, windowY, 1.0) * windowToWorld;
+    osg::Vec3d direction = farPoint - nearPoint;
+
+    // Cone half-angle: angle to the ray pixelTolerance pixels to the side
+    osg::Vec3d sideDirection = osg::Vec3d(windowX + pixelTolerance, windowY, 1.0) * windowToWorld
+                             - osg::Vec3d(windowX + pixelTolerance, windowY, 0.0) * windowToWorld;
+    double cosine = direction * sideDirection;
+    double tanTolerance = cosine > 0.0 ? (direction ^ sideDirection).length() / cosine : 0.0;
+
+    return pick(nearPoint, direction, tanTolerance, entityIds);
+}
+
+int EntityManager::pick(const osg::Vec3d& rayOrigin, const osg::Vec3d& rayDirection, double tanTolerance,
+                        QVector<int>& entityIds)
+{
+    entityIds.resize(0);
+    osg::Vec3d direction = rayDirection;
+    if (direction.normalize() <= 0.0) {
+        return 0;
+    }
+
+    const int hitCount = m_store.queryRay(rayOrigin, direction, tanTolerance, m_pickHits);
+
+    // Triangle test for the nearest candidates only
+    EntityStore::RayHit exact[LodConfig::PICK_REFINE_CANDIDATES];
+    bool isExact[LodConfig::PICK_REFINE_CANDIDATES];
+    const int refineCount = std::min(hitCount, LodConfig::PICK_REFINE_CANDIDATES);
+    int exactCount = 0;
+    for (int i = 0; i < refineCount; ++i) {
+        const EntityStore::RayHit& hit = m_pickHits[i];
+        double length = hit.distance + 2.0 * m_store.boundingRadius(hit.index);
+        double distance = 0.0;
+        isExact[i] = intersectModel(m_store.object(hit.index), rayOrigin, direction, length, distance);
+        if (isExact[i]) {
+            EntityStore::RayHit refined = { hit.index, distance };
+            exact[exactCount++] = refined;
+        }
+    }
+    std::sort(exact, exact + exactCount, [](const EntityStore::RayHit& a, const EntityStore::RayHit& b) {
+        return a.distance < b.distance;
+    });
+
+    entityIds.reserve(hitCount);
+    for (int i = 0; i < exactCount; ++i) {
+        entityIds.append(m_store.entityId(exact[i].index));
+    }
+    for (int i = 0; i < hitCount; ++i) {
+        if (i >= refineCount || !isExact[i]) {
+            entityIds.append(m_store.entityId(m_pickHits[i].index));
+        }
+    }
+    return entityIds.size();
+}
+
+bool EntityManager::intersectModel(Object3D* object, const osg::Vec3d& origin, const osg::Vec3d& direction,
+                                   double length, double& distance) const
+{
+    osg::Node* model = object ? object->getModelNode() : nullptr;
+    if (!model || !object->isModelShown()) {
+        return false;
+    }
+
+    // Intersect in model coordinates: only the model, no sensors or track
+    // lines attached next to it, and no walk down the transform chain
+    osg::Matrixd modelToWorld = object->getLocalMatrix() * object->getLocalToWorld();
+    osg::Matrixd worldToModel = osg::Matrixd::inverse(modelToWorld);
+
+    osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(
+        origin * worldToModel, (origin + direction * length) * worldToModel);
+    osgUtil::IntersectionVisitor visitor(intersector.get());
+    model->accept(visitor);
+
+    if (!intersector->containsIntersections()) {
+        return false;
+    }
+    osg::Vec3d point = intersector->getFirstIntersection().getWorldIntersectPoint() * modelToWorld;
+    distance = (point - origin).length();
+    return true;
+}
+
+void EntityManager::setHighlighted(int entityId, bool highlighted)
+{
+    auto it = m_highlights.find(entityId);
+    if (!highlighted) {
+        if (it != m_highlights.end()) {
+            m_entityRoot->removeChild(it.value().get());
+            m_highlights.erase(it);
+        }
+        return;
+    }
+
+    if (it != m_highlights.end() || !m_entities.contains(entityId)) {
+        return;
+    }
+
+    osg::ref_ptr<osg::MatrixTransform> marker = new osg::MatrixTransform();
+    marker->addChild(highlightMarker());
+    m_entityRoot->addChild(marker.get());
+    m_highlights.insert(entityId, marker);
+    updateHighlightMarker(entityId, marker.get());
+}
+
+void EntityManager::clearHighlights()
+{
+    for (auto it = m_highlights.begin(); it != m_highlights.end(); ++it) {
+        m_entityRoot->removeChild(it.value().get());
+    }
+    m_highlights.clear();
+}
+
+void EntityManager::updateHighlightMarker(int entityId, osg::MatrixTransform* marker)
+{
+    auto it = m_entities.constFind(entityId);
+    if (it == m_entities.constEnd() || !it.value().object.valid()) {
+        return;
+    }
+
+    const Object3D* object = it.value().object.get();
+    double radius = std::max(object->getBoundingRadius(), 1.0) * HIGHLIGHT_MARKER_SCALE;
+    marker->setMatrix(osg::Matrixd::scale(radius, radius, radius) *
+                      osg::Matrixd::translate(object->getWorldPosition()));
+}
+
+void EntityManager::attachToTile(ManagedEntity& entity, int tileKey)
+{
+    if (m_tiles.isEmpty()) {
+        m_tiles.resize(SCENE_TILE_COLUMNS * SCENE_TILE_ROWS);
+    }
+
+    SceneTile& tile = m_tiles[tileKey];
+    if (!tile.group.valid()) {
+        // Tiles stay once created, so entities crossing back and forth do not allocate
+        tile.group = new EntityGroup();
+        sceneTileBound(tileKey, tile.center, tile.emptyRadius);
+        tile.radius = tile.emptyRadius;
+        applyTileBound(tile);
+        m_tileRoot->addChild(tile.group.get());
+        m_usedTileKeys.append(tileKey);
+    }
+
+    entity.tileKey = tileKey;
+    entity.groupIndex = static_cast<int>(tile.group->addEntity(entity.object->getModelTransform(), entity.entityId));
+    fitTileBound(entity);
+}
+
+void EntityManager::detachFromTile(ManagedEntity& entity)
+{
+    if (entity.groupIndex < 0 || entity.tileKey < 0) {
+        return;
+    }
+
+    // The last child of the tile moves into the freed index
+    SceneTile& tile = m_tiles[entity.tileKey];
+    int groupIndex = entity.groupIndex;
+    int movedId = tile.group->removeEntity(groupIndex);
+    if (movedId >= 0) {
+        auto moved = m_entities.find(movedId);
+        if (moved != m_entities.end()) {
+            moved.value().groupIndex = groupIndex;
+        }
+    }
+
+    // Shrink back once nothing stretches it any more
+    if (tile.group->getNumChildren() == 0 && tile.radius != tile.emptyRadius) {
+        tile.radius = tile.emptyRadius;
+        applyTileBound(tile);
+    }
+
+    entity.tileKey = -1;
+    entity.groupIndex = -1;
+}
+
+void EntityManager::fitTileBound(const ManagedEntity& entity)
+{
+    SceneTile& tile = m_tiles[entity.tileKey];
+    double reach = (entity.object->getWorldPosition() - tile.center).length() + entity.extent;
+    if (reach <= tile.radius) {
+        return;
+    }
+
+    // Grow with some slack so an entity climbing or a sensor growing does
+    // not dirty the bound again every tick
+    tile.radius = reach * LodConfig::SCENE_TILE_BOUND_SLACK;
+    applyTileBound(tile);
+}
+
+void EntityManager::applyTileBound(SceneTile& tile)
+{
+    tile.group->setFixedBound(osg::BoundingSphere(tile.center, tile.radius));
+}
+
+void EntityManager::assignModel(ManagedEntity& entity, const QString& modelPath)
+{
+    osg::ref_ptr<osg::Node> model;
+    if (!m_modelLoader.request(modelPath, model)) {
+        m_modelWaiters[modelPath].append(entity.entityId);
+        entity.pendingModelPath = modelPath;
+    }
+
+    // nullptr (loading or failed) shows the placeholder
+    entity.object->setModelNode(model.get());
+}
+
+void EntityManager::applyLoadedModels()
+{
+    // Returns without locking while nothing finished
+    if (m_modelLoader.takeFinished(m_loadedModels) == 0) {
+        return;
+    }
+
+    for (const ModelLoader::Result& result : m_loadedModels) {
+        if (!result.model.valid()) {
+            qWarning() << "[EntityManager] Could not load model" << result.path << "- keeping the placeholder";
+        }
+
+        auto waiters = m_modelWaiters.find(result.path);
+        if (waiters == m_modelWaiters.end()) {
             continue;
         }
 
-        // Update LOD based on distance
-        int newLodLevel = updateEntityLod(entity);
-        
-        // Check if entity is too far away (beyond FAR distance)
-        if (entity.lastDistance > LodConfig::DISTANCE_FAR) {
-            if (entity.visible) {
-                entity.object->setVisible(false);
-                entity.visible = false;
+        for (int entityId : waiters.value()) {
+            auto it = m_entities.find(entityId);
+            if (it == m_entities.end() || !it.value().object.valid()) {
+                continue;
+            }
+
+            ManagedEntity& entity = it.value();
+            entity.pendingModelPath.clear();
+            if (result.model.valid()) {
+                entity.object->setModelNode(result.model.get());
+                m_store.setBoundingRadius(entity.storeIndex, entity.object->getBoundingRadius());
+                entity.extent = entity.object->getExtentRadius();
+                fitTileBound(entity);
             }
-            continue;
         }
-        else {
-            if (!entity.visible) {
-                entity.object->setVisible(true);
-                entity.visible = true;
+        m_modelWaiters.erase(waiters);
+    }
+
+    // Drop the references so removed paths can be freed
+    m_loadedModels.resize(0);
+}
+
+int EntityManager::slotsToEntityIds(QVector<int>& indices) const
+{
+    int* data = indices.data();
+    for (int i = 0; i < indices.size(); ++i) {
+        data[i] = m_store.entityId(data[i]);
+    }
+    return indices.size();
+}
+
+void EntityManager::updateAll()
+{
+    if (!m_camera.valid()) {
+        return;
+    }
+
+    // Write a trace requested by a slow frame before this tick is recorded
+    TraceRecorder::pollAutoDump();
+    ENTITY_TRACE_SCOPE("entity", "EntityManager::updateAll");
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_cameraPosition = m_camera->getInverseViewMatrix().getTrans();
+
+    // Grow the scratch lists only when the entity count grows; resize(0)
+    // keeps their capacity so steady-state ticks do not allocate
+    if (m_dueEntities.capacity() < m_entities.size()) {
+        m_dueEntities.reserve(m_entities.size());
+        m_visibilityChanges.reserve(m_entities.size());
+    }
+    m_dueEntities.resize(0);
+    m_visibilityChanges.resize(0);
+
+    applyLoadedModels();
+
+    // Phase 1: distance / LOD classification and cull decision
+    {
+        PERF_SCOPE(PHASE_LOD_CLASSIFY);
+        int culledCount = 0;
+
+        // All camera distances in one pass over the store
+        m_store.computeCameraDistances(m_cameraPosition);
+
+        for (auto it = m_entities.begin(); it != m_entities.end(); ++it) {
+            ManagedEntity& entity = it.value();
+
+            if (!entity.object.valid()) {
+                continue;
+            }
+
+            // Update LOD based on distance
+            updateEntityLod(entity);
+
+            // Check if entity is too far away (beyond FAR distance)
+            bool visible = entity.lastDistance <= LodConfig::DISTANCE_FAR;
+            if (visible != entity.visible) {
+                m_visibilityChanges.append(&entity);
+            }
+            if (!visible) {
+                ++culledCount;
+                continue;
+            }
+
+            // Hierarchical update frequency based on LOD
+            if (shouldUpdate(entity)) {
+                m_dueEntities.append(&entity);
             }
         }
 
-        // Hierarchical update frequency based on LOD
-        if (shouldUpdate(entity)) {
-            // Update dirty transforms
-            entity.object->updateIfDirty();
-            
-            // Update LOD for child components (sensors, track lines)
-            if (entity.type == EntityState::SHIP) {
-                ShipModel* ship = dynamic_cast<ShipModel*>(entity.object.get());
+        PERF_COUNT(COUNTER_ENTITIES_CULLED, culledCount);
+        Q_UNUSED(culledCount);
+    }
+
+    // Phase 2: rebuild dirty transforms
+    {
+        PERF_SCOPE(PHASE_MATRIX_REBUILD);
+        for (ManagedEntity* entity : m_dueEntities) {
+            entity->object->updateIfDirty();
+            m_store.setPosition(entity->storeIndex, entity->object->getPosition(), entity->object->getWorldPosition());
+            m_store.setBoundingRadius(entity->storeIndex, entity->object->getBoundingRadius());
+
+            // Attachments may have been added since the last update
+            entity->extent = entity->object->getExtentRadius();
+            fitTileBound(*entity);
+        }
+    }
+
+    // Phase 3: LOD for child components (sensors, track lines)
+    {
+        PERF_SCOPE(PHASE_CHILD_LOD);
+        for (ManagedEntity* entity : m_dueEntities) {
+            if (entity->type == EntityState::SHIP) {
+                ShipModel* ship = dynamic_cast<ShipModel*>(entity->object.get());
                 if (ship) {
-                    ship->updateSensorLod(newLodLevel);
+                    ship->updateSensorLod(entity->lodLevel);
                 }
             }
-            else if (entity.type == EntityState::MISSILE) {
-                MissileModel* missile = dynamic_cast<MissileModel*>(entity.object.get());
+            else if (entity->type == EntityState::MISSILE) {
+                MissileModel* missile = dynamic_cast<MissileModel*>(entity->object.get());
                 if (missile) {
-                    missile->updateTrackLineLod(newLodLevel);
+                    missile->updateTrackLineLod(entity->lodLevel);
                 }
             }
-            
-            entity.lastUpdateTime = now;
-            updatedCount++;
+
+            entity->lastUpdateTime = now;
+        }
+    }
+
+    // Phase 4: push visibility changes into the scene graph
+    {
+        PERF_SCOPE(PHASE_SCENE_COMMIT);
+        for (ManagedEntity* entity : m_visibilityChanges) {
+            entity->visible = !entity->visible;
+            entity->object->setVisible(entity->visible);
+        }
+
+        // Markers follow their entities (a handful at most)
+        for (auto it = m_highlights.begin(); it != m_highlights.end(); ++it) {
+            updateHighlightMarker(it.key(), it.value().get());
+        }
+    }
+
+    // Phase 5: sensor sectors against the updated positions
+    if (m_sensorCoverageEnabled) {
+        {
+            PERF_SCOPE(PHASE_SENSOR_COVERAGE);
+            m_coverage.update(m_store);
+        }
+
+        // Slots may remove entities, which appends more events - copy each
+        // event out and re-read the size on every iteration
+        for (int i = 0; i < m_coverage.events().size(); ++i) {
+            const SensorCoverage::Event event = m_coverage.events()[i];
+            if (event.entered) {
+                emit targetEnteredSensor(event.shipId, event.sensorIndex, event.targetId);
+            } else {
+                emit targetLeftSensor(event.shipId, event.sensorIndex, event.targetId);
+            }
         }
+        m_coverage.clearEvents();
     }
 
     m_frameCount++;
 
     // Print performance statistics every second
     if (m_performanceStatsEnabled && (now - m_lastStatsTime) >= 1000) {
-        printPerformanceStats();
+        printPerformanceStats(now - m_lastStatsTime);
         m_lastStatsTime = now;
         m_frameCount = 0;
     }
@@ -276,28 +1310,12 @@ int EntityManager::updateEntityLod(ManagedEntity& entity)
 
 double EntityManager::calculateDistance(const ManagedEntity& entity)
 {
-    if (!entity.object.valid() || !m_camera.valid()) {
+    if (entity.storeIndex < 0 || !m_camera.valid()) {
         return 0.0;
     }
 
-    // Get entity position in world coordinates
-    osg::Vec3d entityPos = entity.object->getPosition();
-    
-    // Convert to ECEF
-    osg::EllipsoidModel ellipsoid;
-    osg::Vec3d ecef;
-    ellipsoid.convertLatLongHeightToXYZ(
-        osg::DegreesToRadians(entityPos.y()),
-        osg::DegreesToRadians(entityPos.x()),
-        entityPos.z(),
-        ecef.x(), ecef.y(), ecef.z()
-    );
-
-    // Get camera position in world coordinates
-    osg::Vec3d cameraPos = m_camera->getInverseViewMatrix().getTrans();
-
-    // Calculate distance
-    return (ecef - cameraPos).length();
+    // Filled for all entities by the batch pass at the start of the tick
+    return m_store.distance(entity.storeIndex);
 }
 
 bool EntityManager::shouldUpdate(const ManagedEntity& entity) const
@@ -323,14 +1341,36 @@ bool EntityManager::shouldUpdate(const ManagedEntity& entity) const
     return (now - entity.lastUpdateTime) >= interval;
 }
 
-void EntityManager::printPerformanceStats()
+void EntityManager::printPerformanceStats(qint64 elapsedMs)
 {
-    double fps = m_frameCount / 1.0; // Approximate FPS (measured per second)
+    double seconds = elapsedMs / 1000.0;
+    double ticksPerSecond = seconds > 0.0 ? m_frameCount / seconds : 0.0;
     int visibleCount = getVisibleEntityCount();
     int totalCount = m_entities.size();
 
-    qDebug() << QString("[EntityManager] FPS: %1 | Visible: %2 | Total: %3")
-        .arg(fps, 0, 'f', 1)
+    // updateAll() runs from a timer, so this is the tick rate, not the render FPS
+    qDebug() << QString("[EntityManager] Ticks/s: %1 | Visible: %2 | Total: %3")
+        .arg(ticksPerSecond, 0, 'f', 1)
         .arg(visibleCount)
         .arg(totalCount);
+
+#ifdef ENTITY_PERF_INSTRUMENTATION
+    m_lastReport = PerfInstrumentation::takeWindow(seconds);
+
+    for (int i = 0; i < PerfInstrumentation::PHASE_COUNT; ++i) {
+        const PerfInstrumentation::PhaseSummary& phase = m_lastReport.phases[i];
+        qDebug().noquote() << QString("[EntityManager]   %1 n=%2 p50=%3ms p95=%4ms p99=%5ms max=%6ms")
+            .arg(PerfInstrumentation::phaseName(static_cast<PerfInstrumentation::Phase>(i)), -14)
+            .arg(static_cast<qulonglong>(phase.samples), 4)
+            .arg(phase.p50Ms, 0, 'f', 3)
+            .arg(phase.p95Ms, 0, 'f', 3)
+            .arg(phase.p99Ms, 0, 'f', 3)
+            .arg(phase.maxMs, 0, 'f', 3);
+    }
+
+    qDebug().noquote() << QString("[EntityManager]   matrices=%1 geometries=%2 culled=%3")
+        .arg(static_cast<qulonglong>(m_lastReport.counters[PerfInstrumentation::COUNTER_MATRICES_REBUILT]))
+        .arg(static_cast<qulonglong>(m_lastReport.counters[PerfInstrumentation::COUNTER_GEOMETRIES_REBUILT]))
+        .arg(static_cast<qulonglong>(m_lastReport.counters[PerfInstrumentation::COUNTER_ENTITIES_CULLED]));
+#endif
 }
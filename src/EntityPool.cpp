@@ -0,0 +1,104 @@
+#include "EntityPool.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Pop the last free object, or construct a new one
+ */
+template <typename T>
+osg::ref_ptr<T> takeOrCreate(QVector<osg::ref_ptr<T>>& freeList, T* (*create)())
+{
+    if (freeList.isEmpty()) {
+        return create();
+    }
+    osg::ref_ptr<T> object = freeList.last();
+    freeList.resize(freeList.size() - 1);
+    return object;
+}
+
+} // namespace
+
+ShipModel* EntityPool::createShip()
+{
+    return new ShipModel(0, 0, 0, 1.0, QString());
+}
+
+MissileModel* EntityPool::createMissile()
+{
+    return new MissileModel(0, 0, 0, 0, 0, 0, 1.0, QString());
+}
+
+EntityPool::EntityPool(int capacity)
+    : m_capacity(capacity > 0 ? capacity : 0)
+{
+}
+
+osg::ref_ptr<ShipModel> EntityPool::acquireShip()
+{
+    return takeOrCreate(m_freeShips, createShip);
+}
+
+osg::ref_ptr<MissileModel> EntityPool::acquireMissile()
+{
+    return takeOrCreate(m_freeMissiles, createMissile);
+}
+
+bool EntityPool::release(osg::ref_ptr<Object3D>& object)
+{
+    osg::ref_ptr<Object3D> released = object;
+    object = nullptr;
+
+    // Someone still holds it - it is theirs now, not ours to reuse
+    if (!released.valid() || released->referenceCount() > 1) {
+        return false;
+    }
+
+    if (ShipModel* ship = dynamic_cast<ShipModel*>(released.get())) {
+        if (m_freeShips.size() < m_capacity) {
+            ship->reset();
+            m_freeShips.append(ship);
+            return true;
+        }
+    }
+    else if (MissileModel* missile = dynamic_cast<MissileModel*>(released.get())) {
+        if (m_freeMissiles.size() < m_capacity) {
+            missile->reset();
+            m_freeMissiles.append(missile);
+            return true;
+        }
+    }
+    return false;
+}
+
+void EntityPool::prefill(int ships, int missiles)
+{
+    ships = std::min(ships, m_capacity);
+    missiles = std::min(missiles, m_capacity);
+
+    m_freeShips.reserve(m_capacity);
+    m_freeMissiles.reserve(m_capacity);
+    while (m_freeShips.size() < ships) {
+        m_freeShips.append(createShip());
+    }
+    while (m_freeMissiles.size() < missiles) {
+        m_freeMissiles.append(createMissile());
+    }
+}
+
+void EntityPool::setCapacity(int capacity)
+{
+    m_capacity = capacity > 0 ? capacity : 0;
+    if (m_freeShips.size() > m_capacity) {
+        m_freeShips.resize(m_capacity);
+    }
+    if (m_freeMissiles.size() > m_capacity) {
+        m_freeMissiles.resize(m_capacity);
+    }
+}
+
+void EntityPool::clear()
+{
+    m_freeShips.clear();
+    m_freeMissiles.clear();
+}
@@ -0,0 +1,200 @@
+#include "EntitySnapshot.h"
+#include "EntityManager.h"
+#include <QDebug>
+#include <QSaveFile>
+#include <cstring>
+
+namespace EntitySnapshot {
+
+void Writer::reserve(int entities)
+{
+    m_entities.reserve(entities);
+}
+
+EntityRecord& Writer::addEntity()
+{
+    EntityRecord record;
+    std::memset(&record, 0, sizeof(record));
+    m_entities.append(record);
+    return m_entities.last();
+}
+
+SensorRecord& Writer::addSensor()
+{
+    SensorRecord record;
+    std::memset(&record, 0, sizeof(record));
+    m_sensors.append(record);
+    return m_sensors.last();
+}
+
+TrackLineRecord& Writer::addTrackLine()
+{
+    TrackLineRecord record;
+    std::memset(&record, 0, sizeof(record));
+    m_trackLines.append(record);
+    return m_trackLines.last();
+}
+
+void Writer::addString(const QString& text, quint32& offset, quint32& length)
+{
+    if (text.isEmpty()) {
+        offset = 0;
+        length = 0;
+        return;
+    }
+
+    const QByteArray utf8 = text.toUtf8();
+    length = static_cast<quint32>(utf8.size());
+
+    auto it = m_stringOffsets.constFind(text);
+    if (it != m_stringOffsets.constEnd()) {
+        offset = it.value();
+        return;
+    }
+
+    offset = static_cast<quint32>(m_strings.size());
+    m_strings.append(utf8.constData(), utf8.size());
+    m_stringOffsets.insert(text, offset);
+}
+
+bool Writer::write(const QString& path) const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.entityCount = static_cast<quint32>(m_entities.size());
+    header.sensorCount = static_cast<quint32>(m_sensors.size());
+    header.trackLineCount = static_cast<quint32>(m_trackLines.size());
+    header.stringBytes = static_cast<quint32>(m_strings.size());
+
+    // Record sizes are multiples of 8, so every table stays aligned
+    header.entityOffset = sizeof(Header);
+    header.sensorOffset = header.entityOffset + qint64(sizeof(EntityRecord)) * m_entities.size();
+    header.trackLineOffset = header.sensorOffset + qint64(sizeof(SensorRecord)) * m_sensors.size();
+    header.stringOffset = header.trackLineOffset + qint64(sizeof(TrackLineRecord)) * m_trackLines.size();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[EntitySnapshot] Cannot write" << path;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_entities.constData()), qint64(sizeof(EntityRecord)) * m_entities.size());
+    file.write(reinterpret_cast<const char*>(m_sensors.constData()), qint64(sizeof(SensorRecord)) * m_sensors.size());
+    file.write(reinterpret_cast<const char*>(m_trackLines.constData()), qint64(sizeof(TrackLineRecord)) * m_trackLines.size());
+    file.write(m_strings.constData(), m_strings.size());
+
+    // Replaces the old file only if every write succeeded
+    if (!file.commit()) {
+        qWarning() << "[EntitySnapshot] Writing" << path << "failed";
+        return false;
+    }
+    return true;
+}
+
+Reader::Reader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_header(nullptr)
+    , m_entities(nullptr)
+    , m_sensors(nullptr)
+    , m_trackLines(nullptr)
+    , m_strings(nullptr)
+{
+}
+
+Reader::~Reader()
+{
+    close();
+}
+
+bool Reader::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[EntitySnapshot] Cannot read" << path;
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_size >= qint64(sizeof(Header)) ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        qWarning() << "[EntitySnapshot]" << path << "is not a snapshot";
+        close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const Header*>(m_data);
+    if (!validate()) {
+        qWarning() << "[EntitySnapshot]" << path << "is damaged or of another version";
+        close();
+        return false;
+    }
+
+    m_entities = reinterpret_cast<const EntityRecord*>(m_data + m_header->entityOffset);
+    m_sensors = reinterpret_cast<const SensorRecord*>(m_data + m_header->sensorOffset);
+    m_trackLines = reinterpret_cast<const TrackLineRecord*>(m_data + m_header->trackLineOffset);
+    m_strings = reinterpret_cast<const char*>(m_data + m_header->stringOffset);
+    return true;
+}
+
+void Reader::close()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_file.close();
+
+    m_size = 0;
+    m_header = nullptr;
+    m_entities = nullptr;
+    m_sensors = nullptr;
+    m_trackLines = nullptr;
+    m_strings = nullptr;
+}
+
+QString Reader::string(quint32 offset, quint32 length) const
+{
+    return length > 0 ? QString::fromUtf8(m_strings + offset, static_cast<int>(length)) : QString();
+}
+
+bool Reader::validate() const
+{
+    const Header& h = *m_header;
+    if (h.magic != MAGIC || h.version != VERSION || h.byteOrder != BYTE_ORDER_MARK) {
+        return false;
+    }
+
+    // Tables in order, aligned and inside the file
+    const qint64 entityEnd = h.entityOffset + qint64(sizeof(EntityRecord)) * h.entityCount;
+    const qint64 sensorEnd = h.sensorOffset + qint64(sizeof(SensorRecord)) * h.sensorCount;
+    const qint64 trackLineEnd = h.trackLineOffset + qint64(sizeof(TrackLineRecord)) * h.trackLineCount;
+    if (h.entityOffset < qint64(sizeof(Header)) || h.sensorOffset < entityEnd
+        || h.trackLineOffset < sensorEnd || h.stringOffset < trackLineEnd
+        || h.stringOffset + h.stringBytes > m_size
+        || (h.entityOffset | h.sensorOffset | h.trackLineOffset) % 8 != 0) {
+        return false;
+    }
+
+    const EntityRecord* entities = reinterpret_cast<const EntityRecord*>(m_data + h.entityOffset);
+    for (quint32 i = 0; i < h.entityCount; ++i) {
+        const EntityRecord& e = entities[i];
+        const quint32 attachments = (e.type == EntityState::SHIP) ? h.sensorCount : h.trackLineCount;
+        if ((i > 0 && e.entityId <= entities[i - 1].entityId)
+            || e.type > EntityState::MISSILE
+            || qint64(e.modelPathOffset) + e.modelPathLength > h.stringBytes
+            || qint64(e.billboardOffset) + e.billboardLength > h.stringBytes
+            || qint64(e.firstAttachment) + e.attachmentCount > attachments) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace EntitySnapshot
@@ -0,0 +1,274 @@
+#include "EntityStateLog.h"
+#include <algorithm>
+#include <cmath>
+
+namespace EntityStateLog {
+
+namespace {
+
+const double ANGLE_SCALE = 1e7;        // lon/lat units per degree
+const double ALTITUDE_SCALE = 1e3;     // alt units per meter
+const double ATTITUDE_SCALE = 1e4;     // heading/pitch/roll units per degree
+const double QUATERNION_SCALE = 1e9;
+
+// Longest varint of a 64-bit value
+const int MAX_VARINT_BYTES = 10;
+
+inline quint64 zigzag(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+inline qint64 unzigzag(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+inline qint64 quantize(double value, double scale)
+{
+    return static_cast<qint64>(std::llround(value * scale));
+}
+
+/**
+ * @brief Appends varints to a payload that was sized for the worst case
+ */
+class Writer
+{
+public:
+    explicit Writer(uchar* out) : m_out(out), m_pos(0) {}
+
+    void put(qint64 value)
+    {
+        quint64 bits = zigzag(value);
+        while (bits >= 0x80) {
+            m_out[m_pos++] = static_cast<uchar>(bits | 0x80);
+            bits >>= 7;
+        }
+        m_out[m_pos++] = static_cast<uchar>(bits);
+    }
+
+    void putByte(uchar value) { m_out[m_pos++] = value; }
+
+    int size() const { return m_pos; }
+
+private:
+    uchar* m_out;
+    int m_pos;
+};
+
+/**
+ * @brief Reads varints, failing instead of running past the end
+ */
+class Reader
+{
+public:
+    Reader(const uchar* in, int size) : m_in(in), m_end(in + size), m_ok(true) {}
+
+    qint64 get()
+    {
+        quint64 bits = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_in == m_end) {
+                m_ok = false;
+                return 0;
+            }
+            const uchar byte = *m_in++;
+            bits |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return unzigzag(bits);
+            }
+        }
+        m_ok = false;
+        return 0;
+    }
+
+    uchar getByte()
+    {
+        if (m_in == m_end) {
+            m_ok = false;
+            return 0;
+        }
+        return *m_in++;
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_in == m_end; }
+
+private:
+    const uchar* m_in;
+    const uchar* m_end;
+    bool m_ok;
+};
+
+// Quantized value columns, in payload order
+enum Column {
+    COLUMN_LON,
+    COLUMN_LAT,
+    COLUMN_ALT,
+    COLUMN_HEADING,
+    COLUMN_PITCH,
+    COLUMN_ROLL,
+    COLUMN_TIMESTAMP,
+    COLUMN_QX,
+    COLUMN_QY,
+    COLUMN_QZ,
+    COLUMN_QW,
+    COLUMN_COUNT
+};
+
+const int FIRST_QUATERNION_COLUMN = COLUMN_QX;
+
+qint64 quantizedValue(const EntityState& s, int column)
+{
+    switch (column) {
+    case COLUMN_LON:        return quantize(s.lon, ANGLE_SCALE);
+    case COLUMN_LAT:        return quantize(s.lat, ANGLE_SCALE);
+    case COLUMN_ALT:        return quantize(s.alt, ALTITUDE_SCALE);
+    case COLUMN_HEADING:    return quantize(s.heading, ATTITUDE_SCALE);
+    case COLUMN_PITCH:      return quantize(s.pitch, ATTITUDE_SCALE);
+    case COLUMN_ROLL:       return quantize(s.roll, ATTITUDE_SCALE);
+    case COLUMN_TIMESTAMP:  return s.timestamp;
+    case COLUMN_QX:         return s.hasQuaternion ? quantize(s.qx, QUATERNION_SCALE) : 0;
+    case COLUMN_QY:         return s.hasQuaternion ? quantize(s.qy, QUATERNION_SCALE) : 0;
+    case COLUMN_QZ:         return s.hasQuaternion ? quantize(s.qz, QUATERNION_SCALE) : 0;
+    case COLUMN_QW:         return s.hasQuaternion ? quantize(s.qw, QUATERNION_SCALE) : 0;
+    }
+    return 0;
+}
+
+void setValue(EntityState& s, int column, qint64 value)
+{
+    switch (column) {
+    case COLUMN_LON:        s.lon = value / ANGLE_SCALE; break;
+    case COLUMN_LAT:        s.lat = value / ANGLE_SCALE; break;
+    case COLUMN_ALT:        s.alt = value / ALTITUDE_SCALE; break;
+    case COLUMN_HEADING:    s.heading = value / ATTITUDE_SCALE; break;
+    case COLUMN_PITCH:      s.pitch = value / ATTITUDE_SCALE; break;
+    case COLUMN_ROLL:       s.roll = value / ATTITUDE_SCALE; break;
+    case COLUMN_TIMESTAMP:  s.timestamp = value; break;
+    case COLUMN_QX:         s.qx = value / QUATERNION_SCALE; break;
+    case COLUMN_QY:         s.qy = value / QUATERNION_SCALE; break;
+    case COLUMN_QZ:         s.qz = value / QUATERNION_SCALE; break;
+    case COLUMN_QW:         s.qw = value / QUATERNION_SCALE; break;
+    }
+}
+
+} // namespace
+
+void ChunkCodec::encode(const EntityState* states, const qint64* times, const uchar* flags, int count,
+                        QVector<uchar>& payload)
+{
+    // Worst case: every varint at full length plus the flags byte
+    payload.resize(count * ((COLUMN_COUNT + 2) * MAX_VARINT_BYTES + 1));
+    Writer out(payload.data());
+
+    qint64 previousTime = 0;
+    for (int i = 0; i < count; ++i) {
+        out.put(times[i] - previousTime);
+        previousTime = times[i];
+    }
+
+    int previousId = 0;
+    for (int i = 0; i < count; ++i) {
+        out.put(static_cast<qint64>(states[i].entityId) - previousId);
+        previousId = states[i].entityId;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        uchar f = flags[i] & FLAG_BATCH_START;
+        if (states[i].type == EntityState::MISSILE) {
+            f |= FLAG_MISSILE;
+        }
+        if (states[i].hasQuaternion) {
+            f |= FLAG_QUATERNION;
+        }
+        out.putByte(f);
+    }
+
+    linkPrevious(states, count);
+    m_column.resize(count);
+    qint64* column = m_column.data();
+    const int* previous = m_previous.constData();
+
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        const bool quaternion = c >= FIRST_QUATERNION_COLUMN;
+        for (int i = 0; i < count; ++i) {
+            column[i] = quantizedValue(states[i], c);
+            if (quaternion && !states[i].hasQuaternion) {
+                continue;
+            }
+            out.put(column[i] - (previous[i] >= 0 ? column[previous[i]] : 0));
+        }
+    }
+
+    payload.resize(out.size());
+}
+
+bool ChunkCodec::decode(const uchar* payload, int size, int count,
+                        EntityState* states, qint64* times, uchar* flags)
+{
+    Reader in(payload, size);
+
+    qint64 time = 0;
+    for (int i = 0; i < count; ++i) {
+        time += in.get();
+        times[i] = time;
+    }
+
+    qint64 id = 0;
+    for (int i = 0; i < count; ++i) {
+        id += in.get();
+        states[i] = EntityState();
+        states[i].entityId = static_cast<int>(id);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        flags[i] = in.getByte();
+        states[i].type = (flags[i] & FLAG_MISSILE) ? EntityState::MISSILE : EntityState::SHIP;
+        states[i].hasQuaternion = (flags[i] & FLAG_QUATERNION) != 0;
+    }
+
+    if (!in.ok()) {
+        return false;
+    }
+
+    linkPrevious(states, count);
+    m_column.resize(count);
+    qint64* column = m_column.data();
+    const int* previous = m_previous.constData();
+
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        const bool quaternion = c >= FIRST_QUATERNION_COLUMN;
+        for (int i = 0; i < count; ++i) {
+            if (quaternion && !states[i].hasQuaternion) {
+                column[i] = 0;
+                continue;
+            }
+            column[i] = in.get() + (previous[i] >= 0 ? column[previous[i]] : 0);
+            setValue(states[i], c, column[i]);
+        }
+    }
+
+    return in.ok() && in.atEnd();
+}
+
+void ChunkCodec::linkPrevious(const EntityState* states, int count)
+{
+    // Sorting id/index keys groups each entity's states in index order;
+    // unlike clearing a hash per chunk, resize() keeps the capacity
+    m_order.resize(count);
+    m_previous.resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_order[i] = (static_cast<quint64>(static_cast<quint32>(states[i].entityId)) << 32)
+                   | static_cast<quint32>(i);
+    }
+    std::sort(m_order.begin(), m_order.end());
+
+    for (int k = 0; k < count; ++k) {
+        const int index = static_cast<int>(m_order[k] & 0xffffffffu);
+        const bool sameEntity = k > 0 && (m_order[k] >> 32) == (m_order[k - 1] >> 32);
+        m_previous[index] = sameEntity ? static_cast<int>(m_order[k - 1] & 0xffffffffu) : -1;
+    }
+}
+
+} // namespace EntityStateLog
@@ -0,0 +1,155 @@
+#include "EntityStateRecorder.h"
+#include <QDebug>
+
+using namespace EntityStateLog;
+
+EntityStateRecorder::EntityStateRecorder(int chunkStates)
+    : m_chunkStates(chunkStates > 0 ? chunkStates : 1)
+    , m_failed(false)
+    , m_recordedStates(0)
+    , m_bytesWritten(0)
+{
+    m_states.reserve(m_chunkStates);
+    m_times.reserve(m_chunkStates);
+    m_flags.reserve(m_chunkStates);
+}
+
+EntityStateRecorder::~EntityStateRecorder()
+{
+    close();
+}
+
+bool EntityStateRecorder::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "[EntityStateRecorder] Cannot write" << path;
+        return false;
+    }
+
+    m_failed = false;
+    m_recordedStates = 0;
+    m_bytesWritten = 0;
+    m_states.resize(0);
+    m_times.resize(0);
+    m_flags.resize(0);
+    m_index.resize(0);
+
+    uchar header[FILE_HEADER_SIZE];
+    putU32(header, FILE_MAGIC);
+    putU32(header + 4, VERSION);
+    putU32(header + 8, static_cast<quint32>(m_chunkStates));
+    putU32(header + 12, 0);
+    write(header, FILE_HEADER_SIZE);
+
+    m_clock.start();
+    return !m_failed;
+}
+
+bool EntityStateRecorder::close()
+{
+    if (!m_file.isOpen()) {
+        return true;
+    }
+
+    writeChunk();
+
+    // Index and trailer
+    const qint64 indexOffset = m_bytesWritten;
+    uchar entry[INDEX_ENTRY_SIZE];
+    for (const ChunkInfo& chunk : m_index) {
+        putI64(entry, chunk.offset);
+        putI64(entry + 8, chunk.firstTime);
+        putI64(entry + 16, chunk.lastTime);
+        putU32(entry + 24, static_cast<quint32>(chunk.stateCount));
+        putU32(entry + 28, 0);
+        write(entry, INDEX_ENTRY_SIZE);
+    }
+
+    uchar trailer[TRAILER_SIZE];
+    putI64(trailer, indexOffset);
+    putU32(trailer + 8, static_cast<quint32>(m_index.size()));
+    putU32(trailer + 12, INDEX_MAGIC);
+    write(trailer, TRAILER_SIZE);
+
+    m_file.close();
+    if (m_failed) {
+        qWarning() << "[EntityStateRecorder] Write failed, log" << m_file.fileName() << "is incomplete";
+    }
+    return !m_failed;
+}
+
+void EntityStateRecorder::record(const EntityState* states, int count)
+{
+    if (!m_file.isOpen() || count <= 0) {
+        return;
+    }
+
+    const qint64 time = m_clock.elapsed();
+    m_recordedStates += count;
+
+    // A batch larger than the chunk continues in the next one
+    bool batchStart = true;
+    while (count > 0) {
+        const int n = qMin(count, m_chunkStates - m_states.size());
+        for (int i = 0; i < n; ++i) {
+            m_states.append(states[i]);
+            m_times.append(time);
+            m_flags.append(batchStart && i == 0 ? FLAG_BATCH_START : 0);
+        }
+        states += n;
+        count -= n;
+        batchStart = false;
+
+        if (m_states.size() == m_chunkStates) {
+            writeChunk();
+        }
+    }
+}
+
+void EntityStateRecorder::writeChunk()
+{
+    const int count = m_states.size();
+    if (count == 0) {
+        return;
+    }
+
+    m_codec.encode(m_states.constData(), m_times.constData(), m_flags.constData(), count, m_payload);
+
+    ChunkInfo chunk;
+    chunk.offset = m_bytesWritten;
+    chunk.stateCount = count;
+    chunk.firstTime = m_times.first();
+    chunk.lastTime = m_times.last();
+    m_index.append(chunk);
+
+    uchar header[CHUNK_HEADER_SIZE];
+    putU32(header, CHUNK_MAGIC);
+    putU32(header + 4, static_cast<quint32>(count));
+    putU32(header + 8, static_cast<quint32>(m_payload.size()));
+    putU32(header + 12, 0);
+    putI64(header + 16, chunk.firstTime);
+    putI64(header + 24, chunk.lastTime);
+    write(header, CHUNK_HEADER_SIZE);
+    write(m_payload.constData(), m_payload.size());
+
+    // Complete chunks reach the disk even if the process dies before close()
+    m_file.flush();
+
+    m_states.resize(0);
+    m_times.resize(0);
+    m_flags.resize(0);
+}
+
+void EntityStateRecorder::write(const uchar* data, int size)
+{
+    const qint64 written = m_file.write(reinterpret_cast<const char*>(data), size);
+    if (written != size) {
+        m_failed = true;
+    }
+    if (written > 0) {
+        m_bytesWritten += written;
+    }
+}
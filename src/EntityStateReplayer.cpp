@@ -0,0 +1,358 @@
+#include "EntityStateReplayer.h"
+#include "EntityManager.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+using namespace EntityStateLog;
+
+namespace {
+
+// Timer period of timed playback
+const int REPLAY_TICK_MS = 10;
+
+/**
+ * @brief State count of the chunk at an offset, if its header is sound
+ * The chunk must lie before limit and every state take at least its flags
+ * byte, which bounds what the count can make the replayer allocate.
+ * @return -1 if the header is damaged or out of range
+ */
+int chunkStateCount(const uchar* data, qint64 offset, qint64 limit)
+{
+    if (offset < FILE_HEADER_SIZE || offset + CHUNK_HEADER_SIZE > limit) {
+        return -1;
+    }
+
+    const uchar* header = data + offset;
+    const qint64 stateCount = getU32(header + 4);
+    const qint64 payloadBytes = getU32(header + 8);
+    if (getU32(header) != CHUNK_MAGIC || offset + CHUNK_HEADER_SIZE + payloadBytes > limit
+        || stateCount <= 0 || stateCount > payloadBytes || stateCount > std::numeric_limits<int>::max()) {
+        return -1;
+    }
+    return static_cast<int>(stateCount);
+}
+
+} // namespace
+
+EntityStateReplayer::EntityStateReplayer(EntityManager* manager, QObject* parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_speed(1.0)
+    , m_createEntities(true)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_stateCount(0)
+    , m_nextChunk(0)
+    , m_cursor(0)
+    , m_playStart(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(REPLAY_TICK_MS);
+    connect(m_timer, &QTimer::timeout, this, &EntityStateReplayer::onTick);
+}
+
+EntityStateReplayer::~EntityStateReplayer()
+{
+    close();
+}
+
+bool EntityStateReplayer::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[EntityStateReplayer] Cannot read" << path;
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_size >= FILE_HEADER_SIZE ? m_file.map(0, m_size) : nullptr;
+    if (!m_data || getU32(m_data) != FILE_MAGIC || getU32(m_data + 4) != VERSION) {
+        qWarning() << "[EntityStateReplayer]" << path << "is not an entity state log";
+        close();
+        return false;
+    }
+
+    if (!readIndex()) {
+        scanChunks();
+        qWarning() << "[EntityStateReplayer]" << path << "has no index (recording not closed),"
+                   << m_chunks.size() << "complete chunks found";
+    }
+
+    int largestChunk = 0;
+    for (const ChunkInfo& chunk : m_chunks) {
+        m_stateCount += chunk.stateCount;
+        largestChunk = qMax(largestChunk, chunk.stateCount);
+    }
+    m_states.reserve(largestChunk);
+    m_times.reserve(largestChunk);
+    m_flags.reserve(largestChunk);
+
+    return true;
+}
+
+void EntityStateReplayer::close()
+{
+    m_timer->stop();
+
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_file.close();
+
+    m_size = 0;
+    m_chunks.clear();
+    m_stateCount = 0;
+    m_nextChunk = 0;
+    m_states.resize(0);
+    m_cursor = 0;
+    m_knownIds.clear();
+}
+
+void EntityStateReplayer::setSpeed(double speed)
+{
+    // Keep the current position when changing speed mid-playback
+    if (isRunning()) {
+        m_playStart = m_speed > 0.0 ? m_playStart + static_cast<qint64>(m_clock.elapsed() * m_speed)
+                                    : position();
+        m_clock.restart();
+    }
+    m_speed = qMax(0.0, speed);
+}
+
+void EntityStateReplayer::start()
+{
+    if (!isOpen()) {
+        return;
+    }
+    m_playStart = position();
+    m_clock.start();
+    m_timer->start();
+}
+
+void EntityStateReplayer::stop()
+{
+    m_timer->stop();
+}
+
+bool EntityStateReplayer::seek(qint64 recordTime)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // First chunk that still has states at or after the time
+    auto chunk = std::lower_bound(m_chunks.constBegin(), m_chunks.constEnd(), recordTime,
+                                  [](const ChunkInfo& info, qint64 time) { return info.lastTime < time; });
+
+    m_states.resize(0);
+    m_cursor = 0;
+    m_nextChunk = static_cast<int>(chunk - m_chunks.constBegin());
+    if (ensureBatch()) {
+        // All states of a batch share one time, so this stops on a batch start
+        while (m_cursor < m_states.size() && m_times[m_cursor] < recordTime) {
+            ++m_cursor;
+        }
+    }
+
+    m_playStart = recordTime;
+    m_clock.restart();
+    return true;
+}
+
+qint64 EntityStateReplayer::replayAll()
+{
+    qint64 fed = 0;
+    int count;
+    while ((count = feedBatch()) > 0) {
+        fed += count;
+    }
+    return fed;
+}
+
+int EntityStateReplayer::nextBatch(const EntityState*& states)
+{
+    if (!ensureBatch()) {
+        states = nullptr;
+        return 0;
+    }
+
+    const int begin = m_cursor;
+    int end = begin + 1;
+    while (end < m_states.size() && !(m_flags[end] & FLAG_BATCH_START)) {
+        ++end;
+    }
+    m_cursor = end;
+
+    states = m_states.constData() + begin;
+    return end - begin;
+}
+
+bool EntityStateReplayer::atEnd() const
+{
+    return m_cursor >= m_states.size() && m_nextChunk >= m_chunks.size();
+}
+
+qint64 EntityStateReplayer::position() const
+{
+    if (m_cursor < m_states.size()) {
+        return m_times[m_cursor];
+    }
+    if (m_nextChunk < m_chunks.size()) {
+        return m_chunks[m_nextChunk].firstTime;
+    }
+    return durationMs();
+}
+
+qint64 EntityStateReplayer::durationMs() const
+{
+    return m_chunks.isEmpty() ? 0 : m_chunks.last().lastTime;
+}
+
+void EntityStateReplayer::onTick()
+{
+    if (m_speed <= 0.0) {
+        // One chunk per tick
+        do {
+            feedBatch();
+        } while (m_cursor < m_states.size());
+    } else {
+        const qint64 target = m_playStart + static_cast<qint64>(m_clock.elapsed() * m_speed);
+        while (!atEnd() && position() <= target) {
+            feedBatch();
+        }
+    }
+
+    if (atEnd()) {
+        m_timer->stop();
+        emit finished();
+    }
+}
+
+bool EntityStateReplayer::readIndex()
+{
+    if (m_size < FILE_HEADER_SIZE + TRAILER_SIZE) {
+        return false;
+    }
+
+    const uchar* trailer = m_data + m_size - TRAILER_SIZE;
+    const qint64 indexOffset = getI64(trailer);
+    const qint64 chunkCount = getU32(trailer + 8);
+    if (getU32(trailer + 12) != INDEX_MAGIC || indexOffset < FILE_HEADER_SIZE || indexOffset > m_size
+        || indexOffset + chunkCount * INDEX_ENTRY_SIZE + TRAILER_SIZE != m_size) {
+        return false;
+    }
+
+    m_chunks.resize(static_cast<int>(chunkCount));
+    const uchar* entry = m_data + indexOffset;
+    for (ChunkInfo& chunk : m_chunks) {
+        chunk.offset = getI64(entry);
+        chunk.firstTime = getI64(entry + 8);
+        chunk.lastTime = getI64(entry + 16);
+        const qint64 stateCount = getU32(entry + 24);
+        entry += INDEX_ENTRY_SIZE;
+
+        // The entry sizes the decode buffers, so it must match a sound chunk
+        const int headerCount = chunkStateCount(m_data, chunk.offset, indexOffset);
+        if (headerCount < 0 || stateCount != headerCount) {
+            m_chunks.clear();
+            return false;
+        }
+        chunk.stateCount = headerCount;
+    }
+    return true;
+}
+
+void EntityStateReplayer::scanChunks()
+{
+    m_chunks.clear();
+
+    qint64 offset = FILE_HEADER_SIZE;
+    while (offset + CHUNK_HEADER_SIZE <= m_size) {
+        const uchar* header = m_data + offset;
+        const qint64 payloadBytes = getU32(header + 8);
+        const int stateCount = chunkStateCount(m_data, offset, m_size);
+        if (stateCount < 0) {
+            break;
+        }
+
+        ChunkInfo chunk;
+        chunk.offset = offset;
+        chunk.stateCount = stateCount;
+        chunk.firstTime = getI64(header + 16);
+        chunk.lastTime = getI64(header + 24);
+        m_chunks.append(chunk);
+
+        offset += CHUNK_HEADER_SIZE + payloadBytes;
+    }
+}
+
+bool EntityStateReplayer::loadChunk(int chunk)
+{
+    const ChunkInfo& info = m_chunks[chunk];
+    const uchar* header = m_data + info.offset;
+    const qint64 payloadBytes = getU32(header + 8);
+
+    // Every state takes at least its flags byte
+    if (getU32(header) != CHUNK_MAGIC || qint64(getU32(header + 4)) != info.stateCount
+        || info.offset + CHUNK_HEADER_SIZE + payloadBytes > m_size || info.stateCount > payloadBytes) {
+        qWarning() << "[EntityStateReplayer] Chunk" << chunk << "is damaged";
+        return false;
+    }
+
+    m_states.resize(info.stateCount);
+    m_times.resize(info.stateCount);
+    m_flags.resize(info.stateCount);
+    if (!m_codec.decode(header + CHUNK_HEADER_SIZE, static_cast<int>(payloadBytes), info.stateCount,
+                        m_states.data(), m_times.data(), m_flags.data())) {
+        qWarning() << "[EntityStateReplayer] Chunk" << chunk << "does not decode";
+        return false;
+    }
+    return true;
+}
+
+bool EntityStateReplayer::ensureBatch()
+{
+    while (m_cursor >= m_states.size()) {
+        if (m_nextChunk >= m_chunks.size()) {
+            return false;
+        }
+
+        const int chunk = m_nextChunk++;
+        m_cursor = 0;
+        if (!loadChunk(chunk)) {
+            // Nothing after a damaged chunk is trusted
+            m_states.resize(0);
+            m_nextChunk = m_chunks.size();
+            return false;
+        }
+    }
+    return true;
+}
+
+int EntityStateReplayer::feedBatch()
+{
+    const EntityState* states;
+    const int count = nextBatch(states);
+    if (count == 0 || !m_manager) {
+        return count;
+    }
+
+    if (m_createEntities) {
+        for (int i = 0; i < count; ++i) {
+            const int id = states[i].entityId;
+            if (!m_knownIds.contains(id)) {
+                m_knownIds.insert(id);
+                if (!m_manager->getEntityObject(id)) {
+                    m_manager->createEntity(id, states[i].type, QString());
+                }
+            }
+        }
+    }
+
+    m_manager->updateEntityStates(states, count);
+    return count;
+}
@@ -0,0 +1,543 @@
+#include "EntityStore.h"
+#include "Geodesy.h"
+#include "LodConfig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+#include <utility>
+
+namespace {
+
+template <typename T>
+void swapRemove(QVector<T>& column, int index)
+{
+    int last = column.size() - 1;
+    if (index != last) {
+        column[index] = column[last];
+    }
+    column.resize(last);
+}
+
+// Visiting every cell of a range costs more than walking the occupied
+// cells once the range is this many times larger than the hash
+const double CELL_SCAN_FACTOR = 8.0;
+
+double cellRangeVolume(int ix0, int iy0, int iz0, int ix1, int iy1, int iz1)
+{
+    return (static_cast<double>(ix1) - ix0 + 1.0)
+         * (static_cast<double>(iy1) - iy0 + 1.0)
+         * (static_cast<double>(iz1) - iz0 + 1.0);
+}
+
+// Geodetic boxes reaching outside these altitudes are scanned instead:
+// further down the ECEF bound below no longer holds, further up its cell
+// coordinates leave the hash key range
+const double GEODETIC_BOUND_MIN_ALT = -0.5 * Geodesy::WGS84_B;
+const double GEODETIC_BOUND_MAX_ALT = 1.0e8;
+
+// Slack for the rounding between stored geodetic and ECEF positions
+const double GEODETIC_BOUND_MARGIN = 1.0;
+
+/**
+ * @brief Axis-aligned ECEF box around a longitude/latitude/altitude box
+ * z grows with latitude and altitude, so its range comes from the latitude
+ * ends. The distance from the polar axis is largest at the latitude closest
+ * to the equator and the highest altitude, smallest at the latitude furthest
+ * from it and the lowest altitude; x and y of the annular sector between the
+ * two take their extremes at the longitude ends or at multiples of 90 degrees.
+ * @return false if the altitudes are outside the range the bound handles
+ */
+bool geodeticBoxBounds(double minLon, double maxLon, double minLat, double maxLat,
+                       double minAlt, double maxAlt, osg::Vec3d& minCorner, osg::Vec3d& maxCorner)
+{
+    if (minAlt < GEODETIC_BOUND_MIN_ALT || maxAlt > GEODETIC_BOUND_MAX_ALT) {
+        return false;
+    }
+    minLat = std::max(minLat, -90.0);
+    maxLat = std::min(maxLat, 90.0);
+    if (minLon > maxLon) {
+        maxLon += 360.0;
+    }
+
+    // At longitude 0, x is the distance from the polar axis
+    double rMax, rMin, zMin, zMax, unused, z;
+    double nearLat = minLat > 0.0 ? minLat : (maxLat < 0.0 ? maxLat : 0.0);
+    double farLat = std::abs(minLat) > std::abs(maxLat) ? minLat : maxLat;
+    Geodesy::geodeticToEcef(0.0, nearLat, maxAlt, rMax, unused, z);
+    Geodesy::geodeticToEcef(0.0, farLat, minAlt, rMin, unused, z);
+    rMin = std::max(rMin, 0.0);
+    Geodesy::geodeticToEcef(0.0, minLat, minAlt, unused, unused, zMin);
+    Geodesy::geodeticToEcef(0.0, minLat, maxAlt, unused, unused, z);
+    zMin = std::min(zMin, z);
+    Geodesy::geodeticToEcef(0.0, maxLat, minAlt, unused, unused, zMax);
+    Geodesy::geodeticToEcef(0.0, maxLat, maxAlt, unused, unused, z);
+    zMax = std::max(zMax, z);
+
+    double xMin = rMax, xMax = -rMax, yMin = rMax, yMax = -rMax;
+    auto extend = [&](double lon) {
+        double c = std::cos(osg::DegreesToRadians(lon));
+        double s = std::sin(osg::DegreesToRadians(lon));
+        xMin = std::min(xMin, std::min(rMin * c, rMax * c));
+        xMax = std::max(xMax, std::max(rMin * c, rMax * c));
+        yMin = std::min(yMin, std::min(rMin * s, rMax * s));
+        yMax = std::max(yMax, std::max(rMin * s, rMax * s));
+    };
+    if (maxLon - minLon >= 360.0) {
+        xMin = yMin = -rMax;
+        xMax = yMax = rMax;
+    } else {
+        extend(minLon);
+        extend(maxLon);
+        for (double quadrant = std::ceil(minLon / 90.0); quadrant * 90.0 <= maxLon; quadrant += 1.0) {
+            extend(quadrant * 90.0);
+        }
+    }
+
+    const osg::Vec3d margin(GEODETIC_BOUND_MARGIN, GEODETIC_BOUND_MARGIN, GEODETIC_BOUND_MARGIN);
+    minCorner = osg::Vec3d(xMin, yMin, zMin) - margin;
+    maxCorner = osg::Vec3d(xMax, yMax, zMax) + margin;
+    return true;
+}
+
+
+} // namespace
+
+EntityStore::EntityStore()
+    : m_maxRadius(0.0)
+    , m_grid(LodConfig::SPATIAL_CELL_SIZE)
+{
+}
+
+void EntityStore::reserve(int capacity)
+{
+    m_ids.reserve(capacity);
+    m_objects.reserve(capacity);
+    m_worldX.reserve(capacity);
+    m_worldY.reserve(capacity);
+    m_worldZ.reserve(capacity);
+    m_lon.reserve(capacity);
+    m_lat.reserve(capacity);
+    m_alt.reserve(capacity);
+    m_radius.reserve(capacity);
+    m_distance.reserve(capacity);
+}
+
+int EntityStore::add(int entityId, Object3D* object)
+{
+    m_ids.append(entityId);
+    m_objects.append(object);
+    m_worldX.append(0.0);
+    m_worldY.append(0.0);
+    m_worldZ.append(0.0);
+    m_lon.append(0.0);
+    m_lat.append(0.0);
+    m_alt.append(0.0);
+    m_radius.append(0.0f);
+    m_distance.append(0.0f);
+
+    int index = m_ids.size() - 1;
+    m_grid.insert(index, osg::Vec3d(0.0, 0.0, 0.0));
+    return index;
+}
+
+int EntityStore::remove(int index)
+{
+    if (index < 0 || index >= m_ids.size()) {
+        return -1;
+    }
+
+    bool wasLast = index == m_ids.size() - 1;
+
+    m_grid.remove(index);
+
+    swapRemove(m_ids, index);
+    swapRemove(m_objects, index);
+    swapRemove(m_worldX, index);
+    swapRemove(m_worldY, index);
+    swapRemove(m_worldZ, index);
+    swapRemove(m_lon, index);
+    swapRemove(m_lat, index);
+    swapRemove(m_alt, index);
+    swapRemove(m_radius, index);
+    swapRemove(m_distance, index);
+
+    return wasLast ? -1 : m_ids[index];
+}
+
+void EntityStore::clear()
+{
+    // resize(0) keeps the capacity for the next scenario
+    m_ids.resize(0);
+    m_objects.resize(0);
+    m_worldX.resize(0);
+    m_worldY.resize(0);
+    m_worldZ.resize(0);
+    m_lon.resize(0);
+    m_lat.resize(0);
+    m_alt.resize(0);
+    m_radius.resize(0);
+    m_maxRadius = 0.0;
+    m_distance.resize(0);
+    m_grid.clear();
+}
+
+void EntityStore::computeCameraDistances(const osg::Vec3d& eye)
+{
+    const int count = m_ids.size();
+    const double ex = eye.x();
+    const double ey = eye.y();
+    const double ez = eye.z();
+
+    // Plain pointers: data() detaches once here instead of per element,
+    // which leaves a loop the compiler vectorizes
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+    float* dist = m_distance.data();
+
+    for (int i = 0; i < count; ++i) {
+        float dx = static_cast<float>(wx[i] - ex);
+        float dy = static_cast<float>(wy[i] - ey);
+        float dz = static_cast<float>(wz[i] - ez);
+        dist[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+template <typename Test>
+void EntityStore::collectInRange(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner,
+                                 Test test, QVector<int>& indices) const
+{
+    const int ix0 = m_grid.cellCoord(minCorner.x()), ix1 = m_grid.cellCoord(maxCorner.x());
+    const int iy0 = m_grid.cellCoord(minCorner.y()), iy1 = m_grid.cellCoord(maxCorner.y());
+    const int iz0 = m_grid.cellCoord(minCorner.z()), iz1 = m_grid.cellCoord(maxCorner.z());
+
+    if (cellRangeVolume(ix0, iy0, iz0, ix1, iy1, iz1) > CELL_SCAN_FACTOR * m_grid.cells().size()) {
+        // Range larger than the populated world - walk the hash instead
+        for (auto it = m_grid.cells().constBegin(); it != m_grid.cells().constEnd(); ++it) {
+            int ix, iy, iz;
+            SpatialHash::unpackKey(it.key(), ix, iy, iz);
+            if (ix < ix0 || ix > ix1 || iy < iy0 || iy > iy1 || iz < iz0 || iz > iz1) {
+                continue;
+            }
+            for (int slot : it.value()) {
+                if (test(slot)) {
+                    indices.append(slot);
+                }
+            }
+        }
+        return;
+    }
+
+    for (int ix = ix0; ix <= ix1; ++ix) {
+        for (int iy = iy0; iy <= iy1; ++iy) {
+            for (int iz = iz0; iz <= iz1; ++iz) {
+                const SpatialHash::Cell* cell = m_grid.cell(ix, iy, iz);
+                if (!cell) {
+                    continue;
+                }
+                for (int slot : *cell) {
+                    if (test(slot)) {
+                        indices.append(slot);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int EntityStore::queryRadius(const osg::Vec3d& center, double radius, QVector<int>& indices) const
+{
+    indices.resize(0);
+    if (radius < 0.0 || m_ids.isEmpty()) {
+        return 0;
+    }
+
+    const osg::Vec3d extent(radius, radius, radius);
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    const double radius2 = radius * radius;
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+
+    collectInRange(center - extent, center + extent, [=](int slot) {
+        double dx = wx[slot] - cx;
+        double dy = wy[slot] - cy;
+        double dz = wz[slot] - cz;
+        return dx * dx + dy * dy + dz * dz <= radius2;
+    }, indices);
+    return indices.size();
+}
+
+int EntityStore::queryNearest(const osg::Vec3d& center, int k, QVector<int>& indices) const
+{
+    indices.resize(0);
+    const int count = m_ids.size();
+    if (k <= 0 || count == 0) {
+        return 0;
+    }
+    k = std::min(k, count);
+
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+
+    // Max-heap of the best k so far: top is the current k-th distance
+    typedef std::pair<double, int> Candidate;
+    std::priority_queue<Candidate> best;
+    auto consider = [&](int slot) {
+        double dx = wx[slot] - cx;
+        double dy = wy[slot] - cy;
+        double dz = wz[slot] - cz;
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (static_cast<int>(best.size()) < k) {
+            best.push(Candidate(d2, slot));
+        } else if (d2 < best.top().first) {
+            best.pop();
+            best.push(Candidate(d2, slot));
+        }
+    };
+    auto considerCell = [&](int ix, int iy, int iz) {
+        const SpatialHash::Cell* cell = m_grid.cell(ix, iy, iz);
+        if (cell) {
+            for (int slot : *cell) {
+                consider(slot);
+            }
+        }
+    };
+
+    const int cx0 = m_grid.cellCoord(cx);
+    const int cy0 = m_grid.cellCoord(cy);
+    const int cz0 = m_grid.cellCoord(cz);
+    const double cellSize = m_grid.cellSize();
+    const double scanLimit = CELL_SCAN_FACTOR * m_grid.cells().size();
+
+    for (int ring = 0; ; ++ring) {
+        double side = 2.0 * ring + 1.0;
+        if (side * side * side > scanLimit) {
+            // Sparse neighbourhood - a linear pass is cheaper than more rings
+            while (!best.empty()) {
+                best.pop();
+            }
+            for (int slot = 0; slot < count; ++slot) {
+                consider(slot);
+            }
+            break;
+        }
+
+        // Visit only the shell of cells at Chebyshev distance ring
+        for (int dx = -ring; dx <= ring; ++dx) {
+            for (int dy = -ring; dy <= ring; ++dy) {
+                bool onFace = std::abs(dx) == ring || std::abs(dy) == ring;
+                if (onFace) {
+                    for (int dz = -ring; dz <= ring; ++dz) {
+                        considerCell(cx0 + dx, cy0 + dy, cz0 + dz);
+                    }
+                } else {
+                    considerCell(cx0 + dx, cy0 + dy, cz0 - ring);
+                    considerCell(cx0 + dx, cy0 + dy, cz0 + ring);
+                }
+            }
+        }
+
+        // Unvisited cells are at least ring cells away from the centre
+        if (static_cast<int>(best.size()) == k) {
+            double reach = ring * cellSize;
+            if (best.top().first <= reach * reach) {
+                break;
+            }
+        }
+    }
+
+    indices.resize(static_cast<int>(best.size()));
+    for (int i = indices.size() - 1; i >= 0; --i) {
+        indices[i] = best.top().second;
+        best.pop();
+    }
+    return indices.size();
+}
+
+int EntityStore::queryBox(const osg::Vec3d& minCorner, const osg::Vec3d& maxCorner, QVector<int>& indices) const
+{
+    indices.resize(0);
+    if (m_ids.isEmpty()) {
+        return 0;
+    }
+
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+
+    collectInRange(minCorner, maxCorner, [=](int slot) {
+        return wx[slot] >= minCorner.x() && wx[slot] <= maxCorner.x()
+            && wy[slot] >= minCorner.y() && wy[slot] <= maxCorner.y()
+            && wz[slot] >= minCorner.z() && wz[slot] <= maxCorner.z();
+    }, indices);
+    return indices.size();
+}
+
+int EntityStore::queryGeodeticBox(double minLon, double maxLon, double minLat, double maxLat,
+                                  double minAlt, double maxAlt, QVector<int>& indices) const
+{
+    indices.resize(0);
+    if (m_ids.isEmpty() || minLat > maxLat || minAlt > maxAlt) {
+        return 0;
+    }
+
+    const double* lon = m_lon.constData();
+    const double* lat = m_lat.constData();
+    const double* alt = m_alt.constData();
+    const bool wraps = minLon > maxLon;
+
+    auto test = [=](int slot) {
+        bool inLon = wraps ? (lon[slot] >= minLon || lon[slot] <= maxLon)
+                           : (lon[slot] >= minLon && lon[slot] <= maxLon);
+        return inLon && lat[slot] >= minLat && lat[slot] <= maxLat
+                     && alt[slot] >= minAlt && alt[slot] <= maxAlt;
+    };
+
+    osg::Vec3d minCorner, maxCorner;
+    if (geodeticBoxBounds(minLon, maxLon, minLat, maxLat, minAlt, maxAlt, minCorner, maxCorner)) {
+        collectInRange(minCorner, maxCorner, test, indices);
+        return indices.size();
+    }
+
+    const int count = m_ids.size();
+    for (int i = 0; i < count; ++i) {
+        if (test(i)) {
+            indices.append(i);
+        }
+    }
+    return indices.size();
+}
+
+int EntityStore::queryPolytope(const osg::Polytope& polytope, QVector<int>& indices) const
+{
+    indices.resize(0);
+    if (m_ids.isEmpty()) {
+        return 0;
+    }
+
+    // Plane coefficients in double; osg::Plane::intersect() takes a float box
+    const osg::Polytope::PlaneList& planeList = polytope.getPlaneList();
+    QVector<osg::Vec4d> planes;
+    planes.reserve(static_cast<int>(planeList.size()));
+    for (const osg::Plane& plane : planeList) {
+        planes.append(plane.asVec4());
+    }
+    const int planeCount = planes.size();
+    const osg::Vec4d* p = planes.constData();
+
+    const double cellSize = m_grid.cellSize();
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+
+    for (auto it = m_grid.cells().constBegin(); it != m_grid.cells().constEnd(); ++it) {
+        const SpatialHash::Cell& cell = it.value();
+        if (cell.isEmpty()) {
+            continue;
+        }
+
+        int ix, iy, iz;
+        SpatialHash::unpackKey(it.key(), ix, iy, iz);
+        const double x0 = ix * cellSize, y0 = iy * cellSize, z0 = iz * cellSize;
+        const double x1 = x0 + cellSize, y1 = y0 + cellSize, z1 = z0 + cellSize;
+
+        // Per plane: the corner furthest along the normal decides rejection,
+        // the nearest one whether the cell is entirely inside
+        bool outside = false;
+        bool inside = true;
+        for (int i = 0; i < planeCount && !outside; ++i) {
+            const osg::Vec4d& v = p[i];
+            double far = v[0] * (v[0] >= 0.0 ? x1 : x0)
+                       + v[1] * (v[1] >= 0.0 ? y1 : y0)
+                       + v[2] * (v[2] >= 0.0 ? z1 : z0) + v[3];
+            double near = v[0] * (v[0] >= 0.0 ? x0 : x1)
+                        + v[1] * (v[1] >= 0.0 ? y0 : y1)
+                        + v[2] * (v[2] >= 0.0 ? z0 : z1) + v[3];
+            outside = far < 0.0;
+            inside = inside && near >= 0.0;
+        }
+        if (outside) {
+            continue;
+        }
+        if (inside) {
+            indices += cell;
+            continue;
+        }
+
+        for (int slot : cell) {
+            bool contained = true;
+            for (int i = 0; i < planeCount && contained; ++i) {
+                const osg::Vec4d& v = p[i];
+                contained = v[0] * wx[slot] + v[1] * wy[slot] + v[2] * wz[slot] + v[3] >= 0.0;
+            }
+            if (contained) {
+                indices.append(slot);
+            }
+        }
+    }
+    return indices.size();
+}
+
+int EntityStore::queryRay(const osg::Vec3d& origin, const osg::Vec3d& direction, double tanTolerance,
+                          QVector<RayHit>& hits) const
+{
+    hits.resize(0);
+    osg::Vec3d dir = direction;
+    if (m_ids.isEmpty() || dir.normalize() <= 0.0) {
+        return 0;
+    }
+
+    const double ox = origin.x(), oy = origin.y(), oz = origin.z();
+    const double ux = dir.x(), uy = dir.y(), uz = dir.z();
+    const double cellSize = m_grid.cellSize();
+    const double cellRadius = 0.5 * std::sqrt(3.0) * cellSize;
+    const double* wx = m_worldX.constData();
+    const double* wy = m_worldY.constData();
+    const double* wz = m_worldZ.constData();
+    const float* radius = m_radius.constData();
+
+    // Squared distance of a point to the ray and its position along it
+    auto project = [&](double px, double py, double pz, double& t) {
+        double dx = px - ox, dy = py - oy, dz = pz - oz;
+        t = dx * ux + dy * uy + dz * uz;
+        double tc = std::max(t, 0.0);
+        double ex = dx - tc * ux, ey = dy - tc * uy, ez = dz - tc * uz;
+        return ex * ex + ey * ey + ez * ez;
+    };
+
+    for (auto it = m_grid.cells().constBegin(); it != m_grid.cells().constEnd(); ++it) {
+        const SpatialHash::Cell& cell = it.value();
+        if (cell.isEmpty()) {
+            continue;
+        }
+
+        // Cell bounding sphere, grown by the largest entity and the cone
+        // width at the far side of the cell
+        int ix, iy, iz;
+        SpatialHash::unpackKey(it.key(), ix, iy, iz);
+        double t;
+        double d2 = project((ix + 0.5) * cellSize, (iy + 0.5) * cellSize, (iz + 0.5) * cellSize, t);
+        double reach = cellRadius + m_maxRadius + std::max(t + cellRadius, 0.0) * tanTolerance;
+        if (t < -reach || d2 > reach * reach) {
+            continue;
+        }
+
+        for (int slot : cell) {
+            double d2Entity = project(wx[slot], wy[slot], wz[slot], t);
+            double hitRadius = radius[slot] + std::max(t, 0.0) * tanTolerance;
+            if (t >= -radius[slot] && d2Entity <= hitRadius * hitRadius) {
+                RayHit hit = { slot, t };
+                hits.append(hit);
+            }
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) {
+        return a.distance < b.distance;
+    });
+    return hits.size();
+}
@@ -0,0 +1,461 @@
+#include "LoadGenerator.h"
+#include <QRunnable>
+#include <QThread>
+#include <osg/Math>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Spherical Earth of the motion models
+const double EARTH_RADIUS = 6371008.8;
+const double GRAVITY = 9.80665;
+const double DEG = 180.0 / osg::PI;
+const double RAD = osg::PI / 180.0;
+
+// Salvo missiles leave within this angle of the salvo bearing
+const double SALVO_SPREAD_RAD = 10.0 * RAD;
+
+quint64 splitMix(quint64 x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+double toUniform(quint64 bits)
+{
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Random stream of one entity, the same on every thread and run
+ */
+class EntityRandom
+{
+public:
+    EntityRandom(quint64 seed, int entityId, quint32 stream = 0)
+        : m_state(splitMix(seed ^ splitMix((static_cast<quint64>(static_cast<quint32>(entityId)) << 32) | stream)))
+    {
+    }
+
+    double uniform()
+    {
+        m_state = splitMix(m_state);
+        return toUniform(m_state);
+    }
+
+    double uniform(double low, double high)
+    {
+        return low + (high - low) * uniform();
+    }
+
+private:
+    quint64 m_state;
+};
+
+/**
+ * @brief Point at an angular distance along a great circle
+ * @param lat1 Start latitude (radians)
+ * @param lon1 Start longitude (radians)
+ * @param bearing Initial bearing (radians, clockwise from north)
+ * @param angle Distance / Earth radius
+ * @param bearing2 Output: bearing of the great circle at the point
+ */
+void greatCircle(double lat1, double lon1, double bearing, double angle,
+                 double& lat2, double& lon2, double& bearing2)
+{
+    const double sinLat1 = std::sin(lat1);
+    const double cosLat1 = std::cos(lat1);
+    const double sinAngle = std::sin(angle);
+    const double cosAngle = std::cos(angle);
+    const double sinBearing = std::sin(bearing);
+    const double cosBearing = std::cos(bearing);
+
+    const double sinLat2 = std::max(-1.0, std::min(1.0, sinLat1 * cosAngle + cosLat1 * sinAngle * cosBearing));
+    lat2 = std::asin(sinLat2);
+    lon2 = lon1 + std::atan2(sinBearing * sinAngle * cosLat1, cosAngle - sinLat1 * sinLat2);
+    bearing2 = std::atan2(sinBearing * cosLat1, cosAngle * cosLat1 * cosBearing - sinLat1 * sinAngle);
+}
+
+double wrapLongitude(double lonDeg)
+{
+    return std::remainder(lonDeg, 360.0);
+}
+
+double wrapHeading(double headingDeg)
+{
+    const double heading = std::fmod(headingDeg, 360.0);
+    return heading < 0.0 ? heading + 360.0 : heading;
+}
+
+} // namespace
+
+/**
+ * @brief Runs every n-th block of a pass on a pool thread
+ */
+class LoadGenerator::BlockTask : public QRunnable
+{
+public:
+    explicit BlockTask(LoadGenerator* generator)
+        : m_generator(generator)
+        , m_first(0)
+        , m_stride(1)
+    {
+        setAutoDelete(false);
+    }
+
+    void setBlocks(int first, int stride)
+    {
+        m_first = first;
+        m_stride = stride;
+    }
+
+    virtual void run()
+    {
+        for (int block = m_first; block < m_generator->m_blockCount; block += m_stride) {
+            m_generator->generateBlock(block);
+        }
+    }
+
+private:
+    LoadGenerator* m_generator;
+    int m_first;
+    int m_stride;
+};
+
+LoadGenerator::LoadGenerator()
+    : LoadGenerator(Config())
+{
+}
+
+LoadGenerator::LoadGenerator(const Config& config)
+    : m_entityData(nullptr)
+    , m_stateData(nullptr)
+    , m_entityCount(0)
+    , m_blockCount(0)
+{
+    setConfig(config);
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    m_pool.waitForDone();
+    qDeleteAll(m_tasks);
+}
+
+void LoadGenerator::setConfig(const Config& config)
+{
+    m_config = config;
+
+    m_pool.waitForDone();
+    qDeleteAll(m_tasks);
+    m_tasks.clear();
+    const int threads = config.threadCount > 0 ? config.threadCount : QThread::idealThreadCount();
+    m_pool.setMaxThreadCount(std::max(1, threads));
+    for (int i = 0; i < std::max(1, threads); ++i) {
+        m_tasks.append(new BlockTask(this));
+    }
+
+    // Population plus a few salvos in flight
+    const int capacity = config.capacity > 0
+        ? config.capacity
+        : config.entityCount + (config.salvoRate > 0.0 ? 4 * config.salvoSize : 0);
+    const int blocks = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    m_entities.reserve(capacity);
+    m_states.reserve(capacity);
+    m_spawned.reserve(capacity);
+    m_despawned.reserve(capacity);
+    m_blockStates.reserve(blocks);
+    m_blockExpired.reserve(blocks);
+
+    reset();
+}
+
+void LoadGenerator::reset()
+{
+    m_time = 0.0;
+    m_started = false;
+    m_nextId = m_config.firstId;
+    m_pendingReplacements = 0;
+    m_spawnCount = 0;
+    m_random = splitMix(m_config.seed ^ 0x5DEECE66DULL);
+
+    m_entities.resize(0);
+    m_states.resize(0);
+    m_spawned.resize(0);
+    m_despawned.resize(0);
+}
+
+int LoadGenerator::step(double dt)
+{
+    m_spawned.resize(0);
+    m_despawned.resize(0);
+    m_spawnCount = 0;
+
+    if (!m_started) {
+        m_started = true;
+        for (int i = 0; i < m_config.entityCount; ++i) {
+            spawn(drawModel(), false);
+        }
+    } else {
+        m_time += dt;
+
+        // Churn: whole expected count plus one with the remaining probability
+        int replacements = m_pendingReplacements;
+        m_pendingReplacements = 0;
+        const double churn = m_entities.size() * m_config.churnRate * dt;
+        int removals = static_cast<int>(churn) + (nextUniform() < churn - std::floor(churn) ? 1 : 0);
+        removals = std::min(removals, m_entities.size());
+        for (int i = 0; i < removals; ++i) {
+            const int index = std::min(static_cast<int>(nextUniform() * m_entities.size()), m_entities.size() - 1);
+            m_despawned.append(m_entities[index].id);
+            if (!m_entities[index].salvo) {
+                ++replacements;
+            }
+            removeAt(index);
+        }
+        for (int i = 0; i < replacements; ++i) {
+            spawn(drawModel(), false);
+        }
+
+        // Salvo launches as a Poisson process
+        if (m_config.salvoRate > 0.0 && nextUniform() < 1.0 - std::exp(-m_config.salvoRate * dt)) {
+            const double lon = (m_config.centerLon + (nextUniform() - 0.5) * m_config.spanDeg) * RAD;
+            const double lat = (m_config.centerLat + (nextUniform() - 0.5) * m_config.spanDeg * 0.5) * RAD;
+            const double bearing = nextUniform() * 2.0 * osg::PI;
+            for (int i = 0; i < m_config.salvoSize; ++i) {
+                spawn(BALLISTIC, true, lon, lat, bearing);
+            }
+        }
+    }
+
+    // Evaluate the due entities block by block; the calling thread takes a share
+    m_entityCount = m_entities.size();
+    m_blockCount = (m_entityCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    m_states.resize(m_entityCount);
+    m_blockStates.resize(m_blockCount);
+    m_blockExpired.resize(m_blockCount);
+    m_entityData = m_entities.data();
+    m_stateData = m_states.data();
+
+    const int workers = std::min(m_tasks.size(), m_blockCount);
+    for (int w = 1; w < workers; ++w) {
+        m_tasks[w]->setBlocks(w, workers);
+        m_pool.start(m_tasks[w]);
+    }
+    if (workers > 0) {
+        m_tasks[0]->setBlocks(0, workers);
+        m_tasks[0]->run();
+    }
+    m_pool.waitForDone();
+
+    // Close the gaps between the blocks' ranges
+    int count = 0;
+    for (int block = 0; block < m_blockCount; ++block) {
+        const EntityState* begin = m_stateData + block * BLOCK_SIZE;
+        if (begin != m_stateData + count) {
+            std::copy(begin, begin + m_blockStates[block], m_stateData + count);
+        }
+        count += m_blockStates[block];
+    }
+
+    // Entities spawned in this step sit at the end and were all due
+    m_spawned.resize(m_spawnCount);
+    for (int i = 0; i < m_spawnCount; ++i) {
+        EntitySpec& spec = m_spawned[i];
+        spec.state = m_stateData[count - m_spawnCount + i];
+        spec.modelPath = (spec.state.type == EntityState::SHIP) ? m_config.shipModelPath : m_config.missileModelPath;
+    }
+    m_states.resize(count - m_spawnCount);
+
+    // Impacts, from the back so the entity moved into a freed index is already checked
+    for (int block = m_blockCount - 1; block >= 0; --block) {
+        if (m_blockExpired[block] == 0) {
+            continue;
+        }
+        const int begin = block * BLOCK_SIZE;
+        for (int i = std::min(begin + BLOCK_SIZE, m_entities.size()) - 1; i >= begin; --i) {
+            if (m_entities[i].expired) {
+                m_despawned.append(m_entities[i].id);
+                if (!m_entities[i].salvo) {
+                    ++m_pendingReplacements;
+                }
+                removeAt(i);
+            }
+        }
+    }
+
+    return m_states.size();
+}
+
+void LoadGenerator::spawn(MotionModel model, bool salvo, double lon0, double lat0, double bearing)
+{
+    EntityRandom random(m_config.seed, m_nextId);
+
+    Entity e;
+    e.id = m_nextId++;
+    e.model = model;
+    e.salvo = salvo;
+    e.spawnTime = m_time;
+    e.expired = false;
+    e.updates = 0;
+    e.nextDue = m_time;
+    e.duration = 0.0;
+
+    if (model == BALLISTIC) {
+        e.type = EntityState::MISSILE;
+    } else {
+        e.type = random.uniform() < m_config.missileFraction ? EntityState::MISSILE : EntityState::SHIP;
+    }
+    const bool ship = (e.type == EntityState::SHIP);
+
+    if (salvo) {
+        e.lon0 = lon0;
+        e.lat0 = lat0;
+        e.bearing = bearing + random.uniform(-SALVO_SPREAD_RAD, SALVO_SPREAD_RAD);
+    } else {
+        e.lon0 = (m_config.centerLon + (random.uniform() - 0.5) * m_config.spanDeg) * RAD;
+        e.lat0 = (m_config.centerLat + (random.uniform() - 0.5) * m_config.spanDeg * 0.5) * RAD;
+        e.bearing = random.uniform() * 2.0 * osg::PI;
+    }
+
+    const double speed = ship ? random.uniform(5.0, 15.0) : random.uniform(200.0, 700.0);
+    switch (model) {
+    case GREAT_CIRCLE:
+        e.speed = speed;
+        e.distance = 0.0;
+        e.altitude = ship ? 0.0 : random.uniform(5000.0, 12000.0);
+        break;
+    case ORBIT:
+        e.distance = ship ? random.uniform(2000.0, 20000.0) : random.uniform(10000.0, 50000.0);
+        e.speed = (random.uniform() < 0.5 ? -speed : speed) / e.distance;
+        e.altitude = ship ? 0.0 : random.uniform(5000.0, 12000.0);
+        break;
+    case BALLISTIC:
+        // 45 degree launch over flat ground: apogee a quarter of the range
+        e.distance = random.uniform(50000.0, 1000000.0);
+        e.duration = std::sqrt(2.0 * e.distance / GRAVITY);
+        e.altitude = 0.25 * e.distance;
+        e.speed = 0.0;
+        break;
+    }
+
+    double rate = m_config.maxUpdateRate;
+    const double u = random.uniform();
+    if (m_config.rateDistribution == RATE_UNIFORM) {
+        rate = m_config.minUpdateRate + (m_config.maxUpdateRate - m_config.minUpdateRate) * u;
+    } else if (m_config.rateDistribution == RATE_LOG_UNIFORM) {
+        rate = m_config.minUpdateRate * std::pow(m_config.maxUpdateRate / m_config.minUpdateRate, u);
+    }
+    e.period = 1.0 / std::max(rate, 1e-6);
+    e.phase = random.uniform();
+
+    m_entities.append(e);
+    ++m_spawnCount;
+}
+
+LoadGenerator::MotionModel LoadGenerator::drawModel()
+{
+    const double total = m_config.greatCircleWeight + m_config.orbitWeight + m_config.ballisticWeight;
+    const double u = nextUniform() * total;
+    if (u < m_config.greatCircleWeight || total <= 0.0) {
+        return GREAT_CIRCLE;
+    }
+    if (u < m_config.greatCircleWeight + m_config.orbitWeight) {
+        return ORBIT;
+    }
+    return BALLISTIC;
+}
+
+void LoadGenerator::removeAt(int index)
+{
+    m_entities[index] = m_entities.last();
+    m_entities.resize(m_entities.size() - 1);
+}
+
+void LoadGenerator::generateBlock(int block)
+{
+    const int begin = block * BLOCK_SIZE;
+    const int end = std::min(begin + BLOCK_SIZE, m_entityCount);
+    const double now = m_time;
+    const qint64 timestamp = m_config.startTimestamp + static_cast<qint64>(std::llround(now * 1000.0));
+    const bool poisson = (m_config.timing == TIMING_POISSON);
+
+    EntityState* out = m_stateData + begin;
+    int written = 0;
+    int expired = 0;
+    for (int i = begin; i < end; ++i) {
+        Entity& e = m_entityData[i];
+        const double t = now - e.spawnTime;
+        if (e.model == BALLISTIC && t >= e.duration) {
+            e.expired = true;
+            ++expired;
+            continue;
+        }
+        if (e.nextDue > now) {
+            continue;
+        }
+
+        EntityState& s = out[written++];
+        s = EntityState();
+        s.entityId = e.id;
+        s.type = e.type;
+        s.timestamp = timestamp;
+
+        double lat;
+        double lon;
+        double bearing;
+        switch (e.model) {
+        case GREAT_CIRCLE:
+            greatCircle(e.lat0, e.lon0, e.bearing, e.speed * t / EARTH_RADIUS, lat, lon, bearing);
+            s.alt = e.altitude;
+            s.heading = wrapHeading(bearing * DEG);
+            break;
+        case ORBIT: {
+            // Radial bearing at the point, turned a quarter towards the direction of travel
+            greatCircle(e.lat0, e.lon0, e.bearing + e.speed * t, e.distance / EARTH_RADIUS, lat, lon, bearing);
+            const double turn = e.speed > 0.0 ? 1.0 : -1.0;
+            const double v = std::fabs(e.speed) * e.distance;
+            s.alt = e.altitude;
+            s.heading = wrapHeading(bearing * DEG + turn * 90.0);
+            s.roll = turn * std::atan(v * v / (GRAVITY * e.distance)) * DEG;
+            break;
+        }
+        case BALLISTIC: {
+            const double f = t / e.duration;
+            greatCircle(e.lat0, e.lon0, e.bearing, e.distance * f / EARTH_RADIUS, lat, lon, bearing);
+            s.alt = 4.0 * e.altitude * f * (1.0 - f);
+            s.heading = wrapHeading(bearing * DEG);
+            s.pitch = std::atan(4.0 * e.altitude * (1.0 - 2.0 * f) / e.distance) * DEG;
+            break;
+        }
+        }
+        s.lat = lat * DEG;
+        s.lon = wrapLongitude(lon * DEG);
+
+        // Schedule the next state after now
+        if (poisson) {
+            do {
+                EntityRandom random(m_config.seed, e.id, e.updates + 1);
+                e.nextDue = (e.updates == 0 ? now : e.nextDue) - std::log(1.0 - random.uniform()) * e.period;
+                ++e.updates;
+            } while (e.nextDue <= now);
+        } else {
+            e.nextDue = (e.updates == 0)
+                ? now + e.period * std::max(e.phase, 1e-3)
+                : e.nextDue + e.period * (std::floor((now - e.nextDue) / e.period) + 1.0);
+            ++e.updates;
+        }
+    }
+
+    m_blockStates[block] = written;
+    m_blockExpired[block] = expired;
+}
+
+double LoadGenerator::nextUniform()
+{
+    m_random = splitMix(m_random);
+    return toUniform(m_random);
+}
@@ -1,6 +1,28 @@
 #include "MissileModel.h"
+#include "TraceRecorder.h"
 #include <osg/MatrixTransform>
 
+namespace {
+
+/**
+ * @brief Orange cone shown while the model is missing or still loading, shared by all missiles
+ */
+osg::Node* placeholderModel()
+{
+    static osg::ref_ptr<osg::Geode> placeholder = [] {
+        osg::ref_ptr<osg::Cone> cone = new osg::Cone(osg::Vec3(0, 0, 0), 200.0, 1000.0);
+        osg::ref_ptr<osg::ShapeDrawable> drawable = new osg::ShapeDrawable(cone.get());
+        drawable->setColor(osg::Vec4(1.0, 0.5, 0.0, 1.0));
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode();
+        geode->addDrawable(drawable.get());
+        return geode;
+    }();
+    return placeholder.get();
+}
+
+} // namespace
+
 MissileModel::MissileModel(
     double lon,
     double lat,
@@ -31,29 +53,39 @@ MissileModel::~MissileModel()
 
 bool MissileModel::loadModel(const QString& modelPath)
 {
+    ENTITY_TRACE_SCOPE("io", "MissileModel::loadModel");
+
     // Load 3D model from file
-    m_modelNode = osgDB::readNodeFile(modelPath.toStdString());
-    
-    if (!m_modelNode.valid()) {
-        // If model failed to load, create a simple placeholder (cone)
-        osg::ref_ptr<osg::Cone> cone = new osg::Cone(osg::Vec3(0, 0, 0), 200.0, 1000.0);
-        osg::ref_ptr<osg::ShapeDrawable> drawable = new osg::ShapeDrawable(cone.get());
-        drawable->setColor(osg::Vec4(1.0, 0.5, 0.0, 1.0));
-        
-        osg::ref_ptr<osg::Geode> geode = new osg::Geode();
-        geode->addDrawable(drawable.get());
-        m_modelNode = geode;
+    osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(modelPath.toStdString());
+    setModelNode(model.get());
+    return model.valid();
+}
+
+void MissileModel::setModelNode(osg::Node* model)
+{
+    osg::Node* node = model ? model : placeholderModel();
+    if (!m_modelGroup.valid() || node == m_modelNode.get()) {
+        return;
     }
-    
-    // Add model to the model group
-    if (m_modelGroup.valid() && m_modelNode.valid()) {
-        // Clear existing children
-        m_modelGroup->removeChildren(0, m_modelGroup->getNumChildren());
-        m_modelGroup->addChild(m_modelNode.get());
-        return true;
+
+    // Swap the model child in place - the track lines next to it stay
+    if (!m_modelNode.valid() || !m_modelGroup->replaceChild(m_modelNode.get(), node)) {
+        m_modelGroup->insertChild(0, node);
+    }
+    m_modelNode = node;
+}
+
+void MissileModel::reset()
+{
+    Object3D::reset();
+    clearTrackLines();
+    m_trackLineOffset.set(0, 0, 0);
+
+    // No model, as constructed without a path
+    if (m_modelNode.valid()) {
+        m_modelGroup->removeChild(m_modelNode.get());
+        m_modelNode = nullptr;
     }
-    
-    return false;
 }
 
 void MissileModel::addRadarTrackLine(TrackLine* trackLine, osg::Node* targetNode)
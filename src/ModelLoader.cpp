@@ -0,0 +1,152 @@
+#include "ModelLoader.h"
+#include "TraceRecorder.h"
+#include <QMutexLocker>
+#include <QRunnable>
+#include <osgDB/ReadFile>
+
+/**
+ * @brief Reads one model file on a pool thread
+ */
+class ModelLoader::ReadTask : public QRunnable
+{
+public:
+    ReadTask(ModelLoader* loader, const QString& path)
+        : m_loader(loader)
+        , m_path(path)
+    {
+    }
+
+    virtual void run()
+    {
+        ENTITY_TRACE_SCOPE("io", "ModelLoader::read");
+        osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(m_path.toStdString());
+        m_loader->postResult(m_path, model.get());
+    }
+
+private:
+    ModelLoader* m_loader;
+    QString m_path;
+};
+
+/**
+ * @brief Set by the compile thread once a model's GL objects exist
+ */
+class ModelLoader::CompileDone : public osgUtil::IncrementalCompileOperation::CompileCompletedCallback
+{
+public:
+    CompileDone() : m_done(false) {}
+
+    virtual bool compileCompleted(osgUtil::IncrementalCompileOperation::CompileSet*)
+    {
+        m_done.store(true, std::memory_order_release);
+        // Nothing for the operation to merge - the model is attached by us
+        return true;
+    }
+
+    bool isDone() const { return m_done.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<bool> m_done;
+};
+
+ModelLoader::ModelLoader(int threadCount)
+    : m_resultCount(0)
+{
+    m_pool.setMaxThreadCount(threadCount > 0 ? threadCount : 1);
+}
+
+ModelLoader::~ModelLoader()
+{
+    // Queued reads are dropped, running ones still post into this object
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ModelLoader::setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation* compileOperation)
+{
+    m_compileOperation = compileOperation;
+}
+
+bool ModelLoader::request(const QString& path, osg::ref_ptr<osg::Node>& model)
+{
+    auto it = m_cache.constFind(path);
+    if (it != m_cache.constEnd()) {
+        model = it.value();
+        return true;
+    }
+
+    model = nullptr;
+    if (!m_pending.contains(path)) {
+        m_pending.insert(path);
+        m_pool.start(new ReadTask(this, path));
+    }
+    return false;
+}
+
+int ModelLoader::takeFinished(QVector<Result>& results)
+{
+    results.resize(0);
+
+    // Move the workers' results out under the lock, handle them after
+    if (m_resultCount.load(std::memory_order_acquire) > 0) {
+        QMutexLocker lock(&m_resultMutex);
+        m_arrived.swap(m_results);
+        m_resultCount.store(0, std::memory_order_release);
+    }
+
+    for (const Result& result : m_arrived) {
+        if (m_compileOperation.valid() && result.model.valid()) {
+            Compiling compiling;
+            compiling.result = result;
+            compiling.done = new CompileDone();
+
+            osg::ref_ptr<osgUtil::IncrementalCompileOperation::CompileSet> compileSet =
+                new osgUtil::IncrementalCompileOperation::CompileSet(result.model.get());
+            compileSet->_compileCompletedCallback = compiling.done.get();
+            m_compileOperation->add(compileSet.get());
+            m_compiling.append(compiling);
+        } else {
+            deliver(result, results);
+        }
+    }
+    m_arrived.resize(0);
+
+    // Deliver compiled models, keeping the rest in order
+    int kept = 0;
+    for (int i = 0; i < m_compiling.size(); ++i) {
+        if (m_compiling[i].done->isDone()) {
+            deliver(m_compiling[i].result, results);
+        } else {
+            if (kept != i) {
+                m_compiling[kept] = m_compiling[i];
+            }
+            ++kept;
+        }
+    }
+    m_compiling.resize(kept);
+
+    return results.size();
+}
+
+void ModelLoader::clearCache()
+{
+    m_cache.clear();
+}
+
+void ModelLoader::postResult(const QString& path, osg::Node* model)
+{
+    Result result;
+    result.path = path;
+    result.model = model;
+
+    QMutexLocker lock(&m_resultMutex);
+    m_results.append(result);
+    m_resultCount.store(m_results.size(), std::memory_order_release);
+}
+
+void ModelLoader::deliver(const Result& result, QVector<Result>& results)
+{
+    m_cache.insert(result.path, result.model);
+    m_pending.remove(result.path);
+    results.append(result);
+}
@@ -0,0 +1,154 @@
+#include "OverlayRenderBin.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+const char* const OverlayRenderBin::BIN_NAME = "OverlayBin";
+
+namespace {
+
+QMutex s_stateMutex;
+std::atomic<bool> s_orderIndependent(false);
+osg::ref_ptr<osg::Depth> s_depth;
+bool s_registered = false;
+
+// Counting-sort scratch; bins are recreated every frame, so the scratch
+// lives per cull thread instead of per bin
+struct SortScratch {
+    std::vector<int> bucketStart;
+    std::vector<unsigned char> leafBucket;
+    osgUtil::RenderBin::RenderLeafList sorted;
+};
+
+thread_local SortScratch t_scratch;
+
+} // namespace
+
+OverlayRenderBin::OverlayRenderBin()
+    : osgUtil::RenderBin(SORT_BACK_TO_FRONT)
+{
+}
+
+OverlayRenderBin::OverlayRenderBin(const OverlayRenderBin& rhs, const osg::CopyOp& copyop)
+    : osgUtil::RenderBin(rhs, copyop)
+{
+}
+
+void OverlayRenderBin::sortImplementation()
+{
+    copyLeavesFromStateGraphListToRenderLeafList();
+
+    // The bin belongs to this frame's cull, so its state set can be
+    // swapped here; the BlendFuncs themselves are never modified
+    const bool orderIndependent = s_orderIndependent.load(std::memory_order_relaxed);
+    setStateSet(blendStateSet(orderIndependent));
+
+    // Additive blending is order independent - keep state-graph order
+    if (orderIndependent || _renderLeafList.size() < 2) {
+        return;
+    }
+
+    // Depth range of this frame's overlays
+    float nearest = _renderLeafList.front()->_depth;
+    float farthest = nearest;
+    for (RenderLeafList::const_iterator it = _renderLeafList.begin(); it != _renderLeafList.end(); ++it) {
+        nearest = std::min(nearest, (*it)->_depth);
+        farthest = std::max(farthest, (*it)->_depth);
+    }
+    if (farthest <= nearest) {
+        return;
+    }
+
+    // Stable counting sort into depth slices, farthest slice first
+    SortScratch& scratch = t_scratch;
+    const size_t count = _renderLeafList.size();
+    const float scale = NUM_BUCKETS / (farthest - nearest);
+
+    scratch.bucketStart.assign(NUM_BUCKETS + 1, 0);
+    scratch.leafBucket.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        int slice = static_cast<int>((farthest - _renderLeafList[i]->_depth) * scale);
+        int bucket = std::min(slice, NUM_BUCKETS - 1);
+        scratch.leafBucket[i] = static_cast<unsigned char>(bucket);
+        ++scratch.bucketStart[bucket + 1];
+    }
+    for (int b = 0; b < NUM_BUCKETS; ++b) {
+        scratch.bucketStart[b + 1] += scratch.bucketStart[b];
+    }
+
+    scratch.sorted.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        scratch.sorted[scratch.bucketStart[scratch.leafBucket[i]]++] = _renderLeafList[i];
+    }
+    _renderLeafList.swap(scratch.sorted);
+}
+
+void OverlayRenderBin::setOrderIndependent(bool enabled)
+{
+    // Picked up by every overlay bin in sortImplementation()
+    s_orderIndependent.store(enabled, std::memory_order_relaxed);
+}
+
+bool OverlayRenderBin::isOrderIndependent()
+{
+    return s_orderIndependent.load(std::memory_order_relaxed);
+}
+
+osg::StateSet* OverlayRenderBin::sensorStateSet()
+{
+    // Function-local static: initialised once, thread-safe in C++11
+    static osg::ref_ptr<osg::StateSet> stateSet = []() {
+        osg::ref_ptr<osg::StateSet> ss = new osg::StateSet();
+        applyOverlayState(ss.get());
+        return ss;
+    }();
+    return stateSet.get();
+}
+
+void OverlayRenderBin::applyOverlayState(osg::StateSet* stateSet)
+{
+    ensureRegistered();
+
+    stateSet->setMode(GL_BLEND, osg::StateAttribute::ON);
+    stateSet->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
+    stateSet->setAttributeAndModes(sharedDepth(), osg::StateAttribute::ON);
+    stateSet->setRenderBinDetails(BIN_NUMBER, BIN_NAME);
+}
+
+void OverlayRenderBin::ensureRegistered()
+{
+    QMutexLocker lock(&s_stateMutex);
+    if (!s_registered) {
+        osgUtil::RenderBin::addRenderBinPrototype(BIN_NAME, new OverlayRenderBin());
+        s_registered = true;
+    }
+}
+
+osg::StateSet* OverlayRenderBin::blendStateSet(bool orderIndependent)
+{
+    // Function-local statics: initialised once, thread-safe in C++11
+    static osg::ref_ptr<osg::StateSet> over = []() {
+        osg::ref_ptr<osg::StateSet> ss = new osg::StateSet();
+        ss->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+        return ss;
+    }();
+    static osg::ref_ptr<osg::StateSet> additive = []() {
+        osg::ref_ptr<osg::StateSet> ss = new osg::StateSet();
+        ss->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE), osg::StateAttribute::ON);
+        return ss;
+    }();
+    return orderIndependent ? additive.get() : over.get();
+}
+
+osg::Depth* OverlayRenderBin::sharedDepth()
+{
+    QMutexLocker lock(&s_stateMutex);
+    if (!s_depth.valid()) {
+        // Test against opaque geometry but never write, overlays see each other
+        s_depth = new osg::Depth();
+        s_depth->setWriteMask(false);
+    }
+    return s_depth.get();
+}
@@ -0,0 +1,179 @@
+#include "PerfInstrumentation.h"
+#include <cstring>
+
+namespace PerfInstrumentation {
+
+namespace {
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "ingest",
+    "lodClassify",
+    "matrixRebuild",
+    "childLod",
+    "sceneCommit",
+    "sensorCoverage"
+};
+
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+    "matricesRebuilt",
+    "geometriesRebuilt",
+    "entitiesCulled"
+};
+
+// Current window - histograms are owned by the EntityManager thread,
+// counters can be bumped from anywhere
+Histogram s_phases[PHASE_COUNT];
+std::atomic<uint64_t> s_counters[COUNTER_COUNT];
+
+int highestBit(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int bit = 0;
+    while (v >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+double nsToMs(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1.0e6;
+}
+
+} // namespace
+
+const char* phaseName(Phase phase)
+{
+    return (phase >= 0 && phase < PHASE_COUNT) ? PHASE_NAMES[phase] : "unknown";
+}
+
+const char* counterName(Counter counter)
+{
+    return (counter >= 0 && counter < COUNTER_COUNT) ? COUNTER_NAMES[counter] : "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------------------------------------------------------------------------
+
+int Histogram::bucketIndex(uint64_t ns)
+{
+    // Values below SUB_BUCKETS map 1:1, above that each power of two is
+    // split into SUB_BUCKETS linear steps
+    if (ns < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(ns);
+    }
+
+    int msb = highestBit(ns);
+    if (msb >= MAX_OCTAVE) {
+        return NUM_BUCKETS - 1;
+    }
+
+    int shift = msb - 3;
+    int sub = static_cast<int>((ns >> shift) & (SUB_BUCKETS - 1));
+    return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+
+    int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    int sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + sub) << shift;
+    return lower + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t ns)
+{
+    ++m_buckets[bucketIndex(ns)];
+    ++m_count;
+    m_total += ns;
+    if (ns > m_max) {
+        m_max = ns;
+    }
+}
+
+void Histogram::reset()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_total = 0;
+    m_max = 0;
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(m_count) + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > m_count) {
+        rank = m_count;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            // Never report more than the largest sample actually seen
+            uint64_t bound = bucketUpperBound(i);
+            return bound < m_max ? bound : m_max;
+        }
+    }
+    return m_max;
+}
+
+// ---------------------------------------------------------------------------
+// Recording
+// ---------------------------------------------------------------------------
+
+void setEnabled(bool enabled)
+{
+    enabledFlag().store(enabled, std::memory_order_relaxed);
+}
+
+void recordPhase(Phase phase, uint64_t ns)
+{
+    s_phases[phase].record(ns);
+}
+
+void addCount(Counter counter, uint64_t n)
+{
+    s_counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+WindowReport takeWindow(double seconds)
+{
+    WindowReport report;
+    report.seconds = seconds;
+
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        Histogram& h = s_phases[i];
+        PhaseSummary& s = report.phases[i];
+        s.samples = h.count();
+        s.totalMs = nsToMs(h.total());
+        s.p50Ms = nsToMs(h.percentile(50.0));
+        s.p95Ms = nsToMs(h.percentile(95.0));
+        s.p99Ms = nsToMs(h.percentile(99.0));
+        s.maxMs = nsToMs(h.max());
+        h.reset();
+    }
+
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        report.counters[i] = s_counters[i].exchange(0, std::memory_order_relaxed);
+    }
+
+    return report;
+}
+
+} // namespace PerfInstrumentation
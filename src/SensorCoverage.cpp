@@ -0,0 +1,276 @@
+#include "SensorCoverage.h"
+#include "ShipModel.h"
+#include "sensorvolume.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Sector of one sensor in its body frame, in loop-ready form
+ */
+struct SectorParams {
+    double radius2;
+    double sinEleStart;
+    double sinEleEnd;
+    double sinAziStart, cosAziStart;
+    double sinAziEnd, cosAziEnd;
+    bool fullCircle;        // Azimuth span >= 360
+    bool wide;              // Azimuth span > 180: union instead of intersection
+};
+
+SectorParams sectorParams(const SensorVolume& sensor)
+{
+    SectorParams p;
+    double span = sensor.getAzimuthEnd() - sensor.getAzimuthStart();
+    double aziStart = osg::DegreesToRadians(sensor.getAzimuthStart());
+    double aziEnd = osg::DegreesToRadians(sensor.getAzimuthEnd());
+
+    p.radius2 = sensor.getRadius() * sensor.getRadius();
+    // sin() is only monotonic on [-90, 90]; anything beyond is the pole anyway
+    double eleStart = std::max(-90.0, std::min(90.0, sensor.getElevationStart()));
+    double eleEnd = std::max(-90.0, std::min(90.0, sensor.getElevationEnd()));
+    p.sinEleStart = std::sin(osg::DegreesToRadians(eleStart));
+    p.sinEleEnd = std::sin(osg::DegreesToRadians(eleEnd));
+    p.sinAziStart = std::sin(aziStart);
+    p.cosAziStart = std::cos(aziStart);
+    p.sinAziEnd = std::sin(aziEnd);
+    p.cosAziEnd = std::cos(aziEnd);
+    p.fullCircle = span >= 360.0;
+    p.wide = span > 180.0;
+    return p;
+}
+
+/**
+ * @brief Sector test over offset columns
+ * Azimuth is clockwise from body +y (north at zero heading) towards +x, the
+ * convention SensorVolume builds its mesh with.
+ * @param axes Rows: body x/y/z axes in ECEF divided by the model scale^2,
+ *        so a dot product yields body coordinates in sensor units
+ * @param inside Output flag per offset
+ */
+void testSector(const SectorParams& p, const double axes[3][3], int count,
+                const double* dx, const double* dy, const double* dz, unsigned char* inside)
+{
+    const double a00 = axes[0][0], a01 = axes[0][1], a02 = axes[0][2];
+    const double a10 = axes[1][0], a11 = axes[1][1], a12 = axes[1][2];
+    const double a20 = axes[2][0], a21 = axes[2][1], a22 = axes[2][2];
+    const unsigned char full = p.fullCircle ? 1 : 0;
+    const unsigned char wide = p.wide ? 1 : 0;
+
+    for (int i = 0; i < count; ++i) {
+        const double bx = a00 * dx[i] + a01 * dy[i] + a02 * dz[i];
+        const double by = a10 * dx[i] + a11 * dy[i] + a12 * dz[i];
+        const double bz = a20 * dx[i] + a21 * dy[i] + a22 * dz[i];
+
+        const double r2 = bx * bx + by * by + bz * bz;
+        const double r = std::sqrt(r2);
+        const unsigned char inRange = r2 <= p.radius2;
+        const unsigned char inElevation = (bz >= r * p.sinEleStart) & (bz <= r * p.sinEleEnd);
+
+        // Clockwise of the start bearing / counter-clockwise of the end bearing
+        const unsigned char afterStart = p.cosAziStart * bx - p.sinAziStart * by >= 0.0;
+        const unsigned char beforeEnd = p.sinAziEnd * by - p.cosAziEnd * bx >= 0.0;
+        const unsigned char inAzimuth = full | (wide ? (afterStart | beforeEnd)
+                                                     : (afterStart & beforeEnd));
+
+        inside[i] = inRange & inElevation & inAzimuth;
+    }
+}
+
+} // namespace
+
+SensorCoverage::SensorCoverage()
+    : m_detectionCount(0)
+{
+}
+
+void SensorCoverage::addShip(int entityId, ShipModel* ship)
+{
+    if (!ship || m_siteIndex.contains(entityId)) {
+        return;
+    }
+
+    Site site;
+    site.entityId = entityId;
+    site.ship = ship;
+    m_siteIndex.insert(entityId, m_sites.size());
+    m_sites.append(site);
+}
+
+void SensorCoverage::removeShip(int entityId)
+{
+    auto it = m_siteIndex.find(entityId);
+    if (it == m_siteIndex.end()) {
+        return;
+    }
+
+    int index = it.value();
+    m_siteIndex.erase(it);
+
+    const Site& site = m_sites[index];
+    for (int i = 0; i < site.sensors.size(); ++i) {
+        appendExits(site.entityId, i, site.sensors[i].detected);
+    }
+
+    // Swap-remove, then point the moved ship at its new index
+    int last = m_sites.size() - 1;
+    if (index != last) {
+        m_sites[index] = m_sites[last];
+        m_siteIndex[m_sites[index].entityId] = index;
+    }
+    m_sites.resize(last);
+}
+
+void SensorCoverage::clear()
+{
+    m_sites.clear();
+    m_siteIndex.clear();
+    m_events.resize(0);
+    m_detectionCount = 0;
+}
+
+void SensorCoverage::update(const EntityStore& store)
+{
+    m_detectionCount = 0;
+
+    for (Site& site : m_sites) {
+        syncSensors(site);
+        if (site.sensors.isEmpty()) {
+            continue;
+        }
+
+        // Body frame of the sensors: rows of (scale * rotation) * ENU
+        osg::Matrixd frame = site.ship->getLocalMatrix() * site.ship->getLocalToWorld();
+        double scale2 = frame(0, 0) * frame(0, 0) + frame(0, 1) * frame(0, 1) + frame(0, 2) * frame(0, 2);
+        if (scale2 <= 0.0) {
+            continue;
+        }
+
+        double axes[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                axes[r][c] = frame(r, c) / scale2;
+            }
+        }
+
+        const osg::Vec3d& origin = site.ship->getWorldPosition();
+        double scale = std::sqrt(scale2);
+        for (int i = 0; i < site.sensors.size(); ++i) {
+            updateSensor(store, site, i, site.sensors[i], origin, axes, scale);
+        }
+    }
+}
+
+bool SensorCoverage::getDetections(int shipId, int sensorIndex, QVector<int>& targetIds) const
+{
+    targetIds.resize(0);
+
+    auto it = m_siteIndex.constFind(shipId);
+    if (it == m_siteIndex.constEnd()) {
+        return false;
+    }
+
+    const Site& site = m_sites[it.value()];
+    if (sensorIndex < 0 || sensorIndex >= site.sensors.size()) {
+        return false;
+    }
+
+    targetIds = site.sensors[sensorIndex].detected;
+    return true;
+}
+
+void SensorCoverage::syncSensors(Site& site)
+{
+    const QVector<osg::ref_ptr<SensorVolume>>& volumes = site.ship->getSensorVolumes();
+
+    // Shrink first so removed sensors report their exits
+    for (int i = volumes.size(); i < site.sensors.size(); ++i) {
+        appendExits(site.entityId, i, site.sensors[i].detected);
+    }
+    if (site.sensors.size() > volumes.size()) {
+        site.sensors.resize(volumes.size());
+    }
+
+    for (int i = 0; i < volumes.size(); ++i) {
+        if (i == site.sensors.size()) {
+            SensorState state;
+            state.volume = volumes[i].get();
+            site.sensors.append(state);
+        }
+        else if (site.sensors[i].volume != volumes[i].get()) {
+            // Replaced at this index - it starts with an empty set
+            appendExits(site.entityId, i, site.sensors[i].detected);
+            site.sensors[i].volume = volumes[i].get();
+            site.sensors[i].detected.resize(0);
+        }
+    }
+}
+
+void SensorCoverage::updateSensor(const EntityStore& store, const Site& site, int sensorIndex,
+                                  SensorState& state, const osg::Vec3d& origin, const double axes[3][3],
+                                  double scale)
+{
+    const SensorVolume& sensor = *state.volume;
+    const SectorParams params = sectorParams(sensor);
+
+    // Grid query in world units - the volume is drawn under the model scale
+    const int count = store.queryRadius(origin, sensor.getRadius() * scale, m_candidates);
+
+    // Gather offsets into columns for the vectorized test
+    m_dx.resize(count);
+    m_dy.resize(count);
+    m_dz.resize(count);
+    m_inside.resize(count);
+    double* dx = m_dx.data();
+    double* dy = m_dy.data();
+    double* dz = m_dz.data();
+    for (int i = 0; i < count; ++i) {
+        osg::Vec3d d = store.worldPosition(m_candidates[i]) - origin;
+        dx[i] = d.x();
+        dy[i] = d.y();
+        dz[i] = d.z();
+    }
+
+    testSector(params, axes, count, dx, dy, dz, m_inside.data());
+
+    m_current.resize(0);
+    const unsigned char* inside = m_inside.constData();
+    for (int i = 0; i < count; ++i) {
+        int targetId = store.entityId(m_candidates[i]);
+        if (inside[i] && targetId != site.entityId) {
+            m_current.append(targetId);
+        }
+    }
+    std::sort(m_current.begin(), m_current.end());
+
+    // Merge the sorted sets: only in the new one = entered, only in the old one = left
+    const QVector<int>& previous = state.detected;
+    int a = 0, b = 0;
+    while (a < previous.size() || b < m_current.size()) {
+        if (b == m_current.size() || (a < previous.size() && previous[a] < m_current[b])) {
+            Event event = { site.entityId, sensorIndex, previous[a++], false };
+            m_events.append(event);
+        }
+        else if (a == previous.size() || m_current[b] < previous[a]) {
+            Event event = { site.entityId, sensorIndex, m_current[b++], true };
+            m_events.append(event);
+        }
+        else {
+            ++a;
+            ++b;
+        }
+    }
+
+    // Swap buffers so both keep their capacity
+    state.detected.swap(m_current);
+    m_detectionCount += state.detected.size();
+}
+
+void SensorCoverage::appendExits(int shipId, int sensorIndex, const QVector<int>& targetIds)
+{
+    for (int targetId : targetIds) {
+        Event event = { shipId, sensorIndex, targetId, false };
+        m_events.append(event);
+    }
+}
@@ -1,6 +1,28 @@
 #include "ShipModel.h"
+#include "TraceRecorder.h"
 #include <osg/MatrixTransform>
 
+namespace {
+
+/**
+ * @brief Grey box shown while the model is missing or still loading, shared by all ships
+ */
+osg::Node* placeholderModel()
+{
+    static osg::ref_ptr<osg::Geode> placeholder = [] {
+        osg::ref_ptr<osg::Box> box = new osg::Box(osg::Vec3(0, 0, 0), 1000.0);
+        osg::ref_ptr<osg::ShapeDrawable> drawable = new osg::ShapeDrawable(box.get());
+        drawable->setColor(osg::Vec4(0.5, 0.5, 0.5, 1.0));
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode();
+        geode->addDrawable(drawable.get());
+        return geode;
+    }();
+    return placeholder.get();
+}
+
+} // namespace
+
 ShipModel::ShipModel(
     double lon,
     double lat,
@@ -27,36 +49,45 @@ ShipModel::~ShipModel()
 
 bool ShipModel::loadModel(const QString& modelPath)
 {
+    ENTITY_TRACE_SCOPE("io", "ShipModel::loadModel");
+
     // Load 3D model from file
-    m_modelNode = osgDB::readNodeFile(modelPath.toStdString());
-    
-    if (!m_modelNode.valid()) {
-        // If model failed to load, create a simple placeholder (box)
-        osg::ref_ptr<osg::Box> box = new osg::Box(osg::Vec3(0, 0, 0), 1000.0);
-        osg::ref_ptr<osg::ShapeDrawable> drawable = new osg::ShapeDrawable(box.get());
-        drawable->setColor(osg::Vec4(0.5, 0.5, 0.5, 1.0));
-        
-        osg::ref_ptr<osg::Geode> geode = new osg::Geode();
-        geode->addDrawable(drawable.get());
-        m_modelNode = geode;
+    osg::ref_ptr<osg::Node> model = osgDB::readNodeFile(modelPath.toStdString());
+    setModelNode(model.get());
+    return model.valid();
+}
+
+void ShipModel::setModelNode(osg::Node* model)
+{
+    osg::Node* node = model ? model : placeholderModel();
+    if (!m_modelGroup.valid() || node == m_modelNode.get()) {
+        return;
     }
-    
-    // Add model to the model group
-    if (m_modelGroup.valid() && m_modelNode.valid()) {
-        // Clear existing children
-        m_modelGroup->removeChildren(0, m_modelGroup->getNumChildren());
-        m_modelGroup->addChild(m_modelNode.get());
-        return true;
+
+    // Swap the model child in place - the sensor volumes next to it stay
+    if (!m_modelNode.valid() || !m_modelGroup->replaceChild(m_modelNode.get(), node)) {
+        m_modelGroup->insertChild(0, node);
+    }
+    m_modelNode = node;
+}
+
+void ShipModel::reset()
+{
+    Object3D::reset();
+    clearSensorVolumes();
+
+    // No model, as constructed without a path
+    if (m_modelNode.valid()) {
+        m_modelGroup->removeChild(m_modelNode.get());
+        m_modelNode = nullptr;
     }
-    
-    return false;
 }
 
 void ShipModel::addFixedWave(SensorVolume* sensor)
 {
     if (sensor && m_modelGroup.valid()) {
         m_sensorVolumes.push_back(sensor);
-        m_modelGroup->addChild(sensor->getGeode());
+        m_modelGroup->addChild(sensor->getNode());
     }
 }
 
@@ -65,7 +96,7 @@ void ShipModel::clearSensorVolumes()
     // Remove all sensor volumes from scene graph
     for (auto& sensor : m_sensorVolumes) {
         if (sensor.valid() && m_modelGroup.valid()) {
-            m_modelGroup->removeChild(sensor->getGeode());
+            m_modelGroup->removeChild(sensor->getNode());
         }
     }
     m_sensorVolumes.clear();
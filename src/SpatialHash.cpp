@@ -0,0 +1,118 @@
+#include "SpatialHash.h"
+#include <cmath>
+
+namespace {
+
+// 21 bits per axis, biased so negative ECEF coordinates pack as unsigned
+const int KEY_BITS = 21;
+const int KEY_BIAS = 1 << (KEY_BITS - 1);
+const quint64 KEY_MASK = (static_cast<quint64>(1) << KEY_BITS) - 1;
+
+} // namespace
+
+SpatialHash::SpatialHash(double cellSize)
+    : m_cellSize(cellSize > 1.0 ? cellSize : 1.0)
+    , m_inverseCellSize(1.0 / m_cellSize)
+    , m_occupiedCells(0)
+{
+}
+
+int SpatialHash::cellCoord(double v) const
+{
+    return static_cast<int>(std::floor(v * m_inverseCellSize));
+}
+
+quint64 SpatialHash::packKey(int ix, int iy, int iz)
+{
+    return (static_cast<quint64>(ix + KEY_BIAS) & KEY_MASK)
+         | ((static_cast<quint64>(iy + KEY_BIAS) & KEY_MASK) << KEY_BITS)
+         | ((static_cast<quint64>(iz + KEY_BIAS) & KEY_MASK) << (2 * KEY_BITS));
+}
+
+void SpatialHash::unpackKey(quint64 key, int& ix, int& iy, int& iz)
+{
+    ix = static_cast<int>(key & KEY_MASK) - KEY_BIAS;
+    iy = static_cast<int>((key >> KEY_BITS) & KEY_MASK) - KEY_BIAS;
+    iz = static_cast<int>((key >> (2 * KEY_BITS)) & KEY_MASK) - KEY_BIAS;
+}
+
+quint64 SpatialHash::keyOf(const osg::Vec3d& position) const
+{
+    return packKey(cellCoord(position.x()), cellCoord(position.y()), cellCoord(position.z()));
+}
+
+void SpatialHash::insert(int slot, const osg::Vec3d& position)
+{
+    m_slotKey.append(0);
+    m_slotOffset.append(-1);
+    addToCell(slot, keyOf(position));
+}
+
+void SpatialHash::update(int slot, const osg::Vec3d& position)
+{
+    quint64 key = keyOf(position);
+    if (key == m_slotKey[slot]) {
+        return;
+    }
+
+    removeFromCell(slot);
+    addToCell(slot, key);
+}
+
+void SpatialHash::remove(int slot)
+{
+    removeFromCell(slot);
+
+    // Relabel the last slot, mirroring EntityStore's swap-remove
+    int last = m_slotKey.size() - 1;
+    if (slot != last) {
+        m_slotKey[slot] = m_slotKey[last];
+        m_slotOffset[slot] = m_slotOffset[last];
+        m_cells[m_slotKey[slot]][m_slotOffset[slot]] = slot;
+    }
+    m_slotKey.resize(last);
+    m_slotOffset.resize(last);
+}
+
+void SpatialHash::clear()
+{
+    m_cells.clear();
+    m_slotKey.resize(0);
+    m_slotOffset.resize(0);
+    m_occupiedCells = 0;
+}
+
+const SpatialHash::Cell* SpatialHash::cell(int ix, int iy, int iz) const
+{
+    QHash<quint64, Cell>::const_iterator it = m_cells.constFind(packKey(ix, iy, iz));
+    return it == m_cells.constEnd() ? nullptr : &it.value();
+}
+
+void SpatialHash::addToCell(int slot, quint64 key)
+{
+    Cell& cell = m_cells[key];
+    if (cell.isEmpty()) {
+        ++m_occupiedCells;
+    }
+    m_slotKey[slot] = key;
+    m_slotOffset[slot] = cell.size();
+    cell.append(slot);
+}
+
+void SpatialHash::removeFromCell(int slot)
+{
+    Cell& cell = m_cells[m_slotKey[slot]];
+    int offset = m_slotOffset[slot];
+    int last = cell.size() - 1;
+    if (offset != last) {
+        int movedSlot = cell[last];
+        cell[offset] = movedSlot;
+        m_slotOffset[movedSlot] = offset;
+    }
+    // resize() keeps the capacity - crossing back does not allocate
+    cell.resize(last);
+    if (cell.isEmpty()) {
+        --m_occupiedCells;
+    }
+    m_slotOffset[slot] = -1;
+}
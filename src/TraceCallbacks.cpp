@@ -0,0 +1,55 @@
+#include "TraceCallbacks.h"
+
+TraceDrawCallback::TraceDrawCallback(Mode mode, TraceDrawCallback* begin)
+    : m_mode(mode)
+    , m_begin(begin)
+    , m_beginNs(0)
+{
+}
+
+void TraceDrawCallback::operator()(osg::RenderInfo& renderInfo) const
+{
+    uint64_t now = TraceRecorder::nowNs();
+
+    if (m_mode == DRAW_BEGIN) {
+        m_beginNs.store(now, std::memory_order_relaxed);
+        return;
+    }
+
+    if (m_begin.valid() && TraceRecorder::isEnabled()) {
+        uint64_t begin = m_begin->m_beginNs.load(std::memory_order_relaxed);
+        if (begin != 0) {
+            TraceRecorder::record("osg.draw", "osg", begin, now);
+        }
+    }
+
+    const osg::FrameStamp* frameStamp = renderInfo.getState() ? renderInfo.getState()->getFrameStamp() : nullptr;
+    if (frameStamp) {
+        TraceRecorder::frameFinished(frameStamp->getFrameNumber(), now);
+    }
+}
+
+namespace TraceCallbacks {
+
+void attach(osg::Node* sceneData, osg::Camera* camera)
+{
+    if (sceneData) {
+        // Trace callbacks go outermost so they time everything below,
+        // including callbacks that were already installed
+        osg::ref_ptr<TraceTraversalCallback> update = new TraceTraversalCallback("osg.update", true);
+        update->setNestedCallback(sceneData->getUpdateCallback());
+        sceneData->setUpdateCallback(update.get());
+
+        osg::ref_ptr<TraceTraversalCallback> cull = new TraceTraversalCallback("osg.cull");
+        cull->setNestedCallback(sceneData->getCullCallback());
+        sceneData->setCullCallback(cull.get());
+    }
+
+    if (camera) {
+        osg::ref_ptr<TraceDrawCallback> begin = new TraceDrawCallback(TraceDrawCallback::DRAW_BEGIN);
+        camera->setInitialDrawCallback(begin.get());
+        camera->setFinalDrawCallback(new TraceDrawCallback(TraceDrawCallback::DRAW_END, begin.get()));
+    }
+}
+
+} // namespace TraceCallbacks
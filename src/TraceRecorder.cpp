@@ -0,0 +1,289 @@
+#include "TraceRecorder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::s_enabled(false);
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    uint64_t beginNs;
+    uint64_t durationNs;
+};
+
+/**
+ * Single-writer ring: only the owning thread writes events. Before it
+ * touches a slot it raises claimIndex, and once the event is complete it
+ * publishes it through writeIndex. Dumps read concurrently, copy up to
+ * writeIndex and then discard every slot the writer claimed meanwhile, so
+ * a half-written event is never exported.
+ */
+struct ThreadBuffer {
+    std::atomic<int> tid;
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> writeIndex;   // Events fully written
+    std::atomic<uint64_t> claimIndex;   // Events written or being written
+    std::atomic<uint64_t> firstIndex;   // First event of the current owner
+    TraceEvent events[TraceRecorder::BUFFER_CAPACITY];
+
+    explicit ThreadBuffer(int id)
+        : tid(id)
+        , name(nullptr)
+        , writeIndex(0)
+        , claimIndex(0)
+        , firstIndex(0)
+    {}
+};
+
+// Buffers stay registered when their thread ends, so events of finished
+// threads still show up in later dumps, and go to the free list for the
+// next new thread. Pool threads come and go; reusing their buffers keeps
+// the memory bounded by the number of threads alive at once.
+std::mutex s_registryMutex;
+std::vector<ThreadBuffer*> s_buffers;
+std::vector<ThreadBuffer*> s_freeBuffers;
+int s_nextTid = 1;                              // Guarded by s_registryMutex
+
+/**
+ * Owns the calling thread's buffer and hands it back on thread exit
+ */
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferHolder()
+    {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            s_freeBuffers.push_back(buffer);
+            buffer = nullptr;
+        }
+    }
+};
+
+thread_local ThreadBufferHolder t_holder;
+
+// Hitch detection. Start times of recent frames by frame number: with
+// DrawThreadPerContext the draw of a frame overlaps the next frame's update.
+const unsigned int FRAME_SLOTS = 4;
+std::atomic<unsigned int> s_frameNumber[FRAME_SLOTS];
+std::atomic<uint64_t> s_frameStartNs[FRAME_SLOTS];
+std::atomic<uint64_t> s_hitchThresholdNs(0);
+std::atomic<uint64_t> s_lastAutoDumpNs(0);
+std::atomic<bool> s_dumpRequested(false);
+QString s_autoDumpDir;                          // Guarded by s_registryMutex
+
+const uint64_t AUTO_DUMP_COOLDOWN_NS = 5000000000ull;   // At most one dump per 5s
+
+ThreadBuffer* threadBuffer()
+{
+    if (!t_holder.buffer) {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        if (!s_freeBuffers.empty()) {
+            // The previous owner's events are dropped from dumps from here
+            // on, and the new owner shows up as a thread of its own
+            ThreadBuffer* buffer = s_freeBuffers.back();
+            s_freeBuffers.pop_back();
+            buffer->tid.store(s_nextTid++, std::memory_order_relaxed);
+            buffer->name.store(nullptr, std::memory_order_relaxed);
+            buffer->firstIndex.store(buffer->writeIndex.load(std::memory_order_relaxed),
+                                     std::memory_order_release);
+            t_holder.buffer = buffer;
+        } else {
+            t_holder.buffer = new ThreadBuffer(s_nextTid++);
+            s_buffers.push_back(t_holder.buffer);
+        }
+    }
+    return t_holder.buffer;
+}
+
+void writeJsonString(QTextStream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t TraceRecorder::nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void TraceRecorder::record(const char* name, const char* category, uint64_t beginNs, uint64_t endNs)
+{
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+
+    // Claim the slot before overwriting it; the fence keeps the event
+    // stores from becoming visible ahead of the claim
+    buffer->claimIndex.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceEvent& event = buffer->events[index & (BUFFER_CAPACITY - 1)];
+    event.name = name;
+    event.category = category;
+    event.beginNs = beginNs;
+    event.durationNs = endNs > beginNs ? endNs - beginNs : 0;
+
+    // Publish only the complete event
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+    threadBuffer()->name.store(name, std::memory_order_relaxed);
+}
+
+bool TraceRecorder::dumpToFile(const QString& path)
+{
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        buffers = s_buffers;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "[TraceRecorder] Cannot write" << path;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    int eventCount = 0;
+    std::vector<TraceEvent> events;
+    events.reserve(BUFFER_CAPACITY);
+
+    for (ThreadBuffer* buffer : buffers) {
+        const int tid = buffer->tid.load(std::memory_order_relaxed);
+        const char* threadName = buffer->name.load(std::memory_order_relaxed);
+        if (threadName) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, threadName);
+            out << "}}";
+            first = false;
+        }
+
+        // Copy the published window, then drop every slot the writer has
+        // claimed for a newer event meanwhile
+        uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = end > static_cast<uint64_t>(BUFFER_CAPACITY) ? end - BUFFER_CAPACITY : 0;
+        begin = std::max(begin, buffer->firstIndex.load(std::memory_order_acquire));
+
+        events.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            events.push_back(buffer->events[i & (BUFFER_CAPACITY - 1)]);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = buffer->claimIndex.load(std::memory_order_relaxed);
+        uint64_t firstValid = claimed > static_cast<uint64_t>(BUFFER_CAPACITY) ? claimed - BUFFER_CAPACITY : 0;
+        size_t skip = firstValid > begin ? static_cast<size_t>(firstValid - begin) : 0;
+
+        for (size_t i = skip; i < events.size(); ++i) {
+            const TraceEvent& e = events[i];
+            out << (first ? "" : ",\n") << "{\"name\":";
+            writeJsonString(out, e.name);
+            out << ",\"cat\":";
+            writeJsonString(out, e.category);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << QString::number(e.beginNs / 1000.0, 'f', 3)
+                << ",\"dur\":" << QString::number(e.durationNs / 1000.0, 'f', 3) << "}";
+            first = false;
+            ++eventCount;
+        }
+    }
+
+    out << "\n]}\n";
+    out.flush();
+
+    qDebug() << "[TraceRecorder] Wrote" << eventCount << "events to" << path;
+    return file.error() == QFile::NoError;
+}
+
+void TraceRecorder::setHitchThreshold(double frameMs, const QString& outputDir)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        s_autoDumpDir = outputDir;
+    }
+    s_hitchThresholdNs.store(frameMs > 0.0 ? static_cast<uint64_t>(frameMs * 1.0e6) : 0,
+                             std::memory_order_relaxed);
+}
+
+void TraceRecorder::frameStarted(unsigned int frameNumber, uint64_t frameStartNs)
+{
+    const unsigned int slot = frameNumber % FRAME_SLOTS;
+    s_frameStartNs[slot].store(frameStartNs, std::memory_order_relaxed);
+    s_frameNumber[slot].store(frameNumber, std::memory_order_release);
+}
+
+void TraceRecorder::frameFinished(unsigned int frameNumber, uint64_t frameEndNs)
+{
+    uint64_t threshold = s_hitchThresholdNs.load(std::memory_order_relaxed);
+    if (!isEnabled() || threshold == 0) {
+        return;
+    }
+
+    // Frames whose start was not seen (or already recycled) are skipped
+    const unsigned int slot = frameNumber % FRAME_SLOTS;
+    if (s_frameNumber[slot].load(std::memory_order_acquire) != frameNumber) {
+        return;
+    }
+    uint64_t frameStartNs = s_frameStartNs[slot].load(std::memory_order_relaxed);
+    if (frameStartNs == 0 || frameEndNs <= frameStartNs) {
+        return;
+    }
+
+    if (frameEndNs - frameStartNs > threshold) {
+        uint64_t lastDump = s_lastAutoDumpNs.load(std::memory_order_relaxed);
+        if (lastDump == 0 || frameEndNs - lastDump > AUTO_DUMP_COOLDOWN_NS) {
+            s_lastAutoDumpNs.store(frameEndNs, std::memory_order_relaxed);
+            s_dumpRequested.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void TraceRecorder::pollAutoDump()
+{
+    if (!s_dumpRequested.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+
+    QString dir;
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        dir = s_autoDumpDir;
+    }
+
+    QDir().mkpath(dir);
+    QString path = QDir(dir).filePath(
+        QString("trace-%1.json").arg(QDateTime::currentMSecsSinceEpoch()));
+    qWarning() << "[TraceRecorder] Frame time over threshold, dumping trace";
+    dumpToFile(path);
+}
@@ -1,8 +1,11 @@
 #include "object3d.h"
 #include "AttitudeUtils.h"
+#include "Geodesy.h"
+#include "PerfInstrumentation.h"
 #include <osg/Matrix>
 #include <osg/Geometry>
 #include <osgDB/ReadFile>
+#include <algorithm>
 #include <cmath>
 #include <QDebug>
 
@@ -21,11 +24,15 @@ Object3D::Object3D()
     : m_longitude(0.0)
     , m_latitude(0.0)
     , m_altitude(0.0)
+    , m_worldPosition(0.0, 0.0, 0.0)
     , m_heading(0.0)
     , m_pitch(0.0)
     , m_roll(0.0)
+    , m_attitudeQuat(0.0, 0.0, 0.0, 1.0)
+    , m_quatAttitude(false)
     , m_scale(1.0)
     , m_visible(true)
+    , m_flattened(false)
     , m_positionDirty(true)
     , m_attitudeDirty(true)
     , m_scaleDirty(true)
@@ -70,7 +77,8 @@ void Object3D::setPosition(const osg::Vec3d& pos)
 void Object3D::setAttitude(double heading, double pitch, double roll)
 {
     // Skip if attitude hasn't changed significantly
-    if (std::abs(m_heading - heading) < LodConfig::ATTITUDE_EPSILON &&
+    if (!m_quatAttitude &&
+        std::abs(m_heading - heading) < LodConfig::ATTITUDE_EPSILON &&
         std::abs(m_pitch - pitch) < LodConfig::ATTITUDE_EPSILON &&
         std::abs(m_roll - roll) < LodConfig::ATTITUDE_EPSILON) {
         return;
@@ -79,9 +87,40 @@ void Object3D::setAttitude(double heading, double pitch, double roll)
     m_heading = heading;
     m_pitch = pitch;
     m_roll = roll;
+    m_quatAttitude = false;
     m_attitudeDirty = true;
 }
 
+void Object3D::setAttitude(const osg::Quat& attitude)
+{
+    if (m_quatAttitude &&
+        std::abs(m_attitudeQuat.x() - attitude.x()) < LodConfig::ATTITUDE_EPSILON &&
+        std::abs(m_attitudeQuat.y() - attitude.y()) < LodConfig::ATTITUDE_EPSILON &&
+        std::abs(m_attitudeQuat.z() - attitude.z()) < LodConfig::ATTITUDE_EPSILON &&
+        std::abs(m_attitudeQuat.w() - attitude.w()) < LodConfig::ATTITUDE_EPSILON) {
+        return;
+    }
+
+    m_attitudeQuat = attitude;
+    m_quatAttitude = true;
+    m_attitudeDirty = true;
+}
+
+osg::Vec3d Object3D::getAttitude() const
+{
+    if (m_quatAttitude) {
+        double heading, pitch, roll;
+        AttitudeUtils::quatToEuler(m_attitudeQuat, heading, pitch, roll);
+        return osg::Vec3d(heading, pitch, roll);
+    }
+    return osg::Vec3d(m_heading, m_pitch, m_roll);
+}
+
+osg::Quat Object3D::getAttitudeQuat() const
+{
+    return m_quatAttitude ? m_attitudeQuat : AttitudeUtils::eulerToQuat(m_heading, m_pitch, m_roll);
+}
+
 void Object3D::setScale(double scale)
 {
     if (std::abs(m_scale - scale) < 1e-6) {
@@ -104,66 +143,167 @@ void Object3D::setVisible(bool visible)
     }
 }
 
+void Object3D::reset()
+{
+    m_longitude = 0.0;
+    m_latitude = 0.0;
+    m_altitude = 0.0;
+    m_heading = 0.0;
+    m_pitch = 0.0;
+    m_roll = 0.0;
+    m_attitudeQuat.set(0.0, 0.0, 0.0, 1.0);
+    m_quatAttitude = false;
+    m_scale = 1.0;
+    m_positionDirty = true;
+    m_attitudeDirty = true;
+    m_scaleDirty = true;
+    setVisible(true);
+
+    // Back to the model branch only
+    if (m_billboardNode.valid()) {
+        m_lodSwitch->removeChildren(1, m_lodSwitch->getNumChildren() - 1);
+        m_billboardNode = nullptr;
+        m_billboardScale = nullptr;
+        m_billboardRadius = 0.0;
+    }
+    m_billboardImage.clear();
+    m_billboardWidth = 0.0;
+    m_billboardHeight = 0.0;
+    m_lodSwitch->setValue(0, true);
+    m_nearDistance = 500000.0;
+    m_farDistance = 2000000.0;
+}
+
+void Object3D::setFlattenedTransform(bool flattened)
+{
+    if (m_flattened == flattened) {
+        return;
+    }
+
+    m_flattened = flattened;
+    if (flattened) {
+        m_onceTransform->removeChild(m_modelGroup.get());
+    } else {
+        m_onceTransform->addChild(m_modelGroup.get());
+    }
+    attachLodChildren();
+
+    // Both matrices change meaning - rebuild them on the next update
+    m_positionDirty = true;
+    m_attitudeDirty = true;
+}
+
+void Object3D::attachLodChildren()
+{
+    // setChild keeps the switch values, so the current LOD choice survives
+    m_lodSwitch->setChild(0, modelObject());
+
+    if (!m_billboardNode.valid()) {
+        return;
+    }
+
+    osg::Node* billboardChild = m_billboardNode.get();
+    if (m_flattened) {
+        if (!m_billboardScale.valid()) {
+            m_billboardScale = new osg::MatrixTransform();
+        }
+        m_billboardScale->removeChildren(0, m_billboardScale->getNumChildren());
+        m_billboardScale->addChild(m_billboardNode.get());
+        billboardChild = m_billboardScale.get();
+    }
+
+    if (m_lodSwitch->getNumChildren() < 2)
+        m_lodSwitch->addChild(billboardChild, false);  // Index 1: image (default: hidden)
+    else
+        m_lodSwitch->setChild(1, billboardChild);
+}
+
 void Object3D::updateIfDirty()
 {
+    bool localDirty = m_attitudeDirty || m_scaleDirty;
+    if (!m_positionDirty && !localDirty) {
+        return;
+    }
+
     if (m_positionDirty) {
         updateEarthTransform();
         m_positionDirty = false;
     }
     
-    if (m_attitudeDirty || m_scaleDirty) {
+    if (localDirty) {
         updateOnceTransform();
         m_attitudeDirty = false;
         m_scaleDirty = false;
     }
+
+    if (m_flattened) {
+        updateFlattenedTransform();
+    }
 }
 
 void Object3D::updateEarthTransform()
 {
-    // Convert geodetic coordinates to ECEF (Earth-Centered, Earth-Fixed)
-    osg::Vec3d ecef;
-    getEllipsoid()->convertLatLongHeightToXYZ(
-        osg::DegreesToRadians(m_latitude),
-        osg::DegreesToRadians(m_longitude),
-        m_altitude,
-        ecef.x(), ecef.y(), ecef.z()
-    );
-    
-    // Create local-to-world matrix at this position
-    osg::Matrix localToWorld;
-    getEllipsoid()->computeLocalToWorldTransformFromXYZ(
-        ecef.x(), ecef.y(), ecef.z(), localToWorld
-    );
+    // ECEF position and local ENU frame in one pass - the ellipsoid model
+    // would convert the ECEF result back to lat/lon to build the frame
+    Geodesy::geodeticToEcefEnu(m_longitude, m_latitude, m_altitude, m_worldPosition, m_localToWorld);
     
-    m_earthTransform->setMatrix(localToWorld);
+    // Flattened mode composes it with the local matrix afterwards
+    if (!m_flattened) {
+        m_earthTransform->setMatrix(m_localToWorld);
+        PERF_COUNT(COUNTER_MATRICES_REBUILT, 1);
+    }
 }
 
 void Object3D::updateOnceTransform()
 {
-    // Create rotation matrix from attitude
-    osg::Matrix rotation = AttitudeUtils::createRotationMatrix(m_heading, m_pitch, m_roll);
-    
-    // Create scale matrix
-    osg::Matrix scale = osg::Matrix::scale(m_scale, m_scale, m_scale);
-    
-    // Combine: scale first, then rotate
-    osg::Matrix transform = scale * rotation;
+    // Scale first, then rotate - built in closed form, no quaternion
+    // round trip or 4x4 multiplies
+    if (m_quatAttitude) {
+        AttitudeUtils::quatToRotationScale(m_attitudeQuat, m_scale, m_localMatrix);
+    } else {
+        AttitudeUtils::eulerToRotationScale(m_heading, m_pitch, m_roll, m_scale, m_localMatrix);
+    }
     
-    m_onceTransform->setMatrix(transform);
+    if (!m_flattened) {
+        m_onceTransform->setMatrix(m_localMatrix);
+        PERF_COUNT(COUNTER_MATRICES_REBUILT, 1);
+    }
+}
+
+void Object3D::updateFlattenedTransform()
+{
+    // Row-vector convention: local (scale, rotation) first, then ENU to ECEF
+    m_earthTransform->setMatrix(m_localMatrix * m_localToWorld);
+    PERF_COUNT(COUNTER_MATRICES_REBUILT, 1);
+
+    // The billboard should keep its size in meters regardless of model scale
+    if (m_billboardScale.valid() && m_scale > 0.0) {
+        double inverse = 1.0 / m_scale;
+        m_billboardScale->setMatrix(osg::Matrix::scale(inverse, inverse, inverse));
+    }
 }
 
-void Object3D::createBillboard(const QString& imagePath, double width, double height)
+osg::ref_ptr<osg::Texture2D> Object3D::loadBillboardTexture(const QString& imagePath)
 {
     osg::ref_ptr<osg::Image> image = osgDB::readImageFile(imagePath.toStdString());
     if (!image.valid())
     {
         qWarning() << "[Object3D] Failed to load billboard image:" << imagePath;
-        return;
+        return nullptr;
     }
 
     osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image.get());
     texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
     texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+    return texture;
+}
+
+void Object3D::createBillboard(osg::Texture2D* texture, double width, double height)
+{
+    if (!texture)
+    {
+        return;
+    }
 
     osg::ref_ptr<osg::Geometry> quad = osg::createTexturedQuadGeometry(
         osg::Vec3(-width/2, 0, -height/2),
@@ -172,12 +312,14 @@ void Object3D::createBillboard(const QString& imagePath, double width, double he
     );
 
     osg::StateSet* ss = quad->getOrCreateStateSet();
-    ss->setTextureAttributeAndModes(0, texture.get(), osg::StateAttribute::ON);
+    ss->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
     ss->setMode(GL_BLEND, osg::StateAttribute::ON);
     ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
     ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
     ss->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
+    m_billboardRadius = 0.5 * std::sqrt(width * width + height * height);
+
     m_billboardNode = new osg::Billboard();
     m_billboardNode->setMode(osg::Billboard::POINT_ROT_EYE);
     m_billboardNode->addDrawable(quad.get(), osg::Vec3(0, 0, 0));
@@ -185,14 +327,22 @@ void Object3D::createBillboard(const QString& imagePath, double width, double he
 
 void Object3D::setBillboardImage(const QString& imagePath, double width, double height)
 {
-    createBillboard(imagePath, width, height);
+    setBillboardImage(imagePath, loadBillboardTexture(imagePath).get(), width, height);
+}
+
+void Object3D::setBillboardImage(const QString& imagePath, osg::Texture2D* texture, double width, double height)
+{
+    m_billboardImage = imagePath;
+    m_billboardWidth = width;
+    m_billboardHeight = height;
+    createBillboard(texture, width, height);
     
     if (m_billboardNode.valid() && m_lodSwitch.valid())
     {
-        if (m_lodSwitch->getNumChildren() < 2)
-            m_lodSwitch->addChild(m_billboardNode.get(), false);  // Index 1: image (default: hidden)
-        else
-            m_lodSwitch->setChild(1, m_billboardNode.get());
+        attachLodChildren();
+        if (m_flattened) {
+            m_scaleDirty = true;    // Sets the inverse scale on the next update
+        }
     }
 }
 
@@ -203,13 +353,41 @@ void Object3D::setLODDistances(double nearDist, double farDist)
     // Parameter retained for backward compatibility only
 }
 
+double Object3D::getBoundingRadius() const
+{
+    double radius = m_billboardNode.valid() ? m_billboardRadius : 0.0;
+    osg::Node* model = getModelNode();
+    if (model) {
+        const osg::BoundingSphere& bound = model->getBound();
+        if (bound.valid()) {
+            // Offset of the model centre from its origin counts as well
+            radius = std::max(radius, (bound.center().length() + bound.radius()) * m_scale);
+        }
+    }
+    return radius;
+}
+
+double Object3D::getExtentRadius() const
+{
+    // Children of the switch directly: its own bound skips the hidden branch
+    double radius = 0.0;
+    for (unsigned int i = 0; i < m_lodSwitch->getNumChildren(); ++i) {
+        const osg::BoundingSphere& bound = m_lodSwitch->getChild(i)->getBound();
+        if (bound.valid()) {
+            radius = std::max(radius, static_cast<double>(bound.center().length() + bound.radius()));
+        }
+    }
+
+    // Flattened, the root matrix scales everything below the switch
+    return m_flattened ? radius * m_scale : radius;
+}
+
 void Object3D::updateLOD(const osg::Vec3d& eyePosition)
 {
     if (!m_lodSwitch.valid() || !m_earthTransform.valid())
         return;
 
-    osg::Vec3d objectPos = m_earthTransform->getMatrix().getTrans();
-    double distance = (eyePosition - objectPos).length();
+    double distance = (eyePosition - m_worldPosition).length();
 
     if (distance < m_nearDistance)
     {
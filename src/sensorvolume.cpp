@@ -1,8 +1,162 @@
 #include "sensorvolume.h"
+#include "PerfInstrumentation.h"
+#include "OverlayRenderBin.h"
 #include <osg/PrimitiveSet>
 #include <osg/StateSet>
+#include <osg/Vec2d>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVarLengthArray>
 #include <cmath>
 
+namespace {
+
+// Number of samples from start to end (inclusive) at the given step - shared
+// by vertex generation and indexing so both always agree
+int stepCount(double start, double end, int step)
+{
+    if (step <= 0 || end < start) {
+        return 0;
+    }
+    return static_cast<int>((end - start) / step) + 1;
+}
+
+// Unit-radius sector meshes are shared by every volume with the same angles
+// and LOD steps; index buffers by every volume with the same grid size.
+// A mesh is dropped when the last volume using it changes its angles or LOD
+// or is destroyed, so scanning sectors do not pile up meshes; index buffers
+// depend only on the (small) grid sizes and are kept.
+struct SectorKey {
+    double azimuthStart;
+    double azimuthEnd;
+    double elevationStart;
+    double elevationEnd;
+    int azimuthStep;
+    int elevationStep;
+
+    bool operator<(const SectorKey& o) const {
+        if (azimuthStart != o.azimuthStart) return azimuthStart < o.azimuthStart;
+        if (azimuthEnd != o.azimuthEnd) return azimuthEnd < o.azimuthEnd;
+        if (elevationStart != o.elevationStart) return elevationStart < o.elevationStart;
+        if (elevationEnd != o.elevationEnd) return elevationEnd < o.elevationEnd;
+        if (azimuthStep != o.azimuthStep) return azimuthStep < o.azimuthStep;
+        return elevationStep < o.elevationStep;
+    }
+};
+
+QMutex s_meshMutex;
+QMap<SectorKey, osg::ref_ptr<osg::Vec3Array>> s_sectorVertices;
+QHash<const osg::Array*, SectorKey> s_sectorKeys;      // Reverse of s_sectorVertices
+QMap<quint64, osg::ref_ptr<osg::DrawElements>> s_sectorIndices;
+
+/**
+ * Drop a cached mesh that only the cache still references (s_meshMutex held)
+ */
+void releaseSectorVertices(const osg::Array* vertices)
+{
+    auto it = s_sectorKeys.find(vertices);
+    if (it == s_sectorKeys.end() || vertices->referenceCount() > 1) {
+        return;
+    }
+
+    const SectorKey key = it.value();
+    s_sectorKeys.erase(it);
+    s_sectorVertices.remove(key);
+}
+
+/**
+ * Triangle list for a numAzi x numEle grid (vertex i * numEle + j) plus the
+ * apex at index numAzi * numEle. The surface is emitted column by column,
+ * so each column reuses the previous one's numEle vertices from the
+ * post-transform cache; the side walls fan the grid border to the apex.
+ */
+template <class DrawElementsT>
+void emitSectorIndices(DrawElementsT* indices, int numAzi, int numEle,
+                       bool azimuthSides, bool topCap)
+{
+    const int apex = numAzi * numEle;
+
+    // Outer spherical surface
+    for (int i = 0; i < numAzi - 1; ++i) {
+        for (int j = 0; j < numEle - 1; ++j) {
+            int idx0 = i * numEle + j;
+            int idx1 = idx0 + 1;
+            int idx2 = (i + 1) * numEle + j;
+            int idx3 = idx2 + 1;
+
+            indices->push_back(idx0);
+            indices->push_back(idx1);
+            indices->push_back(idx2);
+
+            indices->push_back(idx1);
+            indices->push_back(idx3);
+            indices->push_back(idx2);
+        }
+    }
+
+    // Lower elevation cone
+    for (int i = 0; i < numAzi - 1; ++i) {
+        indices->push_back(apex);
+        indices->push_back((i + 1) * numEle);
+        indices->push_back(i * numEle);
+    }
+
+    // Upper elevation cone (collapses to a line at 90 degrees)
+    if (topCap) {
+        for (int i = 0; i < numAzi - 1; ++i) {
+            indices->push_back(apex);
+            indices->push_back(i * numEle + numEle - 1);
+            indices->push_back((i + 1) * numEle + numEle - 1);
+        }
+    }
+
+    // Azimuth start / end walls (absent for a full circle)
+    if (azimuthSides) {
+        const int last = (numAzi - 1) * numEle;
+        for (int j = 0; j < numEle - 1; ++j) {
+            indices->push_back(apex);
+            indices->push_back(j);
+            indices->push_back(j + 1);
+
+            indices->push_back(apex);
+            indices->push_back(last + j + 1);
+            indices->push_back(last + j);
+        }
+    }
+}
+
+/**
+ * Shared index buffer for a grid size; 16-bit unless the vertex count
+ * needs more
+ */
+osg::DrawElements* sectorIndices(int numAzi, int numEle, bool azimuthSides, bool topCap)
+{
+    quint64 key = static_cast<quint64>(numAzi)
+                | (static_cast<quint64>(numEle) << 24)
+                | (static_cast<quint64>(azimuthSides) << 48)
+                | (static_cast<quint64>(topCap) << 49);
+
+    osg::ref_ptr<osg::DrawElements>& indices = s_sectorIndices[key];
+    if (!indices.valid()) {
+        if (numAzi >= 2 && numEle >= 2 && numAzi * numEle + 1 <= 0xFFFF) {
+            osg::DrawElementsUShort* shortIndices = new osg::DrawElementsUShort(GL_TRIANGLES);
+            emitSectorIndices(shortIndices, numAzi, numEle, azimuthSides, topCap);
+            indices = shortIndices;
+        } else {
+            osg::DrawElementsUInt* intIndices = new osg::DrawElementsUInt(GL_TRIANGLES);
+            if (numAzi >= 2 && numEle >= 2) {
+                emitSectorIndices(intIndices, numAzi, numEle, azimuthSides, topCap);
+            }
+            indices = intIndices;
+        }
+    }
+    return indices.get();
+}
+
+} // namespace
+
 SensorVolume::SensorVolume(
     double radius,
     const osg::Vec4& color,
@@ -25,19 +179,22 @@ SensorVolume::SensorVolume(
     m_geometry = new osg::Geometry();
     m_geode->addDrawable(m_geometry.get());
 
-    // Setup rendering state for transparency
-    osg::StateSet* ss = m_geode->getOrCreateStateSet();
-    ss->setMode(GL_BLEND, osg::StateAttribute::ON);
-    ss->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
-    ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
-    
-    osg::BlendFunc* bf = new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    ss->setAttributeAndModes(bf, osg::StateAttribute::ON);
-    
-    // Disable depth write for proper transparency
-    osg::Depth* depth = new osg::Depth();
-    depth->setWriteMask(false);
-    ss->setAttributeAndModes(depth, osg::StateAttribute::ON);
+    m_scaleTransform = new osg::MatrixTransform();
+    m_scaleTransform->setMatrix(osg::Matrix::scale(radius, radius, radius));
+    m_scaleTransform->addChild(m_geode.get());
+
+    // VBOs so rebuilds upload with sub-data instead of recompiling a
+    // display list
+    m_geometry->setUseDisplayList(false);
+    m_geometry->setUseVertexBufferObjects(true);
+
+    m_colors = new osg::Vec4Array();
+    m_colors->push_back(m_color);
+    m_geometry->setColorArray(m_colors.get(), osg::Array::BIND_OVERALL);
+
+    // Overlay bin with state shared by every sensor volume - the color is
+    // per instance (BIND_OVERALL array), so no per-geode state is needed
+    m_geode->setStateSet(OverlayRenderBin::sensorStateSet());
 
     // Build initial geometry
     rebuildGeometry();
@@ -45,6 +202,16 @@ SensorVolume::SensorVolume(
 
 SensorVolume::~SensorVolume()
 {
+    // Let go of the mesh first so the cache can see whether it was the last
+    // user; if the scene graph still holds the node, the mesh stays cached
+    QMutexLocker lock(&s_meshMutex);
+    const osg::Array* vertices = m_geometry->getVertexArray();
+    m_scaleTransform = nullptr;
+    m_geode = nullptr;
+    m_geometry = nullptr;
+    if (vertices) {
+        releaseSectorVertices(vertices);
+    }
 }
 
 void SensorVolume::setLodLevel(int level)
@@ -68,16 +235,23 @@ void SensorVolume::setVisible(bool visible)
 
 void SensorVolume::setRadius(double radius)
 {
-    if (std::abs(m_radius - radius) > 1.0) {
+    if (m_radius != radius) {
+        // Unit mesh - only the scale changes
         m_radius = radius;
-        rebuildGeometry();
+        m_scaleTransform->setMatrix(osg::Matrix::scale(radius, radius, radius));
     }
 }
 
 void SensorVolume::setColor(const osg::Vec4& color)
 {
+    if (m_color == color) {
+        return;
+    }
+
+    // BIND_OVERALL - one element, no vertex regeneration
     m_color = color;
-    rebuildGeometry();
+    (*m_colors)[0] = color;
+    m_colors->dirty();
 }
 
 void SensorVolume::setAngles(double azimuthStart, double azimuthEnd,
@@ -92,6 +266,9 @@ void SensorVolume::setAngles(double azimuthStart, double azimuthEnd,
 
 void SensorVolume::rebuildGeometry()
 {
+    ENTITY_TRACE_SCOPE("geometry", "SensorVolume::rebuildGeometry");
+    PERF_COUNT(COUNTER_GEOMETRIES_REBUILT, 1);
+
     // Determine step sizes based on LOD level
     int azimuthStep, elevationStep;
     switch (m_currentLodLevel) {
@@ -110,69 +287,76 @@ void SensorVolume::rebuildGeometry()
             break;
     }
 
-    // Create vertices
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
-    createVertices(vertices.get(), azimuthStep, elevationStep);
+    int numAziSteps = stepCount(m_azimuthStart, m_azimuthEnd, azimuthStep);
+    int numEleSteps = stepCount(m_elevationStart, m_elevationEnd, elevationStep);
+    bool azimuthSides = (m_azimuthEnd - m_azimuthStart) < 360.0;
+    bool topCap = m_elevationEnd < 90.0;
 
-    m_geometry->setVertexArray(vertices.get());
-
-    // Create colors (all vertices same color)
-    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array();
-    colors->push_back(m_color);
-    m_geometry->setColorArray(colors.get());
-    m_geometry->setColorBinding(osg::Geometry::BIND_OVERALL);
+    SectorKey key = { m_azimuthStart, m_azimuthEnd, m_elevationStart, m_elevationEnd,
+                      azimuthStep, elevationStep };
 
-    // Create triangles
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_TRIANGLES);
-    
-    int numAziSteps = static_cast<int>((m_azimuthEnd - m_azimuthStart) / azimuthStep) + 1;
-    int numEleSteps = static_cast<int>((m_elevationEnd - m_elevationStart) / elevationStep) + 1;
+    QMutexLocker lock(&s_meshMutex);
 
-    // Create triangles for the sector surface
-    for (int i = 0; i < numAziSteps - 1; ++i) {
-        for (int j = 0; j < numEleSteps - 1; ++j) {
-            int idx0 = i * numEleSteps + j;
-            int idx1 = idx0 + 1;
-            int idx2 = (i + 1) * numEleSteps + j;
-            int idx3 = idx2 + 1;
+    // Shared unit mesh - generated once per configuration
+    osg::ref_ptr<osg::Vec3Array>& vertices = s_sectorVertices[key];
+    if (!vertices.valid()) {
+        vertices = new osg::Vec3Array();
+        createVertices(vertices.get(), azimuthStep, elevationStep);
+        s_sectorKeys.insert(vertices.get(), key);
+    }
 
-            // Triangle 1
-            indices->push_back(idx0);
-            indices->push_back(idx1);
-            indices->push_back(idx2);
+    // The cache keeps the previous mesh alive until it is released
+    const osg::Array* previous = m_geometry->getVertexArray();
+    m_geometry->setVertexArray(vertices.get());
+    if (previous && previous != vertices.get()) {
+        releaseSectorVertices(previous);
+    }
 
-            // Triangle 2
-            indices->push_back(idx1);
-            indices->push_back(idx3);
-            indices->push_back(idx2);
-        }
+    osg::DrawElements* indices = sectorIndices(numAziSteps, numEleSteps, azimuthSides, topCap);
+    if (m_geometry->getNumPrimitiveSets() == 0) {
+        m_geometry->addPrimitiveSet(indices);
+    } else {
+        m_geometry->setPrimitiveSet(0, indices);
     }
 
-    m_geometry->removePrimitiveSet(0, m_geometry->getNumPrimitiveSets());
-    m_geometry->addPrimitiveSet(indices.get());
+    m_geometry->dirtyBound();
 }
 
 void SensorVolume::createVertices(osg::Vec3Array* vertices, 
                                  int azimuthStep, 
                                  int elevationStep)
 {
-    vertices->clear();
-
-    // Origin point
-    osg::Vec3 origin(0, 0, 0);
+    const int numAzi = stepCount(m_azimuthStart, m_azimuthEnd, azimuthStep);
+    const int numEle = stepCount(m_elevationStart, m_elevationEnd, elevationStep);
 
-    // Generate vertices for the sector
-    for (double azi = m_azimuthStart; azi <= m_azimuthEnd; azi += azimuthStep) {
-        for (double ele = m_elevationStart; ele <= m_elevationEnd; ele += elevationStep) {
-            // Convert spherical to Cartesian coordinates
-            double aziRad = osg::DegreesToRadians(azi);
-            double eleRad = osg::DegreesToRadians(ele);
+    // Per-step trig tables: numAzi + numEle sin/cos pairs instead of four
+    // libm calls per vertex. Step angles are computed from integer counters
+    // so no error accumulates along the sweep.
+    QVarLengthArray<osg::Vec2d, 64> aziTrig(numAzi);    // (sin, cos)
+    QVarLengthArray<osg::Vec2d, 64> eleTrig(numEle);
+    for (int i = 0; i < numAzi; ++i) {
+        double rad = osg::DegreesToRadians(m_azimuthStart + i * azimuthStep);
+        aziTrig[i].set(sin(rad), cos(rad));
+    }
+    for (int j = 0; j < numEle; ++j) {
+        double rad = osg::DegreesToRadians(m_elevationStart + j * elevationStep);
+        eleTrig[j].set(sin(rad), cos(rad));
+    }
 
-            double x = m_radius * cos(eleRad) * sin(aziRad);
-            double y = m_radius * cos(eleRad) * cos(aziRad);
-            double z = m_radius * sin(eleRad);
+    // Size once and write straight into the array; the apex closing the
+    // sector goes last
+    vertices->resize(numAzi * numEle + 1);
+    osg::Vec3* out = &vertices->front();
 
-            vertices->push_back(osg::Vec3(x, y, z));
+    // Unit radius - m_scaleTransform applies m_radius
+    for (int i = 0; i < numAzi; ++i) {
+        const float sinAzi = static_cast<float>(aziTrig[i].x());
+        const float cosAzi = static_cast<float>(aziTrig[i].y());
+        for (int j = 0; j < numEle; ++j) {
+            const float sinEle = static_cast<float>(eleTrig[j].x());
+            const float cosEle = static_cast<float>(eleTrig[j].y());
+            *out++ = osg::Vec3(cosEle * sinAzi, cosEle * cosAzi, sinEle);
         }
     }
+    *out = osg::Vec3(0.0f, 0.0f, 0.0f);
 }
@@ -1,12 +1,81 @@
 #include "trackline.h"
+#include "PerfInstrumentation.h"
+#include "OverlayRenderBin.h"
 #include <osg/PrimitiveSet>
 #include <osg/StateSet>
-#include <osg/BlendFunc>
-#include <osg/Depth>
 #include <osg/Shader>
+#include <osg/Vec2f>
 #include <osgDB/ReadFile>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
 #include <cmath>
 
+namespace {
+
+const int RING_SEGMENTS = 16; // Circle segments around the track line
+
+/**
+ * Unit circle shared by every layer of every track line, computed once
+ * (RING_SEGMENTS + 1 entries, the last one closes the ring)
+ */
+const osg::Vec2f* unitRing()
+{
+    struct RingTable {
+        osg::Vec2f points[RING_SEGMENTS + 1];
+        RingTable() {
+            const double angleStep = 2.0 * osg::PI / RING_SEGMENTS;
+            for (int seg = 0; seg <= RING_SEGMENTS; ++seg) {
+                double angle = seg * angleStep;
+                points[seg].set(cos(angle), sin(angle));
+            }
+        }
+    };
+    static const RingTable table;
+    return table.points;
+}
+
+// Unit cylinders are identical for every track line with the same layer
+// count, so vertex and index buffers are shared per LOD configuration
+struct CylinderMesh {
+    osg::ref_ptr<osg::Vec3Array> vertices;
+    osg::ref_ptr<osg::DrawElements> indices;
+};
+
+QMutex s_meshMutex;
+QMap<int, CylinderMesh> s_cylinderMeshes;
+
+/**
+ * Two triangles per ring segment between consecutive layers; vertex
+ * (layer, seg) is layer * (RING_SEGMENTS + 1) + seg. Emitted layer by layer
+ * so each band reuses the previous ring from the post-transform cache.
+ */
+template <class DrawElementsT>
+void emitCylinderIndices(DrawElementsT* indices, int layers)
+{
+    const int ringSize = RING_SEGMENTS + 1;
+    indices->reserve(layers * RING_SEGMENTS * 6);
+
+    for (int layer = 0; layer < layers; ++layer) {
+        for (int seg = 0; seg < RING_SEGMENTS; ++seg) {
+            int a = layer * ringSize + seg;
+            int b = a + 1;
+            int c = a + ringSize;
+            int d = c + 1;
+
+            indices->push_back(a);
+            indices->push_back(c);
+            indices->push_back(b);
+
+            indices->push_back(b);
+            indices->push_back(c);
+            indices->push_back(d);
+        }
+    }
+}
+
+} // namespace
+
 TrackLine::TrackLine(
     double length,
     double radius,
@@ -27,21 +96,22 @@ TrackLine::TrackLine(
     m_geometry = new osg::Geometry();
     m_geode->addDrawable(m_geometry.get());
 
-    // Setup rendering state for transparency
-    osg::StateSet* ss = m_geode->getOrCreateStateSet();
-    ss->setMode(GL_BLEND, osg::StateAttribute::ON);
-    ss->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
-    ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
-    
-    osg::BlendFunc* bf = new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    ss->setAttributeAndModes(bf, osg::StateAttribute::ON);
-    
-    osg::Depth* depth = new osg::Depth();
-    depth->setWriteMask(false);
-    ss->setAttributeAndModes(depth, osg::StateAttribute::ON);
+    // VBOs so rebuilds upload with sub-data instead of recompiling a
+    // display list
+    m_geometry->setUseDisplayList(false);
+    m_geometry->setUseVertexBufferObjects(true);
+
+    m_colors = new osg::Vec4Array();
+    m_colors->push_back(m_color);
+    m_geometry->setColorArray(m_colors.get(), osg::Array::BIND_OVERALL);
+
+    // Overlay bin with the shared blend/depth attributes; the state set
+    // itself stays per instance for the width/speed/scale uniforms
+    OverlayRenderBin::applyOverlayState(m_geode->getOrCreateStateSet());
 
     // Setup shader for pulse animation
     setupShader();
+    updateScale();
 
     // Build initial geometry
     rebuildGeometry();
@@ -91,24 +161,40 @@ void TrackLine::setVisible(bool visible)
 
 void TrackLine::setLength(double length)
 {
-    if (std::abs(m_length - length) > 1.0) {
+    if (m_length != length) {
         m_length = length;
-        rebuildGeometry();
+        updateScale();
     }
 }
 
 void TrackLine::setRadius(double radius)
 {
-    if (std::abs(m_radius - radius) > 0.1) {
+    if (m_radius != radius) {
         m_radius = radius;
-        rebuildGeometry();
+        updateScale();
     }
 }
 
+void TrackLine::updateScale()
+{
+    m_scaleUniform->set(osg::Vec3(m_radius, m_radius, m_length));
+
+    // The drawable only sees the unit cylinder; give culling the real extent
+    m_geometry->setInitialBound(osg::BoundingBox(
+        -m_radius, -m_radius, 0.0, m_radius, m_radius, m_length));
+    m_geometry->dirtyBound();
+}
+
 void TrackLine::setColor(const osg::Vec4& color)
 {
+    if (m_color == color) {
+        return;
+    }
+
+    // BIND_OVERALL - one element, no vertex regeneration
     m_color = color;
-    rebuildGeometry();
+    (*m_colors)[0] = color;
+    m_colors->dirty();
 }
 
 void TrackLine::setLayers(int layers)
@@ -126,11 +212,18 @@ void TrackLine::setPulseTime(float time)
     }
 }
 
-void TrackLine::setupShader()
+osg::Program* TrackLine::sharedProgram()
 {
-    // Create shader program
-    m_program = new osg::Program();
-    
+    // One program for all track lines: shader files are read once and the
+    // overlay bin sees a single program instead of one per track
+    static osg::ref_ptr<osg::Program> program = createProgram();
+    return program.get();
+}
+
+osg::Program* TrackLine::createProgram()
+{
+    osg::Program* program = new osg::Program();
+
     // Try to load shader files, if they don't exist, use fallback
     osg::Shader* vertShader = osgDB::readShaderFile(osg::Shader::VERTEX, 
         "./resource/osgEarth/trackline_pulse.vert");
@@ -143,10 +236,12 @@ void TrackLine::setupShader()
         vertShader->setShaderSource(
             "#version 120\n"
             "uniform float pulseTime;\n"
+            "uniform vec3 trackScale;\n"
             "varying float vHeight;\n"
             "void main() {\n"
-            "    vHeight = gl_Vertex.z;\n"
-            "    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+            "    vec4 vertex = vec4(gl_Vertex.xyz * trackScale, 1.0);\n"
+            "    vHeight = vertex.z;\n"
+            "    gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
             "    gl_FrontColor = gl_Color;\n"
             "}\n"
         );
@@ -170,59 +265,77 @@ void TrackLine::setupShader()
         );
     }
     
-    m_program->addShader(vertShader);
-    m_program->addShader(fragShader);
-    
-    // Create uniforms
+    program->addShader(vertShader);
+    program->addShader(fragShader);
+    return program;
+}
+
+void TrackLine::setupShader()
+{
+    // Per-instance uniforms, program shared
     m_pulseTimeUniform = new osg::Uniform("pulseTime", 0.0f);
     m_widthUniform = new osg::Uniform("width", static_cast<float>(m_width));
     m_speedUniform = new osg::Uniform("speed", static_cast<float>(m_speed));
+    m_scaleUniform = new osg::Uniform("trackScale", osg::Vec3(1.0f, 1.0f, 1.0f));
     
     // Apply to state set
     osg::StateSet* ss = m_geode->getOrCreateStateSet();
-    ss->setAttributeAndModes(m_program.get(), osg::StateAttribute::ON);
+    ss->setAttributeAndModes(sharedProgram(), osg::StateAttribute::ON);
     ss->addUniform(m_pulseTimeUniform.get());
     ss->addUniform(m_widthUniform.get());
     ss->addUniform(m_speedUniform.get());
+    ss->addUniform(m_scaleUniform.get());
 }
 
 void TrackLine::rebuildGeometry()
 {
-    // Create vertices
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
-    createVertices(vertices.get(), m_layers);
+    ENTITY_TRACE_SCOPE("geometry", "TrackLine::rebuildGeometry");
+    PERF_COUNT(COUNTER_GEOMETRIES_REBUILT, 1);
 
-    m_geometry->setVertexArray(vertices.get());
+    QMutexLocker lock(&s_meshMutex);
 
-    // Create colors (all vertices same color)
-    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array();
-    colors->push_back(m_color);
-    m_geometry->setColorArray(colors.get());
-    m_geometry->setColorBinding(osg::Geometry::BIND_OVERALL);
+    // Shared unit cylinder - generated once per layer count
+    CylinderMesh& mesh = s_cylinderMeshes[m_layers];
+    if (!mesh.vertices.valid()) {
+        mesh.vertices = new osg::Vec3Array();
+        createVertices(mesh.vertices.get(), m_layers);
 
-    // Create triangle strip for the cylinder
-    m_geometry->removePrimitiveSet(0, m_geometry->getNumPrimitiveSets());
-    m_geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLE_STRIP, 0, vertices->size()));
+        // 16-bit indices unless the layer count needs more
+        if (mesh.vertices->size() <= 0xFFFF) {
+            osg::DrawElementsUShort* indices = new osg::DrawElementsUShort(GL_TRIANGLES);
+            emitCylinderIndices(indices, m_layers);
+            mesh.indices = indices;
+        } else {
+            osg::DrawElementsUInt* indices = new osg::DrawElementsUInt(GL_TRIANGLES);
+            emitCylinderIndices(indices, m_layers);
+            mesh.indices = indices;
+        }
+    }
+
+    m_geometry->setVertexArray(mesh.vertices.get());
+    if (m_geometry->getNumPrimitiveSets() == 0) {
+        m_geometry->addPrimitiveSet(mesh.indices.get());
+    } else {
+        m_geometry->setPrimitiveSet(0, mesh.indices.get());
+    }
+    m_geometry->dirtyBound();
 }
 
 void TrackLine::createVertices(osg::Vec3Array* vertices, int layers)
 {
-    vertices->clear();
+    const osg::Vec2f* ring = unitRing();
+    const float layerStep = 1.0f / layers;
 
-    const int segments = 16; // Circle segments around the track line
-    const double angleStep = 2.0 * osg::PI / segments;
-    const double layerStep = m_length / layers;
+    // Size once and write straight into the array (keeps its capacity)
+    vertices->resize((layers + 1) * (RING_SEGMENTS + 1));
+    osg::Vec3* out = &vertices->front();
 
-    // Create cylindrical track line vertices
+    // Create unit cylindrical track line vertices (the shader applies
+    // radius and length through trackScale)
     for (int layer = 0; layer <= layers; ++layer) {
-        double z = layer * layerStep;
-        
-        for (int seg = 0; seg <= segments; ++seg) {
-            double angle = seg * angleStep;
-            double x = m_radius * cos(angle);
-            double y = m_radius * sin(angle);
-            
-            vertices->push_back(osg::Vec3(x, y, z));
+        const float z = layer * layerStep;
+        for (int seg = 0; seg <= RING_SEGMENTS; ++seg) {
+            *out++ = osg::Vec3(ring[seg].x(), ring[seg].y(), z);
         }
     }
 }